@@ -580,6 +580,13 @@ extern DECLSPEC void SDLCALL SDL_FreeSurface(SDL_Surface *surface);
 extern DECLSPEC int SDLCALL SDL_LockSurface(SDL_Surface *surface);
 extern DECLSPEC void SDLCALL SDL_UnlockSurface(SDL_Surface *surface);
 
+/**
+ * SDL_LockSurfaceReadOnly() is like SDL_LockSurface(), but promises that
+ * the pixels won't be written to, so an RLE accelerated surface keeps its
+ * encoding.  Release it with SDL_UnlockSurface().
+ */
+extern DECLSPEC int SDLCALL SDL_LockSurfaceReadOnly(SDL_Surface *surface);
+
 /**
  * Load a surface from a seekable SDL data source (memory or file.)
  * If 'freesrc' is non-zero, the source will be closed after being read.
@@ -632,6 +639,18 @@ extern DECLSPEC int SDLCALL SDL_SetColorKey
  */
 extern DECLSPEC int SDLCALL SDL_SetAlpha(SDL_Surface *surface, Uint32 flag, Uint8 alpha);
 
+/**
+ * RLE accelerated surfaces are encoded the first time they are blitted
+ * to a destination of a new format.  SDL_PrepareRLE() does this ahead
+ * of time for blits of 'surface' to 'dst', so the first blit doesn't
+ * stall.  If SDL_VIDEO_RLE_THREAD is set, the encoding is made in the
+ * background and this returns at once.
+ *
+ * Returns 0 if successful, or -1 if the surface can't be RLE accelerated
+ * for that destination.
+ */
+extern DECLSPEC int SDLCALL SDL_PrepareRLE(SDL_Surface *surface, SDL_Surface *dst);
+
 /**
  * Sets the clipping rectangle for the destination surface in a blit.
  *
@@ -767,6 +786,16 @@ extern DECLSPEC int SDLCALL SDL_LowerBlit
 extern DECLSPEC int SDLCALL SDL_FillRect
 		(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color);
 
+/**
+ * This function fills each of the given rectangles with 'color', as
+ * SDL_FillRect() would, but locks the surface only once for all of them.
+ * Each rectangle is clipped in place, and is left empty if it falls
+ * outside of the clip area.
+ * This function returns 0 on success, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_FillRects
+		(SDL_Surface *dst, int numrects, SDL_Rect *rects, Uint32 color);
+
 /**
  * This function takes a surface and copies it to a new surface of the
  * pixel format and colors of the video framebuffer, suitable for fast
@@ -941,6 +970,25 @@ extern DECLSPEC SDL_GrabMode SDLCALL SDL_WM_GrabInput(SDL_GrabMode mode);
 /** @internal Not in public API at the moment - do not use! */
 extern DECLSPEC int SDLCALL SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
                                     SDL_Surface *dst, SDL_Rect *dstrect);
+
+/** @internal Filters for SDL_SoftStretchFiltered() */
+typedef enum {
+	SDL_STRETCH_NEAREST,	/**< Pick the closest source pixel */
+	SDL_STRETCH_BILINEAR,	/**< Blend the four nearest source pixels */
+	SDL_STRETCH_AREA	/**< Average the covered source area */
+} SDL_StretchFilter;
+
+/**
+ * @internal Not in public API at the moment - do not use!
+ *
+ * Like SDL_SoftStretch(), but with a choice of filter.  The surfaces may
+ * be in different 15, 16, 24 or 32 bpp formats; 8 bpp surfaces must match
+ * and are always stretched with SDL_STRETCH_NEAREST.
+ */
+extern DECLSPEC int SDLCALL SDL_SoftStretchFiltered(SDL_Surface *src,
+                                    SDL_Rect *srcrect,
+                                    SDL_Surface *dst, SDL_Rect *dstrect,
+                                    SDL_StretchFilter filter);
                     
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
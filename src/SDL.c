@@ -42,6 +42,15 @@ extern void SDL_JoystickQuit(void);
 extern int  SDL_CDROMInit(void);
 extern void SDL_CDROMQuit(void);
 #endif
+#if !SDL_VIDEO_DISABLED
+extern void SDL_InitBlitThreads(void);
+extern void SDL_QuitBlitThreads(void);
+extern void SDL_InitRLEThread(void);
+extern void SDL_QuitRLEThread(void);
+extern void SDL_InitPaletteMaps(void);
+extern void SDL_QuitPaletteMaps(void);
+#endif
+extern void SDL_QuitResampler(void);
 #if !SDL_TIMERS_DISABLED
 extern void SDL_StartTicks(void);
 extern int  SDL_TimerInit(void);
@@ -84,6 +93,11 @@ int SDL_InitSubSystem(Uint32 flags)
 #endif
 
 #if !SDL_VIDEO_DISABLED
+	/* Set up software blitting, which doesn't need video either */
+	SDL_InitBlitThreads();
+	SDL_InitRLEThread();
+	SDL_InitPaletteMaps();
+
 	/* Initialize the video/event subsystem */
 	if ( (flags & SDL_INIT_VIDEO) && !(SDL_initialized & SDL_INIT_VIDEO) ) {
 		if ( SDL_VideoInit(SDL_getenv("SDL_VIDEODRIVER"),
@@ -221,6 +235,15 @@ void SDL_Quit(void)
 #endif
 	SDL_QuitSubSystem(SDL_INIT_EVERYTHING);
 
+#if !SDL_VIDEO_DISABLED
+	/* Software blits can run without the video subsystem */
+	SDL_QuitBlitThreads();
+	SDL_QuitRLEThread();
+	SDL_QuitPaletteMaps();
+#endif
+	/* Audio can be converted without the audio subsystem */
+	SDL_QuitResampler();
+
 #ifdef CHECK_LEAKS
 #ifdef DEBUG_BUILD
   printf("[SDL_Quit] : CHECK_LEAKS\n"); fflush(stdout);
@@ -127,6 +127,7 @@ int SDLCALL SDL_RunAudio(void *audiop)
 	SDL_AudioDevice *audio = (SDL_AudioDevice *)audiop;
 	Uint8 *stream;
 	int    stream_len;
+	int    paused, convert;
 	void  *udata;
 	void (SDLCALL *fill)(void *userdata,Uint8 *stream, int len);
 	int    silence;
@@ -148,6 +149,9 @@ int SDLCALL SDL_RunAudio(void *audiop)
 			silence = 0;
 		}
 		stream_len = audio->convert.len;
+
+		/* Carry the resampling on from one buffer to the next */
+		SDL_StartResampleStream(&audio->convert);
 	} else {
 		silence = audio->spec.silence;
 		stream_len = audio->spec.size;
@@ -177,37 +181,54 @@ int SDLCALL SDL_RunAudio(void *audiop)
 	/* Loop, filling the audio buffers */
 	while ( audio->enabled ) {
 
+		/* Silence needn't be converted, and a paused resampler
+		   goes on where it stopped */
+		paused = audio->paused;
+		convert = audio->convert.needed && ! paused;
+
 		/* Fill the current buffer with sound */
-		if ( audio->convert.needed ) {
+		if ( convert ) {
 			if ( audio->convert.buf ) {
 				stream = audio->convert.buf;
 			} else {
 				continue;
 			}
+			SDL_memset(stream, silence, stream_len);
 		} else {
 			stream = audio->GetAudioBuf(audio);
 			if ( stream == NULL ) {
 				stream = audio->fake_stream;
 			}
+			SDL_memset(stream, audio->spec.silence, audio->spec.size);
 		}
 
-		SDL_memset(stream, silence, stream_len);
-
-		if ( ! audio->paused ) {
+		if ( ! paused ) {
 			SDL_mutexP(audio->mixer_lock);
 			(*fill)(udata, stream, stream_len);
 			SDL_mutexV(audio->mixer_lock);
 		}
 
 		/* Convert the audio if necessary */
-		if ( audio->convert.needed ) {
+		if ( convert ) {
 			SDL_ConvertAudio(&audio->convert);
+
+			/* Resampling comes out at a little more or less
+			   than a buffer, so play whole buffers as they fill */
+			SDL_memcpy(audio->converted + audio->converted_len,
+			           audio->convert.buf, audio->convert.len_cvt);
+			audio->converted_len += audio->convert.len_cvt;
+			if ( audio->converted_len < audio->spec.size ) {
+				continue;
+			}
 			stream = audio->GetAudioBuf(audio);
 			if ( stream == NULL ) {
 				stream = audio->fake_stream;
 			}
-			SDL_memcpy(stream, audio->convert.buf,
-			               audio->convert.len_cvt);
+			SDL_memcpy(stream, audio->converted, audio->spec.size);
+			audio->converted_len -= audio->spec.size;
+			SDL_memmove(audio->converted,
+			            audio->converted + audio->spec.size,
+			            audio->converted_len);
 		}
 
 		/* Ready current buffer for play and change current buffer */
@@ -227,6 +248,7 @@ int SDLCALL SDL_RunAudio(void *audiop)
 	if ( audio->WaitDone ) {
 		audio->WaitDone(audio);
 	}
+	SDL_StopResampleStream(&audio->convert);
 
 #ifdef __OS2__
 #ifdef DEBUG_BUILD
@@ -306,6 +328,9 @@ int SDL_AudioInit(const char *driver_name)
 	if ( current_audio != NULL ) {
 		SDL_AudioQuit();
 	}
+	if ( SDL_InitResampler() < 0 ) {
+		return(-1);
+	}
 
 	/* Select the proper audio driver */
 	audio = NULL;
@@ -532,8 +557,13 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 			return(-1);
 		}
 		if ( audio->convert.needed ) {
+			int frame = ((desired->format & 0xFF) / 8) *
+			            desired->channels;
+
 			audio->convert.len = (int) ( ((double) audio->spec.size) /
                                           audio->convert.len_ratio );
+			/* Resampling by an odd ratio needs whole frames */
+			audio->convert.len -= audio->convert.len % frame;
 			audio->convert.buf =(Uint8 *)SDL_AllocAudioMem(
 			   audio->convert.len*audio->convert.len_mult);
 			if ( audio->convert.buf == NULL ) {
@@ -541,6 +571,16 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 				SDL_OutOfMemory();
 				return(-1);
 			}
+			/* Room for up to a buffer to wait, and another
+			   converted buffer after it */
+			audio->converted = (Uint8 *)SDL_malloc(audio->spec.size +
+			   audio->convert.len*audio->convert.len_mult);
+			if ( audio->converted == NULL ) {
+				SDL_CloseAudio();
+				SDL_OutOfMemory();
+				return(-1);
+			}
+			audio->converted_len = 0;
 		}
 	}
 
@@ -638,6 +678,9 @@ void SDL_AudioQuit(void)
 			SDL_FreeAudioMem(audio->convert.buf);
 
 		}
+		if ( audio->converted != NULL ) {
+			SDL_free(audio->converted);
+		}
 		if ( audio->opened ) {
 			audio->CloseAudio(audio);
 			audio->opened = 0;
@@ -646,6 +689,7 @@ void SDL_AudioQuit(void)
 		audio->free(audio);
 		current_audio = NULL;
 	}
+	SDL_QuitResampler();
 }
 
 #define NUM_FORMATS	6
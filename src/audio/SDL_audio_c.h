@@ -33,3 +33,11 @@ extern void SDL_CalculateAudioSpec(SDL_AudioSpec *spec);
 /* The actual mixing thread function */
 extern int SDLCALL SDL_RunAudio(void *audiop);
 
+/* Set up and free the resampler filter banks, in SDL_audiocvt.c */
+extern int SDL_InitResampler(void);
+extern void SDL_QuitResampler(void);
+
+/* Resample the buffers of a conversion as one stream, in SDL_audiocvt.c */
+extern void SDL_StartResampleStream(SDL_AudioCVT *cvt);
+extern void SDL_StopResampleStream(SDL_AudioCVT *cvt);
+
@@ -24,6 +24,15 @@
 /* Functions for audio drivers to perform runtime conversion of audio format */
 
 #include "SDL_audio.h"
+#include "SDL_endian.h"
+#include "SDL_mutex.h"
+#include "SDL_audio_c.h"
+
+#if SDL_ASSEMBLY_ROUTINES && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__SSE__))
+#define SSE_RESAMPLE 1
+#include <xmmintrin.h>
+#endif
 
 
 /* Effectively mix right and left channels into a single channel */
@@ -1225,81 +1234,637 @@ void SDLCALL SDL_RateDIV2_c6(SDL_AudioCVT *cvt, Uint16 format)
 	}
 }
 
-/* Very slow rate conversion routine */
-void SDLCALL SDL_RateSLOW(SDL_AudioCVT *cvt, Uint16 format)
+/*
+ * Resampling by any ratio with a polyphase windowed sinc filter.
+ *
+ * For a conversion from M input frames to L output frames, output frame
+ * j falls on the input at j*M/L.  Its integer part picks the input
+ * frames under the filter and its fraction picks a row of the filter
+ * bank, each row being the sinc filter shifted by one of 'phases'
+ * fractions of a frame.  If the ratio needs more phases than the bank
+ * has, the results of the two nearest rows are interpolated.
+ *
+ * The banks are built for each ratio and quality by SDL_BuildAudioCVT
+ * (or again by a conversion that outlived them) and kept until
+ * SDL_AudioQuit() or SDL_Quit(), found by the rate_incr of the
+ * conversion (M/L rounded to a double, which is the same for any pair
+ * of rates with that ratio).  A conversion runs on the whole buffer, so
+ * the frames before and after it are taken to be copies of the first
+ * and last frames.
+ *
+ * The audio thread converts a stream of buffers instead, and starts a
+ * stream for its conversion that keeps the end of each buffer and the
+ * position in it for the next.  Only the frames with the whole filter
+ * inside the input so far are put out, half a filter behind, so the
+ * buffers resample the same as one long buffer would.
+ */
+#define RESAMPLE_LOW		0
+#define RESAMPLE_MEDIUM		1
+#define RESAMPLE_HIGH		2
+#define RESAMPLE_QUALITIES	3
+
+static const struct {
+	int taps;		/* filter length at the input rate */
+	int phases;		/* most rows in a bank */
+	double cutoff;		/* passband as a fraction of Nyquist */
+} resample_quality[RESAMPLE_QUALITIES] = {
+	{ 16, 64, 0.80 },
+	{ 64, 256, 0.90 },
+	{ 128, 1024, 0.95 }
+};
+
+typedef struct SDL_ResampleBank {
+	struct SDL_ResampleBank *next;
+	double incr;		/* M/L, the cvt->rate_incr */
+	int quality;
+	int L, M;		/* output and input frames, in lowest terms */
+	int phases;
+	int taps;		/* coefficients in a row, a multiple of 4 */
+	float *coefs;		/* phases+1 rows */
+} SDL_ResampleBank;
+
+/* What a stream keeps from one buffer to the next */
+typedef struct SDL_ResampleStream {
+	struct SDL_ResampleStream *next;
+	SDL_AudioCVT *cvt;
+	int started;
+	float *planes;		/* a plane of 'stride' floats for each channel */
+	int stride;
+	int frames;		/* input frames kept in the planes */
+	int pos, frac;		/* the next output position in the planes */
+} SDL_ResampleStream;
+
+static SDL_ResampleBank *resample_banks = NULL;
+static SDL_ResampleStream *resample_streams = NULL;
+static SDL_mutex *resample_lock = NULL;
+
+/* Called by SDL_AudioInit(), before the audio thread can look up banks */
+int SDL_InitResampler(void)
 {
-	double ipos;
-	int i, clen;
-
-#ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate * %4.4f\n", 1.0/cvt->rate_incr);
+#if !SDL_THREADS_DISABLED
+	if ( resample_lock == NULL ) {
+		resample_lock = SDL_CreateMutex();
+		if ( resample_lock == NULL ) {
+			return(-1);
+		}
+	}
 #endif
-	clen = (int)((double)cvt->len_cvt / cvt->rate_incr);
-	if ( cvt->rate_incr > 1.0 ) {
-		switch (format & 0xFF) {
-			case 8: {
-				Uint8 *output;
-
-				output = cvt->buf;
-				ipos = 0.0;
-				for ( i=clen; i; --i ) {
-					*output = cvt->buf[(int)ipos];
-					ipos += cvt->rate_incr;
-					output += 1;
-				}
-			}
+	return(0);
+}
+
+/* Called by SDL_AudioQuit(), once the audio thread is gone, and by
+   SDL_Quit() for the banks of conversions built without audio */
+void SDL_QuitResampler(void)
+{
+	SDL_ResampleBank *bank;
+	SDL_ResampleStream *stream;
+
+	while ( resample_streams ) {
+		stream = resample_streams;
+		resample_streams = stream->next;
+		SDL_free(stream->planes);
+		SDL_free(stream);
+	}
+	while ( resample_banks ) {
+		bank = resample_banks;
+		resample_banks = bank->next;
+		SDL_free(bank->coefs);
+		SDL_free(bank);
+	}
+	if ( resample_lock != NULL ) {
+		SDL_DestroyMutex(resample_lock);
+		resample_lock = NULL;
+	}
+}
+
+/* Conversions can be built without the audio subsystem, and then there's
+   no lock, but no audio thread either */
+static void SDL_LockResampler(void)
+{
+	if ( resample_lock != NULL ) {
+		SDL_mutexP(resample_lock);
+	}
+}
+
+static void SDL_UnlockResampler(void)
+{
+	if ( resample_lock != NULL ) {
+		SDL_mutexV(resample_lock);
+	}
+}
+
+/* The C library may not be there, and a series is plenty for this */
+static double ResampleSin(double x)
+{
+	const double pi = 3.14159265358979323846;
+	double term, sum, x2;
+	int i;
+
+	x -= 2.0*pi * (int)(x / (2.0*pi));
+	if ( x > pi ) {
+		x -= 2.0*pi;
+	} else if ( x < -pi ) {
+		x += 2.0*pi;
+	}
+	x2 = x * x;
+	term = sum = x;
+	for ( i = 3; i < 30; i += 2 ) {
+		term *= -x2 / (i * (i-1));
+		sum += term;
+	}
+	return sum;
+}
+
+/* The filter tap at 'x' input frames from the output position */
+static double ResampleTap(double x, double cutoff, double half)
+{
+	const double pi = 3.14159265358979323846;
+	double t, sinc, window;
+
+	if ( x <= -half || x >= half ) {
+		return 0.0;
+	}
+	/* Blackman-Harris window */
+	t = pi * (x + half) / half;
+	window = 0.35875 - 0.48829 * ResampleSin(t + pi/2)
+	                 + 0.14128 * ResampleSin(2*t + pi/2)
+	                 - 0.01168 * ResampleSin(3*t + pi/2);
+	t = pi * cutoff * x;
+	sinc = (t == 0.0) ? 1.0 : ResampleSin(t) / t;
+	return cutoff * sinc * window;
+}
+
+static SDL_ResampleBank *SDL_CreateResampleBank(int src_rate, int dst_rate,
+                                                int quality)
+{
+	SDL_ResampleBank *bank;
+	int a, b, t;
+	int phase, k;
+	double cutoff, half, sum;
+	float *row;
+
+	bank = (SDL_ResampleBank *)SDL_malloc(sizeof(*bank));
+	if ( bank == NULL ) {
+		return(NULL);
+	}
+	a = src_rate;
+	b = dst_rate;
+	while ( b ) {
+		t = a % b;
+		a = b;
+		b = t;
+	}
+	bank->incr = (double)src_rate / dst_rate;
+	bank->quality = quality;
+	bank->L = dst_rate / a;
+	bank->M = src_rate / a;
+	bank->phases = resample_quality[quality].phases;
+	if ( bank->L < bank->phases ) {
+		bank->phases = bank->L;
+	}
+
+	/* Downsampling needs a lower cutoff, so a longer filter */
+	cutoff = resample_quality[quality].cutoff;
+	half = resample_quality[quality].taps / 2;
+	if ( bank->M > bank->L ) {
+		cutoff = cutoff * bank->L / bank->M;
+		half = half * bank->M / bank->L;
+	}
+	bank->taps = ((int)half * 2 + 3) & ~3;
+
+	bank->coefs = (float *)SDL_malloc(
+		(bank->phases + 1) * bank->taps * sizeof(float));
+	if ( bank->coefs == NULL ) {
+		SDL_free(bank);
+		return(NULL);
+	}
+	/* Tap k is for input frame pos - taps/2 + 1 + k */
+	for ( phase = 0; phase <= bank->phases; ++phase ) {
+		double frac = (double)phase / bank->phases;
+
+		row = bank->coefs + phase * bank->taps;
+		sum = 0.0;
+		for ( k = 0; k < bank->taps; ++k ) {
+			double x = (k - bank->taps/2 + 1) - frac;
+			sum += ResampleTap(x, cutoff, half);
+		}
+		for ( k = 0; k < bank->taps; ++k ) {
+			double x = (k - bank->taps/2 + 1) - frac;
+			row[k] = (float)(ResampleTap(x, cutoff, half) / sum);
+		}
+	}
+	return(bank);
+}
+
+static SDL_ResampleBank *SDL_FindResampleBank(double incr, int quality)
+{
+	SDL_ResampleBank *bank;
+
+	SDL_LockResampler();
+	for ( bank = resample_banks; bank; bank = bank->next ) {
+		if ( bank->incr == incr && bank->quality == quality ) {
 			break;
+		}
+	}
+	SDL_UnlockResampler();
+	return(bank);
+}
 
-			case 16: {
-				Uint16 *output;
+/* Make sure there's a bank for a conversion, returning 0 if not */
+static int SDL_AddResampleBank(int src_rate, int dst_rate, int quality)
+{
+	SDL_ResampleBank *bank;
 
-				clen &= ~1;
-				output = (Uint16 *)cvt->buf;
-				ipos = 0.0;
-				for ( i=clen/2; i; --i ) {
-					*output=((Uint16 *)cvt->buf)[(int)ipos];
-					ipos += cvt->rate_incr;
-					output += 1;
-				}
+	if ( SDL_FindResampleBank((double)src_rate / dst_rate, quality) ) {
+		return(1);
+	}
+	bank = SDL_CreateResampleBank(src_rate, dst_rate, quality);
+	if ( bank == NULL ) {
+		SDL_OutOfMemory();
+		return(0);
+	}
+	SDL_LockResampler();
+	bank->next = resample_banks;
+	resample_banks = bank;
+	SDL_UnlockResampler();
+	return(1);
+}
+
+/* Resample each buffer converted by 'cvt' as the continuation of the
+   last one, until SDL_StopResampleStream().  If there's no memory for
+   it, the buffers are resampled one at a time. */
+void SDL_StartResampleStream(SDL_AudioCVT *cvt)
+{
+	SDL_ResampleStream *stream;
+
+	if ( cvt->rate_incr == 0.0 ) {
+		return;
+	}
+	stream = (SDL_ResampleStream *)SDL_malloc(sizeof(*stream));
+	if ( stream == NULL ) {
+		return;
+	}
+	SDL_memset(stream, 0, sizeof(*stream));
+	stream->cvt = cvt;
+	SDL_LockResampler();
+	stream->next = resample_streams;
+	resample_streams = stream;
+	SDL_UnlockResampler();
+}
+
+void SDL_StopResampleStream(SDL_AudioCVT *cvt)
+{
+	SDL_ResampleStream *stream, *prev;
+
+	SDL_LockResampler();
+	prev = NULL;
+	for ( stream = resample_streams; stream; stream = stream->next ) {
+		if ( stream->cvt == cvt ) {
+			if ( prev ) {
+				prev->next = stream->next;
+			} else {
+				resample_streams = stream->next;
 			}
 			break;
 		}
+		prev = stream;
+	}
+	SDL_UnlockResampler();
+	if ( stream ) {
+		SDL_free(stream->planes);
+		SDL_free(stream);
+	}
+}
+
+static SDL_ResampleStream *SDL_FindResampleStream(SDL_AudioCVT *cvt)
+{
+	SDL_ResampleStream *stream;
+
+	SDL_LockResampler();
+	for ( stream = resample_streams; stream; stream = stream->next ) {
+		if ( stream->cvt == cvt ) {
+			break;
+		}
+	}
+	SDL_UnlockResampler();
+	return(stream);
+}
+
+/* Make room for 'frames' in each plane, keeping the frames already there */
+static int SDL_GrowResampleStream(SDL_ResampleStream *stream, int channels,
+                                  int frames)
+{
+	float *planes;
+	int c;
+
+	if ( frames <= stream->stride ) {
+		return(1);
+	}
+	/* Leave some room for the kept frames to vary */
+	frames += 16;
+	planes = (float *)SDL_malloc(channels * frames * sizeof(float));
+	if ( planes == NULL ) {
+		return(0);
+	}
+	if ( stream->frames ) {
+		for ( c = 0; c < channels; ++c ) {
+			SDL_memcpy(planes + c * frames,
+			           stream->planes + c * stream->stride,
+			           stream->frames * sizeof(float));
+		}
+	}
+	SDL_free(stream->planes);
+	stream->planes = planes;
+	stream->stride = frames;
+	return(1);
+}
+
+static __inline__ float ResampleDot(const float *coefs, const float *in,
+                                    int taps)
+{
+#if SSE_RESAMPLE
+	__m128 sum = _mm_setzero_ps();
+	float lanes[4];
+	int k;
+
+	for ( k = 0; k < taps; k += 4 ) {
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(coefs + k),
+		                                 _mm_loadu_ps(in + k)));
+	}
+	_mm_storeu_ps(lanes, sum);
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+	float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+	int k;
+
+	for ( k = 0; k < taps; k += 4 ) {
+		sum0 += coefs[k+0] * in[k+0];
+		sum1 += coefs[k+1] * in[k+1];
+		sum2 += coefs[k+2] * in[k+2];
+		sum3 += coefs[k+3] * in[k+3];
+	}
+	return (sum0 + sum1) + (sum2 + sum3);
+#endif
+}
+
+static void SDL_Resample(SDL_AudioCVT *cvt, Uint16 format, int channels,
+                         SDL_ResampleBank *bank, SDL_ResampleStream *stream)
+{
+	int bits = (format & 0xFF);
+	int is_signed = (format & 0x8000);
+	int swap = ((format & 0x1000) != 0) != (SDL_BYTEORDER == SDL_BIG_ENDIAN);
+	int frame = (bits / 8) * channels;
+	int taps = bank->taps;
+	int lo = (bits == 8) ? -128 : -32768;
+	int hi = (bits == 8) ? 127 : 32767;
+	int in_frames, out_frames, max_frames;
+	int stride, first, end, pos, frac;
+	float *planes, *plane;
+	Uint8 *out8;
+	Uint16 *out16;
+	int c, i, j;
+
+	in_frames = cvt->len_cvt / frame;
+	if ( in_frames == 0 ) {
+		return;
+	}
+	max_frames = (cvt->len * cvt->len_mult) / frame;
+
+	/* Take the samples apart into a plane of floats for each channel,
+	   after the frames before them: the frames kept from the last buffer
+	   of a stream, or else copies of the first frame */
+	if ( stream && stream->started ) {
+		first = stream->frames;
 	} else {
-		switch (format & 0xFF) {
-			case 8: {
-				Uint8 *output;
-
-				output = cvt->buf+clen;
-				ipos = (double)cvt->len_cvt;
-				for ( i=clen; i; --i ) {
-					ipos -= cvt->rate_incr;
-					output -= 1;
-					*output = cvt->buf[(int)ipos];
-				}
+		first = taps;
+	}
+	if ( stream ) {
+		if ( ! SDL_GrowResampleStream(stream, channels,
+		                              first + in_frames) ) {
+			SDL_OutOfMemory();
+			return;
+		}
+		planes = stream->planes;
+		stride = stream->stride;
+		end = first + in_frames;
+		out_frames = max_frames;
+		if ( stream->started ) {
+			pos = stream->pos;
+			frac = stream->frac;
+		} else {
+			pos = taps;
+			frac = 0;
+		}
+	} else {
+		/* The whole buffer, with copies of the last frame after it */
+		stride = first + in_frames + taps;
+		planes = (float *)SDL_malloc(channels * stride * sizeof(float));
+		if ( planes == NULL ) {
+			SDL_OutOfMemory();
+			return;
+		}
+		end = stride;
+		out_frames = (int)(((double)in_frames * bank->L + bank->M - 1)
+		                   / bank->M);
+		if ( out_frames > max_frames ) {
+			out_frames = max_frames;
+		}
+		pos = taps;
+		frac = 0;
+	}
+	for ( i = 0; i < in_frames * channels; ++i ) {
+		int sample;
+
+		if ( bits == 8 ) {
+			sample = cvt->buf[i];
+			if ( is_signed ) {
+				sample = (Sint8)sample;
+			} else {
+				sample -= 128;
 			}
-			break;
+		} else {
+			Uint16 value = ((Uint16 *)cvt->buf)[i];
 
-			case 16: {
-				Uint16 *output;
+			if ( swap ) {
+				value = SDL_Swap16(value);
+			}
+			if ( is_signed ) {
+				sample = (Sint16)value;
+			} else {
+				sample = value - 32768;
+			}
+		}
+		planes[(i % channels) * stride + first + i / channels] =
+								(float)sample;
+	}
+	for ( c = 0; c < channels; ++c ) {
+		plane = planes + c * stride;
+		if ( ! (stream && stream->started) ) {
+			for ( i = 0; i < taps; ++i ) {
+				plane[i] = plane[taps];
+			}
+		}
+		if ( ! stream ) {
+			for ( i = 0; i < taps; ++i ) {
+				plane[taps + in_frames + i] =
+						plane[taps + in_frames - 1];
+			}
+		}
+	}
 
-				clen &= ~1;
-				output = (Uint16 *)(cvt->buf+clen);
-				ipos = (double)cvt->len_cvt/2;
-				for ( i=clen/2; i; --i ) {
-					ipos -= cvt->rate_incr;
-					output -= 1;
-					*output=((Uint16 *)cvt->buf)[(int)ipos];
+	/* A stream stops where the filter would run past the input */
+	out8 = cvt->buf;
+	out16 = (Uint16 *)cvt->buf;
+	for ( j = 0; j < out_frames && pos + taps/2 < end; ++j ) {
+		/* The position is pos + frac/L, between rows row and row+1 */
+		int t = frac * bank->phases;
+		int row = t / bank->L;
+		float w = (float)(t % bank->L) / bank->L;
+		const float *coefs = bank->coefs + row * taps;
+		const float *in = planes + pos - taps/2 + 1;
+
+		for ( c = 0; c < channels; ++c ) {
+			float value = ResampleDot(coefs, in, taps);
+			int sample;
+
+			if ( w != 0.0f ) {
+				value += w * (ResampleDot(coefs + taps, in, taps)
+				              - value);
+			}
+			sample = (int)(value + (value < 0.0f ? -0.5f : 0.5f));
+			if ( sample < lo ) {
+				sample = lo;
+			} else if ( sample > hi ) {
+				sample = hi;
+			}
+			if ( bits == 8 ) {
+				*out8++ = (Uint8)(is_signed ? sample : sample + 128);
+			} else {
+				Uint16 value16 = (Uint16)(is_signed ? sample
+				                                    : sample + 32768);
+				if ( swap ) {
+					value16 = SDL_Swap16(value16);
 				}
+				*out16++ = value16;
 			}
+			in += stride;
+		}
+		frac += bank->M;
+		pos += frac / bank->L;
+		frac %= bank->L;
+	}
+	cvt->len_cvt = j * frame;
+
+	if ( stream ) {
+		/* Keep the frames from the first one under the filter on */
+		int keep = pos - taps/2 + 1;
+
+		for ( c = 0; c < channels; ++c ) {
+			plane = planes + c * stride;
+			SDL_memmove(plane, plane + keep,
+			            (end - keep) * sizeof(float));
+		}
+		stream->frames = end - keep;
+		stream->pos = pos - keep;
+		stream->frac = frac;
+		stream->started = 1;
+	} else {
+		SDL_free(planes);
+	}
+}
+
+/* Find the ratio in lowest terms that rate_incr was computed from, as the
+   first continued fraction convergent of it that rounds to the same double */
+static int SDL_ResampleRatio(double incr, int *M, int *L)
+{
+	double x = incr;
+	double h0 = 0.0, h1 = 1.0, k0 = 1.0, k1 = 0.0;
+	double a, h2, k2;
+
+	while ( x > 0.0 && x < (double)(1 << 24) ) {
+		a = (double)(int)x;
+		h2 = a * h1 + h0;
+		k2 = a * k1 + k0;
+		if ( h2 > (double)(1 << 24) || k2 > (double)(1 << 24) ) {
 			break;
 		}
+		if ( h2 / k2 == incr ) {
+			*M = (int)h2;
+			*L = (int)k2;
+			return(1);
+		}
+		if ( x == a ) {
+			break;
+		}
+		x = 1.0 / (x - a);
+		h0 = h1; h1 = h2;
+		k0 = k1; k1 = k2;
+	}
+	return(0);
+}
+
+static void SDL_RateSinc(SDL_AudioCVT *cvt, Uint16 format,
+                         int channels, int quality)
+{
+	SDL_ResampleBank *bank;
+	int M, L;
+
+#ifdef DEBUG_CONVERT
+	fprintf(stderr, "Converting audio rate * %4.4f\n", 1.0/cvt->rate_incr);
+#endif
+	bank = SDL_FindResampleBank(cvt->rate_incr, quality);
+	if ( bank == NULL ) {
+		/* The banks are freed by SDL_AudioQuit(), but a conversion
+		   built before that can still be used, so build it again */
+		if ( ! SDL_ResampleRatio(cvt->rate_incr, &M, &L) ) {
+			SDL_SetError("Couldn't resample audio by %f",
+			             cvt->rate_incr);
+		} else if ( SDL_AddResampleBank(M, L, quality) ) {
+			bank = SDL_FindResampleBank(cvt->rate_incr, quality);
+		}
+	}
+	if ( bank ) {
+		SDL_Resample(cvt, format, channels, bank,
+		             SDL_FindResampleStream(cvt));
 	}
-	cvt->len_cvt = clen;
 	if ( cvt->filters[++cvt->filter_index] ) {
 		cvt->filters[cvt->filter_index](cvt, format);
 	}
 }
 
+#define RATE_SINC(channels, quality)					\
+static void SDLCALL SDL_RateSinc_c##channels##_##quality(		\
+				SDL_AudioCVT *cvt, Uint16 format)	\
+{									\
+	SDL_RateSinc(cvt, format, channels, RESAMPLE_##quality);	\
+}
+
+RATE_SINC(1, LOW)
+RATE_SINC(2, LOW)
+RATE_SINC(4, LOW)
+RATE_SINC(6, LOW)
+RATE_SINC(1, MEDIUM)
+RATE_SINC(2, MEDIUM)
+RATE_SINC(4, MEDIUM)
+RATE_SINC(6, MEDIUM)
+RATE_SINC(1, HIGH)
+RATE_SINC(2, HIGH)
+RATE_SINC(4, HIGH)
+RATE_SINC(6, HIGH)
+
+#undef RATE_SINC
+
+/* Indexed by quality, then by 1, 2, 4 and 6 channels */
+static void (SDLCALL *rate_sinc[RESAMPLE_QUALITIES][4])(SDL_AudioCVT *cvt,
+                                                        Uint16 format) = {
+	{ SDL_RateSinc_c1_LOW, SDL_RateSinc_c2_LOW,
+	  SDL_RateSinc_c4_LOW, SDL_RateSinc_c6_LOW },
+	{ SDL_RateSinc_c1_MEDIUM, SDL_RateSinc_c2_MEDIUM,
+	  SDL_RateSinc_c4_MEDIUM, SDL_RateSinc_c6_MEDIUM },
+	{ SDL_RateSinc_c1_HIGH, SDL_RateSinc_c2_HIGH,
+	  SDL_RateSinc_c4_HIGH, SDL_RateSinc_c6_HIGH }
+};
+
 int SDL_ConvertAudio(SDL_AudioCVT *cvt)
 {
 	/* Make sure there's data to convert */
@@ -1436,7 +2001,7 @@ int SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
 	/* Do rate conversion */
 	cvt->rate_incr = 0.0;
 	if ( (src_rate/100) != (dst_rate/100) ) {
-		Uint32 hi_rate, lo_rate;
+		Uint32 hi_rate, lo_rate, rate;
 		int len_mult;
 		double len_ratio;
 		void (SDLCALL *rate_cvt)(SDL_AudioCVT *cvt, Uint16 format);
@@ -1467,33 +2032,36 @@ int SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
 			len_ratio = 2.0;
 		}
 		/* If hi_rate = lo_rate*2^x then conversion is easy */
-		while ( ((lo_rate*2)/100) <= (hi_rate/100) ) {
-			cvt->filters[cvt->filter_index++] = rate_cvt;
-			cvt->len_mult *= len_mult;
-			lo_rate *= 2;
-			cvt->len_ratio *= len_ratio;
+		rate = lo_rate;
+		while ( ((rate*2)/100) <= (hi_rate/100) ) {
+			rate *= 2;
 		}
-		/* We may need a slow conversion here to finish up */
-		if ( (lo_rate/100) != (hi_rate/100) ) {
-#if 1
-			/* The problem with this is that if the input buffer is
-			   say 1K, and the conversion rate is say 1.1, then the
-			   output buffer is 1.1K, which may not be an acceptable
-			   buffer size for the audio driver (not a power of 2)
-			*/
-			/* For now, punt and hope the rate distortion isn't great.
-			*/
-#else
-			if ( src_rate < dst_rate ) {
-				cvt->rate_incr = (double)lo_rate/hi_rate;
-				cvt->len_mult *= 2;
-				cvt->len_ratio /= cvt->rate_incr;
-			} else {
-				cvt->rate_incr = (double)hi_rate/lo_rate;
-				cvt->len_ratio *= cvt->rate_incr;
+		if ( (rate/100) == (hi_rate/100) ) {
+			while ( ((lo_rate*2)/100) <= (hi_rate/100) ) {
+				cvt->filters[cvt->filter_index++] = rate_cvt;
+				cvt->len_mult *= len_mult;
+				lo_rate *= 2;
+				cvt->len_ratio *= len_ratio;
 			}
-			cvt->filters[cvt->filter_index++] = SDL_RateSLOW;
-#endif
+		} else {
+			/* Otherwise resample by the exact ratio in one go */
+			const char *hint = SDL_getenv("SDL_AUDIO_RESAMPLER");
+			int quality = RESAMPLE_MEDIUM;
+
+			if ( hint && SDL_strcasecmp(hint, "low") == 0 ) {
+				quality = RESAMPLE_LOW;
+			} else if ( hint && SDL_strcasecmp(hint, "high") == 0 ) {
+				quality = RESAMPLE_HIGH;
+			}
+			if ( ! SDL_AddResampleBank(src_rate, dst_rate, quality) ) {
+				return -1;
+			}
+			cvt->filters[cvt->filter_index++] =
+				rate_sinc[quality][(src_channels == 1) ? 0 :
+				                   (src_channels / 2)];
+			cvt->rate_incr = (double)src_rate / dst_rate;
+			cvt->len_mult *= (dst_rate / src_rate) + 1;
+			cvt->len_ratio *= (double)dst_rate / src_rate;
 		}
 	}
 
@@ -70,6 +70,10 @@ struct SDL_AudioDevice {
 	/* An audio conversion block for audio format emulation */
 	SDL_AudioCVT convert;
 
+	/* Converted audio waiting for a whole buffer to play */
+	Uint8 *converted;
+	int converted_len;
+
 	/* Current state flags */
 	int enabled;
 	int paused;
@@ -45,6 +45,7 @@
 #define DISKDEFAULT_OUTFILE      "sdlaudio.raw"
 #define DISKENVR_WRITEDELAY      "SDL_DISKAUDIODELAY"
 #define DISKDEFAULT_WRITEDELAY   150
+#define DISKENVR_FREQUENCY       "SDL_DISKAUDIOFREQ"
 
 /* Audio driver functions */
 static int DISKAUD_OpenAudio(_THIS, SDL_AudioSpec *spec);
@@ -160,6 +161,12 @@ static void DISKAUD_CloseAudio(_THIS)
 static int DISKAUD_OpenAudio(_THIS, SDL_AudioSpec *spec)
 {
 	const char *fname = DISKAUD_GetOutputFilename();
+	const char *envr = SDL_getenv(DISKENVR_FREQUENCY);
+
+	/* Write at a given rate, converting the audio as a device would */
+	if ( envr && SDL_atoi(envr) > 0 ) {
+		spec->freq = SDL_atoi(envr);
+	}
 
 	/* Open the audio device */
 	this->hidden->output = SDL_RWFromFile(fname, "wb");
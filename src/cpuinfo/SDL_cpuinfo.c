@@ -41,6 +41,8 @@
 #define CPU_HAS_SSE	0x00000040
 #define CPU_HAS_SSE2	0x00000080
 #define CPU_HAS_ALTIVEC	0x00000100
+#define CPU_HAS_AVX2	0x00000200
+#define CPU_HAS_SSSE3	0x00000400
 
 #if SDL_ALTIVEC_BLITTERS && HAVE_SETJMP && !__MACOSX__
 /* This is the brute force way of detecting instruction sets...
@@ -356,6 +358,66 @@ static __inline__ int CPU_haveSSE2(void)
 	return 0;
 }
 
+/* CPUID with an explicit leaf, for the features CPU_getCPUIDFeatures() misses */
+#if defined(__GNUC__) && defined(i386)
+#define CPUID(func, a, b, c, d) \
+	__asm__ __volatile__ ( \
+"        pushl   %%ebx                                                 \n" \
+"        cpuid                                                         \n" \
+"        movl    %%ebx,%%esi                                           \n" \
+"        popl    %%ebx                                                 \n" \
+	: "=a" (a), "=S" (b), "=c" (c), "=d" (d) : "a" (func), "c" (0))
+#elif defined(__GNUC__) && defined(__x86_64__)
+#define CPUID(func, a, b, c, d) \
+	__asm__ __volatile__ ( \
+"        cpuid                                                         \n" \
+	: "=a" (a), "=b" (b), "=c" (c), "=d" (d) : "a" (func), "c" (0))
+#endif
+
+static __inline__ int CPU_haveSSSE3(void)
+{
+	int ssse3 = 0;
+#ifdef CPUID
+	unsigned int a, b, c, d;
+
+	if ( CPU_haveCPUID() ) {
+		CPUID(0, a, b, c, d);
+		if ( a >= 1 ) {
+			CPUID(1, a, b, c, d);
+			ssse3 = (c & 0x00000200);
+		}
+	}
+#endif
+	return ssse3;
+}
+
+static __inline__ int CPU_haveAVX2(void)
+{
+	int avx2 = 0;
+#ifdef CPUID
+	unsigned int a, b, c, d;
+	unsigned int xcr0;
+
+	if ( CPU_haveCPUID() ) {
+		CPUID(0, a, b, c, d);
+		if ( a >= 7 ) {
+			/* The OS must also save the YMM registers (OSXSAVE, AVX) */
+			CPUID(1, a, b, c, d);
+			if ( (c & 0x18000000) == 0x18000000 ) {
+				__asm__ __volatile__ (
+"        .byte   0x0f, 0x01, 0xd0    # xgetbv                          \n"
+				: "=a" (xcr0), "=d" (d) : "c" (0));
+				if ( (xcr0 & 0x6) == 0x6 ) {
+					CPUID(7, a, b, c, d);
+					avx2 = (b & 0x00000020);
+				}
+			}
+		}
+	}
+#endif
+	return avx2;
+}
+
 static __inline__ int CPU_haveAltiVec(void)
 {
 	volatile int altivec = 0;
@@ -381,6 +443,58 @@ static __inline__ int CPU_haveAltiVec(void)
 	return altivec; 
 }
 
+static const struct {
+	const char *name;
+	Uint32 flag;
+} SDL_CPUFeatureNames[] = {
+	{ "rdtsc",	CPU_HAS_RDTSC },
+	{ "mmx",	CPU_HAS_MMX },
+	{ "mmxext",	CPU_HAS_MMXEXT },
+	{ "3dnow",	CPU_HAS_3DNOW },
+	{ "3dnowext",	CPU_HAS_3DNOWEXT },
+	{ "sse",	CPU_HAS_SSE },
+	{ "sse2",	CPU_HAS_SSE2 },
+	{ "ssse3",	CPU_HAS_SSSE3 },
+	{ "altivec",	CPU_HAS_ALTIVEC },
+	{ "avx2",	CPU_HAS_AVX2 }
+};
+
+/* Parse a list like "sse2,mmx" (or "all") from SDL_CPU_DISABLE, so that
+   benchmarks and bug reports can force the generic code paths.
+ */
+static Uint32 SDL_GetDisabledCPUFeatures(void)
+{
+	const char *list = SDL_getenv("SDL_CPU_DISABLE");
+	Uint32 disabled = 0;
+	char name[16];
+	size_t len;
+	int i;
+
+	while ( list && *list ) {
+		len = 0;
+		while ( *list && *list != ',' && *list != ' ' ) {
+			if ( len < sizeof(name)-1 ) {
+				name[len++] = *list;
+			}
+			++list;
+		}
+		name[len] = '\0';
+		if ( *list ) {
+			++list;
+		}
+		if ( SDL_strcasecmp(name, "all") == 0 ) {
+			disabled = 0xFFFFFFFF;
+			continue;
+		}
+		for ( i = 0; i < (int)SDL_arraysize(SDL_CPUFeatureNames); ++i ) {
+			if ( SDL_strcasecmp(name, SDL_CPUFeatureNames[i].name) == 0 ) {
+				disabled |= SDL_CPUFeatureNames[i].flag;
+			}
+		}
+	}
+	return disabled;
+}
+
 static Uint32 SDL_CPUFeatures = 0xFFFFFFFF;
 
 static Uint32 SDL_GetCPUFeatures(void)
@@ -408,9 +522,16 @@ static Uint32 SDL_GetCPUFeatures(void)
 		if ( CPU_haveSSE2() ) {
 			SDL_CPUFeatures |= CPU_HAS_SSE2;
 		}
+		if ( CPU_haveSSSE3() ) {
+			SDL_CPUFeatures |= CPU_HAS_SSSE3;
+		}
 		if ( CPU_haveAltiVec() ) {
 			SDL_CPUFeatures |= CPU_HAS_ALTIVEC;
 		}
+		if ( CPU_haveAVX2() ) {
+			SDL_CPUFeatures |= CPU_HAS_AVX2;
+		}
+		SDL_CPUFeatures &= ~SDL_GetDisabledCPUFeatures();
 	}
 	return SDL_CPUFeatures;
 }
@@ -471,6 +592,14 @@ SDL_bool SDL_HasSSE2(void)
 	return SDL_FALSE;
 }
 
+SDL_bool SDL_HasSSSE3(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_SSSE3 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
 SDL_bool SDL_HasAltiVec(void)
 {
 	if ( SDL_GetCPUFeatures() & CPU_HAS_ALTIVEC ) {
@@ -479,6 +608,14 @@ SDL_bool SDL_HasAltiVec(void)
 	return SDL_FALSE;
 }
 
+SDL_bool SDL_HasAVX2(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_AVX2 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
 #ifdef TEST_MAIN
 
 #include <stdio.h>
@@ -492,7 +629,9 @@ int main()
 	printf("3DNowExt: %d\n", SDL_Has3DNowExt());
 	printf("SSE: %d\n", SDL_HasSSE());
 	printf("SSE2: %d\n", SDL_HasSSE2());
+	printf("SSSE3: %d\n", SDL_HasSSSE3());
 	printf("AltiVec: %d\n", SDL_HasAltiVec());
+	printf("AVX2: %d\n", SDL_HasAVX2());
 	return 0;
 }
 
@@ -62,7 +62,7 @@
  * Encoding of surfaces with per-pixel alpha:
  *
  *   The sequence begins with a struct RLEDestFormat describing the target
- *   pixel format, to provide reliable un-encoding.
+ *   pixel format.
  *
  *   Each scan line is encoded twice: First all completely opaque pixels,
  *   encoded in the target format as described above, and then all
@@ -88,8 +88,10 @@
 
 #include "SDL_video.h"
 #include "SDL_sysvideo.h"
+#include "SDL_cpuinfo.h"
 #include "SDL_blit.h"
 #include "SDL_RLEaccel_c.h"
+#include "SDL_pixels_c.h"
 
 /* Force MMX to 0; this blows up on almost every major compiler now. --ryan. */
 #if 0 && defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && SDL_ASSEMBLY_ROUTINES
@@ -98,7 +100,6 @@
 
 #ifdef MMX_ASMBLIT
 #include "mmx.h"
-#include "SDL_cpuinfo.h"
 #endif
 
 #ifndef MAX
@@ -108,6 +109,28 @@
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #endif
 
+#if SSE2_BLIT
+/*
+ * Most runs are short, so copy them inline 16 bytes at a time instead
+ * of paying for a memcpy() call; long runs still go to memcpy().
+ */
+static __inline__ void RLECopyPixels(Uint8 *to, const Uint8 *from, size_t n)
+{
+    if(n >= 256) {
+	SDL_memcpy(to, from, n);
+	return;
+    }
+    for(; n >= 16; n -= 16, to += 16, from += 16)
+	_mm_storeu_si128((__m128i *)to, _mm_loadu_si128((__m128i *)from));
+    for(; n >= 4; n -= 4, to += 4, from += 4)
+	*(Uint32 *)to = *(const Uint32 *)from;
+    while(n--)
+	*to++ = *from++;
+}
+
+#define PIXEL_COPY(to, from, len, bpp)			\
+    RLECopyPixels((Uint8 *)(to), (Uint8 *)(from), (size_t)(len) * (bpp))
+#else
 #define PIXEL_COPY(to, from, len, bpp)			\
 do {							\
     if(bpp == 4) {					\
@@ -116,6 +139,7 @@ do {							\
 	SDL_memcpy(to, from, (size_t)(len) * (bpp));	\
     }							\
 } while(0)
+#endif
 
 /*
  * Various colorkey blit methods, for opaque and per-surface alpha
@@ -994,6 +1018,212 @@ done:
 	dst = (Uint16)(d | d >> 16);			\
     } while(0)
 
+/*
+ * Blend a whole run of translucent pixels. Per channel the macros above
+ * compute d + ((s - d) * alpha >> bits), which is the same number as
+ * (s * alpha + d * (max - alpha)) >> bits; that form fits in 16-bit
+ * lanes, so the vector versions give bit-identical results.
+ */
+typedef void (*RLETranslRun)(void *dst, Uint32 *src, int n);
+
+static void BlitTranslRun888(void *dst, Uint32 *src, int n)
+{
+    Uint32 *p = dst;
+    int i;
+    for(i = 0; i < n; i++)
+	BLIT_TRANSL_888(src[i], p[i]);
+}
+
+static void BlitTranslRun565(void *dst, Uint32 *src, int n)
+{
+    Uint16 *p = dst;
+    int i;
+    for(i = 0; i < n; i++)
+	BLIT_TRANSL_565(src[i], p[i]);
+}
+
+static void BlitTranslRun555(void *dst, Uint32 *src, int n)
+{
+    Uint16 *p = dst;
+    int i;
+    for(i = 0; i < n; i++)
+	BLIT_TRANSL_555(src[i], p[i]);
+}
+
+#if SSE2_BLIT
+static void BlitTranslRun888SSE2(void *dst, Uint32 *src, int n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c256 = _mm_set1_epi16(256);
+    const __m128i rgbmask = _mm_set1_epi32(0x00ffffff);
+    Uint32 *d = dst;
+    int i;
+    for(i = 0; i + 4 <= n; i += 4) {
+	__m128i s = _mm_loadu_si128((__m128i *)(src + i));
+	__m128i dp = _mm_loadu_si128((__m128i *)(d + i));
+	__m128i a = _mm_srli_epi32(s, 24);
+	__m128i a_lo, a_hi, lo, hi;
+	/* spread alpha over the four 16-bit channels of each pixel */
+	a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+	a_lo = _mm_unpacklo_epi32(a, a);
+	a_hi = _mm_unpackhi_epi32(a, a);
+	lo = _mm_add_epi16(
+	    _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), a_lo),
+	    _mm_mullo_epi16(_mm_unpacklo_epi8(dp, zero),
+			    _mm_sub_epi16(c256, a_lo)));
+	hi = _mm_add_epi16(
+	    _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), a_hi),
+	    _mm_mullo_epi16(_mm_unpackhi_epi8(dp, zero),
+			    _mm_sub_epi16(c256, a_hi)));
+	lo = _mm_srli_epi16(lo, 8);
+	hi = _mm_srli_epi16(hi, 8);
+	_mm_storeu_si128((__m128i *)(d + i),
+			 _mm_and_si128(_mm_packus_epi16(lo, hi), rgbmask));
+    }
+    BlitTranslRun888(d + i, src + i, n - i);
+}
+
+/* extract a field of two vectors of encoded pixels into 8 16-bit lanes */
+#define TRANSL_FIELD_SSE2(s0, s1, shift, mask)				\
+    _mm_packs_epi32(							\
+	_mm_and_si128(_mm_srli_epi32(s0, shift), _mm_set1_epi32(mask)), \
+	_mm_and_si128(_mm_srli_epi32(s1, shift), _mm_set1_epi32(mask)))
+
+/* blend one channel of 8 pixels, 5-bit alpha */
+#define TRANSL_BLEND_SSE2(s, d, a, na)					\
+    _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(s, a),			\
+				 _mm_mullo_epi16(d, na)), 5)
+
+/*
+ * Blend runs of encoded pixels onto 16-bit pixels, 8 at a time: red at
+ * rshift, green at bit 5 (bit 21 when encoded), blue at bit 0.
+ */
+#define BLIT_TRANSL_RUN16_SSE2(name, rshift, gmask, tail)		\
+static void name(void *dst, Uint32 *src, int n)				\
+{									\
+    const __m128i m5 = _mm_set1_epi16(0x1f);				\
+    const __m128i mg = _mm_set1_epi16(gmask);				\
+    Uint16 *d = dst;							\
+    int i;								\
+    for(i = 0; i + 8 <= n; i += 8) {					\
+	__m128i s0 = _mm_loadu_si128((__m128i *)(src + i));		\
+	__m128i s1 = _mm_loadu_si128((__m128i *)(src + i + 4));	\
+	__m128i dp = _mm_loadu_si128((__m128i *)(d + i));		\
+	__m128i a = TRANSL_FIELD_SSE2(s0, s1, 5, 0x1f);			\
+	__m128i na = _mm_sub_epi16(_mm_set1_epi16(32), a);		\
+	__m128i r = TRANSL_BLEND_SSE2(					\
+	    TRANSL_FIELD_SSE2(s0, s1, rshift, 0x1f),			\
+	    _mm_and_si128(_mm_srli_epi16(dp, rshift), m5), a, na);	\
+	__m128i g = TRANSL_BLEND_SSE2(					\
+	    TRANSL_FIELD_SSE2(s0, s1, 21, gmask),			\
+	    _mm_and_si128(_mm_srli_epi16(dp, 5), mg), a, na);		\
+	__m128i b = TRANSL_BLEND_SSE2(					\
+	    TRANSL_FIELD_SSE2(s0, s1, 0, 0x1f),				\
+	    _mm_and_si128(dp, m5), a, na);				\
+	_mm_storeu_si128((__m128i *)(d + i),				\
+			 _mm_or_si128(_mm_or_si128(			\
+			     _mm_slli_epi16(r, rshift),			\
+			     _mm_slli_epi16(g, 5)), b));		\
+    }									\
+    tail(d + i, src + i, n - i);					\
+}
+BLIT_TRANSL_RUN16_SSE2(BlitTranslRun565SSE2, 11, 0x3f, BlitTranslRun565)
+BLIT_TRANSL_RUN16_SSE2(BlitTranslRun555SSE2, 10, 0x1f, BlitTranslRun555)
+#endif /* SSE2_BLIT */
+
+#if NEON_BLIT
+static void BlitTranslRun888NEON(void *dst, Uint32 *src, int n)
+{
+    Uint32 *d = dst;
+    int i;
+    for(i = 0; i + 2 <= n; i += 2) {
+	uint8x8_t s = vreinterpret_u8_u32(vld1_u32(src + i));
+	uint8x8_t dp = vreinterpret_u8_u32(vld1_u32(d + i));
+	/* alpha of each pixel in all four of its byte lanes */
+	uint8x8_t a = vreinterpret_u8_u32(
+	    vshr_n_u32(vreinterpret_u32_u8(s), 24));
+	uint16x8_t a16, sum;
+	uint32x2_t res;
+	a = vreinterpret_u8_u32(vmul_n_u32(vreinterpret_u32_u8(a),
+					   0x01010101));
+	a16 = vmovl_u8(a);
+	sum = vmlaq_u16(vmulq_u16(vmovl_u8(s), a16), vmovl_u8(dp),
+			vsubq_u16(vdupq_n_u16(256), a16));
+	res = vreinterpret_u32_u8(vshrn_n_u16(sum, 8));
+	vst1_u32(d + i, vand_u32(res, vdup_n_u32(0x00ffffff)));
+    }
+    BlitTranslRun888(d + i, src + i, n - i);
+}
+
+#define TRANSL_FIELD_NEON(s, shift, mask)				\
+    vmovn_u32(vandq_u32(vshrq_n_u32(s, shift), vdupq_n_u32(mask)))
+
+#define TRANSL_BLEND_NEON(s, d, a, na)					\
+    vshrq_n_u16(vmlaq_u16(vmulq_u16(s, a), d, na), 5)
+
+#define BLIT_TRANSL_RUN16_NEON(name, rshift, gmask, tail)		\
+static void name(void *dst, Uint32 *src, int n)				\
+{									\
+    Uint16 *d = dst;							\
+    int i;								\
+    for(i = 0; i + 4 <= n; i += 4) {					\
+	uint32x4_t s = vld1q_u32(src + i);				\
+	uint16x4_t dp = vld1_u16(d + i);				\
+	uint16x4_t a = TRANSL_FIELD_NEON(s, 5, 0x1f);			\
+	uint16x4_t na = vsub_u16(vdup_n_u16(32), a);			\
+	uint16x8_t sv = vcombine_u16(TRANSL_FIELD_NEON(s, rshift, 0x1f), \
+				     TRANSL_FIELD_NEON(s, 21, gmask));	\
+	uint16x8_t dv = vcombine_u16(					\
+	    vand_u16(vshr_n_u16(dp, rshift), vdup_n_u16(0x1f)),		\
+	    vand_u16(vshr_n_u16(dp, 5), vdup_n_u16(gmask)));		\
+	uint16x8_t rg = TRANSL_BLEND_NEON(sv, dv, vcombine_u16(a, a),	\
+					  vcombine_u16(na, na));	\
+	uint16x4_t b = vshr_n_u16(vmla_u16(				\
+	    vmul_u16(TRANSL_FIELD_NEON(s, 0, 0x1f), a),			\
+	    vand_u16(dp, vdup_n_u16(0x1f)), na), 5);			\
+	vst1_u16(d + i, vorr_u16(vorr_u16(				\
+	    vshl_n_u16(vget_low_u16(rg), rshift),			\
+	    vshl_n_u16(vget_high_u16(rg), 5)), b));			\
+    }									\
+    tail(d + i, src + i, n - i);					\
+}
+BLIT_TRANSL_RUN16_NEON(BlitTranslRun565NEON, 11, 0x3f, BlitTranslRun565)
+BLIT_TRANSL_RUN16_NEON(BlitTranslRun555NEON, 10, 0x1f, BlitTranslRun555)
+#endif /* NEON_BLIT */
+
+/* pick the translucent run blender for a destination format */
+static RLETranslRun RLETranslBlitter(SDL_PixelFormat *df)
+{
+    if(df->BytesPerPixel == 4) {
+#if SSE2_BLIT
+	if(SDL_HasSSE2())
+	    return BlitTranslRun888SSE2;
+#endif
+#if NEON_BLIT
+	return BlitTranslRun888NEON;
+#endif
+	return BlitTranslRun888;
+    }
+    if(df->Gmask == 0x07e0 || df->Rmask == 0x07e0 || df->Bmask == 0x07e0) {
+#if SSE2_BLIT
+	if(SDL_HasSSE2())
+	    return BlitTranslRun565SSE2;
+#endif
+#if NEON_BLIT
+	return BlitTranslRun565NEON;
+#endif
+	return BlitTranslRun565;
+    }
+#if SSE2_BLIT
+    if(SDL_HasSSE2())
+	return BlitTranslRun555SSE2;
+#endif
+#if NEON_BLIT
+    return BlitTranslRun555NEON;
+#endif
+    return BlitTranslRun555;
+}
+
 /* used to save the destination format in the encoding. Designed to be
    macro-compatible with SDL_PixelFormat but without the unneeded fields */
 typedef struct {
@@ -1016,10 +1246,11 @@ static void RLEAlphaClipBlit(int w, Uint8 *srcbuf, SDL_Surface *dst,
 			     Uint8 *dstbuf, SDL_Rect *srcrect)
 {
     SDL_PixelFormat *df = dst->format;
+    RLETranslRun blend = RLETranslBlitter(df);
     /*
      * clipped blitter: Ptype is the destination pixel type,
-     * Ctype the translucent count type, and do_blend the macro
-     * to blend one pixel.
+     * Ctype the opaque count type, and do_blend the function
+     * to blend a run of translucent pixels.
      */
 #define RLEALPHACLIPBLIT(Ptype, Ctype, do_blend)			  \
     do {								  \
@@ -1074,13 +1305,9 @@ static void RLEAlphaClipBlit(int w, Uint8 *srcbuf, SDL_Surface *dst,
 		    }							  \
 		    if(crun > right - cofs)				  \
 			crun = right - cofs;				  \
-		    if(crun > 0) {					  \
-			Ptype *dst = (Ptype *)dstbuf + cofs;		  \
-			Uint32 *src = (Uint32 *)srcbuf + (cofs - ofs);	  \
-			int i;						  \
-			for(i = 0; i < crun; i++)			  \
-			    do_blend(src[i], dst[i]);			  \
-		    }							  \
+		    if(crun > 0)					  \
+			do_blend((Ptype *)dstbuf + cofs,		  \
+				 (Uint32 *)srcbuf + (cofs - ofs), crun);  \
 		    srcbuf += run * 4;					  \
 		    ofs += run;						  \
 		}							  \
@@ -1091,14 +1318,10 @@ static void RLEAlphaClipBlit(int w, Uint8 *srcbuf, SDL_Surface *dst,
 
     switch(df->BytesPerPixel) {
     case 2:
-	if(df->Gmask == 0x07e0 || df->Rmask == 0x07e0
-	   || df->Bmask == 0x07e0)
-	    RLEALPHACLIPBLIT(Uint16, Uint8, BLIT_TRANSL_565);
-	else
-	    RLEALPHACLIPBLIT(Uint16, Uint8, BLIT_TRANSL_555);
+	RLEALPHACLIPBLIT(Uint16, Uint8, blend);
 	break;
     case 4:
-	RLEALPHACLIPBLIT(Uint32, Uint16, BLIT_TRANSL_888);
+	RLEALPHACLIPBLIT(Uint32, Uint16, blend);
 	break;
     }
 }
@@ -1188,8 +1411,8 @@ int SDL_RLEAlphaBlit(SDL_Surface *src, SDL_Rect *srcrect,
 
 	/*
 	 * non-clipped blitter. Ptype is the destination pixel type,
-	 * Ctype the translucent count type, and do_blend the
-	 * macro to blend one pixel.
+	 * Ctype the opaque count type, and do_blend the
+	 * function to blend a run of translucent pixels.
 	 */
 #define RLEALPHABLIT(Ptype, Ctype, do_blend)				 \
 	do {								 \
@@ -1221,14 +1444,9 @@ int SDL_RLEAlphaBlit(SDL_Surface *src, SDL_Rect *srcrect,
 		    run = ((Uint16 *)srcbuf)[1];			 \
 		    srcbuf += 4;					 \
 		    if(run) {						 \
-			Ptype *dst = (Ptype *)dstbuf + ofs;		 \
-			unsigned i;					 \
-			for(i = 0; i < run; i++) {			 \
-			    Uint32 src = *(Uint32 *)srcbuf;		 \
-			    do_blend(src, *dst);			 \
-			    srcbuf += 4;				 \
-			    dst++;					 \
-			}						 \
+			do_blend((Ptype *)dstbuf + ofs,			 \
+				 (Uint32 *)srcbuf, run);		 \
+			srcbuf += run * 4;				 \
 			ofs += run;					 \
 		    }							 \
 		} while(ofs < w);					 \
@@ -1236,16 +1454,14 @@ int SDL_RLEAlphaBlit(SDL_Surface *src, SDL_Rect *srcrect,
 	    } while(--linecount);					 \
 	} while(0)
 
+	RLETranslRun blend = RLETranslBlitter(df);
+
 	switch(df->BytesPerPixel) {
 	case 2:
-	    if(df->Gmask == 0x07e0 || df->Rmask == 0x07e0
-	       || df->Bmask == 0x07e0)
-		RLEALPHABLIT(Uint16, Uint8, BLIT_TRANSL_565);
-	    else
-		RLEALPHABLIT(Uint16, Uint8, BLIT_TRANSL_555);
+	    RLEALPHABLIT(Uint16, Uint8, blend);
 	    break;
 	case 4:
-	    RLEALPHABLIT(Uint32, Uint16, BLIT_TRANSL_888);
+	    RLEALPHABLIT(Uint32, Uint16, blend);
 	    break;
 	}
     }
@@ -1262,9 +1478,7 @@ int SDL_RLEAlphaBlit(SDL_Surface *src, SDL_Rect *srcrect,
  * Auxiliary functions:
  * The encoding functions take 32bpp rgb + a, and
  * return the number of bytes copied to the destination.
- * The decoding functions copy to 32bpp rgb + a, and
- * return the number of bytes copied from the source.
- * These are only used in the encoder and un-RLE code and are therefore not
+ * These are only used in the encoder and are therefore not
  * highly optimised.
  */
 
@@ -1284,25 +1498,6 @@ static int copy_opaque_16(void *dst, Uint32 *src, int n,
     return n * 2;
 }
 
-/* decode opaque pixels from 16bpp to 32bpp rgb + a */
-static int uncopy_opaque_16(Uint32 *dst, void *src, int n,
-			    RLEDestFormat *sfmt, SDL_PixelFormat *dfmt)
-{
-    int i;
-    Uint16 *s = src;
-    unsigned alpha = dfmt->Amask ? 255 : 0;
-    for(i = 0; i < n; i++) {
-	unsigned r, g, b;
-	RGB_FROM_PIXEL(*s, sfmt, r, g, b);
-	PIXEL_FROM_RGBA(*dst, dfmt, r, g, b, alpha);
-	s++;
-	dst++;
-    }
-    return n * 2;
-}
-
-
-
 /* encode 32bpp rgb + a into 32bpp G0RAB format for blitting into 565 */
 static int copy_transl_565(void *dst, Uint32 *src, int n,
 			   SDL_PixelFormat *sfmt, SDL_PixelFormat *dfmt)
@@ -1339,24 +1534,6 @@ static int copy_transl_555(void *dst, Uint32 *src, int n,
     return n * 4;
 }
 
-/* decode translucent pixels from 32bpp GORAB to 32bpp rgb + a */
-static int uncopy_transl_16(Uint32 *dst, void *src, int n,
-			    RLEDestFormat *sfmt, SDL_PixelFormat *dfmt)
-{
-    int i;
-    Uint32 *s = src;
-    for(i = 0; i < n; i++) {
-	unsigned r, g, b, a;
-	Uint32 pix = *s++;
-	a = (pix & 0x3e0) >> 2;
-	pix = (pix & ~0x3e0) | pix >> 16;
-	RGB_FROM_PIXEL(pix, sfmt, r, g, b);
-	PIXEL_FROM_RGBA(*dst, dfmt, r, g, b, a);
-	dst++;
-    }
-    return n * 4;
-}
-
 /* encode 32bpp rgba into 32bpp rgba, keeping alpha (dual purpose) */
 static int copy_32(void *dst, Uint32 *src, int n,
 		   SDL_PixelFormat *sfmt, SDL_PixelFormat *dfmt)
@@ -1374,36 +1551,41 @@ static int copy_32(void *dst, Uint32 *src, int n,
     return n * 4;
 }
 
-/* decode 32bpp rgba into 32bpp rgba, keeping alpha (dual purpose) */
-static int uncopy_32(Uint32 *dst, void *src, int n,
-		     RLEDestFormat *sfmt, SDL_PixelFormat *dfmt)
-{
-    int i;
-    Uint32 *s = src;
-    for(i = 0; i < n; i++) {
-	unsigned r, g, b, a;
-	Uint32 pixel = *s++;
-	RGB_FROM_PIXEL(pixel, sfmt, r, g, b);
-	a = pixel >> 24;
-	PIXEL_FROM_RGBA(*dst, dfmt, r, g, b, a);
-	dst++;
-    }
-    return n * 4;
-}
-
 #define ISOPAQUE(pixel, fmt) ((((pixel) & fmt->Amask) >> fmt->Ashift) == 255)
 
 #define ISTRANSL(pixel, fmt)	\
     ((unsigned)((((pixel) & fmt->Amask) >> fmt->Ashift) - 1U) < 254U)
 
-/* convert surface to be quickly alpha-blittable onto dest, if possible */
-static int RLEAlphaSurface(SDL_Surface *surface)
+#define ISCLEAR(pixel, fmt) (((pixel) & fmt->Amask) == 0)
+
+/* check that per-pixel alpha surfaces can be encoded for df */
+static int RLEAlphaTarget(SDL_PixelFormat *df)
+{
+    unsigned masksum = df->Rmask | df->Gmask | df->Bmask;
+    switch(df->BytesPerPixel) {
+    case 2:
+	/* 16bpp: only support 565 and 555 formats */
+	if(masksum == 0xffff)
+	    return df->Gmask == 0x07e0
+		|| df->Rmask == 0x07e0 || df->Bmask == 0x07e0;
+	if(masksum == 0x7fff)
+	    return df->Gmask == 0x03e0
+		|| df->Rmask == 0x03e0 || df->Bmask == 0x03e0;
+	return 0;
+    case 4:
+	return masksum == 0x00ffffff;	/* requires unused high byte */
+    default:
+	return 0;
+    }
+}
+
+/* encode surface to be quickly alpha-blittable onto df, if possible */
+static Uint8 *RLEAlphaEncode(SDL_Surface *surface, SDL_PixelFormat *df)
 {
-    SDL_Surface *dest;
-    SDL_PixelFormat *df;
     int maxsize = 0;
     int max_opaque_run;
     int max_transl_run = 65535;
+    int transl_align;
     unsigned masksum;
     Uint8 *rlebuf, *dst;
     int (*copy_opaque)(void *, Uint32 *, int,
@@ -1411,12 +1593,8 @@ static int RLEAlphaSurface(SDL_Surface *surface)
     int (*copy_transl)(void *, Uint32 *, int,
 		       SDL_PixelFormat *, SDL_PixelFormat *);
 
-    dest = surface->map->dst;
-    if(!dest)
-	return -1;
-    df = dest->format;
     if(surface->format->BitsPerPixel != 32)
-	return -1;		/* only 32bpp source supported */
+	return NULL;		/* only 32bpp source supported */
 
     /* find out whether the destination is one we support,
        and determine the max size of the encoded result */
@@ -1431,7 +1609,7 @@ static int RLEAlphaSurface(SDL_Surface *surface)
 		copy_opaque = copy_opaque_16;
 		copy_transl = copy_transl_565;
 	    } else
-		return -1;
+		return NULL;
 	    break;
 	case 0x7fff:
 	    if(df->Gmask == 0x03e0
@@ -1439,12 +1617,13 @@ static int RLEAlphaSurface(SDL_Surface *surface)
 		copy_opaque = copy_opaque_16;
 		copy_transl = copy_transl_555;
 	    } else
-		return -1;
+		return NULL;
 	    break;
 	default:
-	    return -1;
+	    return NULL;
 	}
 	max_opaque_run = 255;	/* runs stored as bytes */
+	transl_align = 8;	/* pixels per vector in the 16-bit blenders */
 
 	/* worst case is alternating opaque and translucent pixels,
 	   with room for alignment padding between lines */
@@ -1452,26 +1631,28 @@ static int RLEAlphaSurface(SDL_Surface *surface)
 	break;
     case 4:
 	if(masksum != 0x00ffffff)
-	    return -1;		/* requires unused high byte */
+	    return NULL;		/* requires unused high byte */
 	copy_opaque = copy_32;
 	copy_transl = copy_32;
 	max_opaque_run = 255;	/* runs stored as short ints */
+	/* the blenders clear the top byte, so only pad when it is unused */
+	transl_align = df->Amask ? 1 : 4;
 
 	/* worst case is alternating opaque and translucent pixels */
 	maxsize = surface->h * 2 * 4 * (surface->w + 1) + 4;
 	break;
     default:
-	return -1;		/* anything else unsupported right now */
+	return NULL;		/* anything else unsupported right now */
     }
 
     maxsize += sizeof(RLEDestFormat);
     rlebuf = (Uint8 *)SDL_malloc(maxsize);
     if(!rlebuf) {
 	SDL_OutOfMemory();
-	return -1;
+	return NULL;
     }
     {
-	/* save the destination format so we can undo the encoding later */
+	/* save the destination format for the blitters */
 	RLEDestFormat *r = (RLEDestFormat *)rlebuf;
 	r->BytesPerPixel = df->BytesPerPixel;
 	r->Rloss = df->Rloss;
@@ -1558,8 +1739,22 @@ static int RLEAlphaSurface(SDL_Surface *surface)
 		while(x < w && !ISTRANSL(src[x], sf))
 		    x++;
 		runstart = x;
-		while(x < w && ISTRANSL(src[x], sf))
-		    x++;
+		/*
+		 * Blending a fully transparent pixel leaves the destination
+		 * alone, so pad runs with them to a whole number of vectors,
+		 * joining runs separated by short transparent gaps.
+		 */
+		for(;;) {
+		    while(x < w && ISTRANSL(src[x], sf))
+			x++;
+		    if(x == runstart)
+			break;
+		    while(x < w && (x - runstart) % transl_align
+			  && ISCLEAR(src[x], sf))
+			x++;
+		    if(x == w || !ISTRANSL(src[x], sf))
+			break;
+		}
 		skip = runstart - skipstart;
 		blankline &= (skip == w);
 		run = x - runstart;
@@ -1592,22 +1787,13 @@ static int RLEAlphaSurface(SDL_Surface *surface)
 #undef ADD_OPAQUE_COUNTS
 #undef ADD_TRANSL_COUNTS
 
-    /* Now that we have it encoded, release the original pixels */
-    if((surface->flags & SDL_PREALLOC) != SDL_PREALLOC
-       && (surface->flags & SDL_HWSURFACE) != SDL_HWSURFACE) {
-	SDL_free( surface->pixels );
-	surface->pixels = NULL;
-    }
-
     /* realloc the buffer to release unused memory */
     {
 	Uint8 *p = SDL_realloc(rlebuf, dst - rlebuf);
 	if(!p)
 	    p = rlebuf;
-	surface->map->sw_data->aux_data = p;
+	return p;
     }
-
-    return 0;
 }
 
 static Uint32 getpix_8(Uint8 *srcbuf)
@@ -1640,7 +1826,7 @@ static getpix_func getpixes[4] = {
     getpix_8, getpix_16, getpix_24, getpix_32
 };
 
-static int RLEColorkeySurface(SDL_Surface *surface)
+static Uint8 *RLEColorkeyEncode(SDL_Surface *surface)
 {
         Uint8 *rlebuf, *dst;
 	int maxn;
@@ -1675,7 +1861,7 @@ static int RLEColorkeySurface(SDL_Surface *surface)
 	rlebuf = (Uint8 *)SDL_malloc(maxsize);
 	if ( rlebuf == NULL ) {
 		SDL_OutOfMemory();
-		return(-1);
+		return(NULL);
 	}
 
 	/* Set up the conversion */
@@ -1749,193 +1935,353 @@ static int RLEColorkeySurface(SDL_Surface *surface)
 
 #undef ADD_COUNTS
 
-	/* Now that we have it encoded, release the original pixels */
-	if((surface->flags & SDL_PREALLOC) != SDL_PREALLOC
-	   && (surface->flags & SDL_HWSURFACE) != SDL_HWSURFACE) {
-	    SDL_free( surface->pixels );
-	    surface->pixels = NULL;
-	}
-
 	/* realloc the buffer to release unused memory */
 	{
 	    /* If realloc returns NULL, the original block is left intact */
 	    Uint8 *p = SDL_realloc(rlebuf, dst - rlebuf);
 	    if(!p)
 		p = rlebuf;
-	    surface->map->sw_data->aux_data = p;
+	    return(p);
+	}
+}
+
+/*
+ * Encodings are kept in a small cache on the surface's blit map, keyed by
+ * the kind of encoding and, for per-pixel alpha, the target format, so
+ * switching between destinations doesn't encode the surface again.  The
+ * original pixels are kept, so the cache is only thrown away when they
+ * may change (see SDL_UnRLESurface).
+ *
+ * If the SDL_VIDEO_RLE_THREAD environment variable is set to 1, software
+ * surfaces are encoded on a background thread, and are blitted without
+ * RLE acceleration until their encoding is ready.
+ */
+#define RLE_CACHE_SIZE	4
+
+enum {
+    RLE_IDLE,			/* not encoded yet */
+    RLE_QUEUED,			/* waiting for the background thread */
+    RLE_RUNNING,		/* being encoded by the background thread */
+    RLE_READY,
+    RLE_FAILED			/* can't be encoded for this target */
+};
+
+struct SDL_RLEEntry {
+    struct SDL_RLEEntry *next;	/* next least recently used encoding */
+    struct SDL_RLEEntry *next_job; /* next encoding in the work queue */
+    SDL_Surface *surface;
+    int alpha;			/* per-pixel alpha rather than colorkey */
+    SDL_PixelFormat format;	/* target format of per-pixel alpha */
+    int state;
+    Uint8 *data;
+};
+
+static Uint8 *RLEEncode(SDL_RLEEntry *entry)
+{
+    if(entry->alpha)
+	return RLEAlphaEncode(entry->surface, &entry->format);
+    else
+	return RLEColorkeyEncode(entry->surface);
+}
+
+static int RLEMatch(SDL_RLEEntry *entry, int alpha, SDL_PixelFormat *df)
+{
+    if(entry->alpha != alpha)
+	return 0;
+    if(!alpha)
+	return 1;		/* colorkey encodings keep the source format */
+    return entry->format.BytesPerPixel == df->BytesPerPixel
+	&& entry->format.Rmask == df->Rmask
+	&& entry->format.Gmask == df->Gmask
+	&& entry->format.Bmask == df->Bmask
+	&& entry->format.Amask == df->Amask;
+}
+
+#if !SDL_THREADS_DISABLED
+#include "SDL_thread.h"
+
+static struct {
+    int initialized;
+    int quit;
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    SDL_cond *done;		/* signalled when an encoding is finished */
+    SDL_sem *wake;		/* posted when there may be work to do */
+    SDL_RLEEntry *queue;
+} rle_worker;
+
+#define RLE_LOCK()	if ( rle_worker.lock ) SDL_mutexP(rle_worker.lock)
+#define RLE_UNLOCK()	if ( rle_worker.lock ) SDL_mutexV(rle_worker.lock)
+
+static int SDLCALL SDL_RLEWorkerThread(void *unused)
+{
+    SDL_RLEEntry *entry;
+    Uint8 *data;
+
+    for ( ; ; ) {
+	SDL_SemWait(rle_worker.wake);
+	SDL_mutexP(rle_worker.lock);
+	if ( rle_worker.quit ) {
+	    SDL_mutexV(rle_worker.lock);
+	    break;
 	}
+	/* The queue may be empty if the encoding was cancelled */
+	entry = rle_worker.queue;
+	if ( entry ) {
+	    rle_worker.queue = entry->next_job;
+	    entry->state = RLE_RUNNING;
+	    SDL_mutexV(rle_worker.lock);
+
+	    data = RLEEncode(entry);
+
+	    SDL_mutexP(rle_worker.lock);
+	    entry->data = data;
+	    entry->state = data ? RLE_READY : RLE_FAILED;
+	    SDL_CondBroadcast(rle_worker.done);
+	}
+	SDL_mutexV(rle_worker.lock);
+    }
+    return(0);
+}
 
+/* Called by SDL_Init(), so the lock never appears while it's in use */
+void SDL_InitRLEThread(void)
+{
+    const char *env;
+
+    if ( rle_worker.initialized ) {
+	return;
+    }
+    rle_worker.initialized = 1;
+
+    env = SDL_getenv("SDL_VIDEO_RLE_THREAD");
+    if ( !env || SDL_atoi(env) <= 0 ) {
+	return;
+    }
+    rle_worker.lock = SDL_CreateMutex();
+    rle_worker.done = SDL_CreateCond();
+    rle_worker.wake = SDL_CreateSemaphore(0);
+    if ( rle_worker.lock && rle_worker.done && rle_worker.wake ) {
+	rle_worker.thread = SDL_CreateThread(SDL_RLEWorkerThread, NULL);
+    }
+    if ( rle_worker.thread == NULL ) {
+	SDL_QuitRLEThread();
+	rle_worker.initialized = 1;
+    }
+}
+
+void SDL_QuitRLEThread(void)
+{
+    SDL_RLEEntry *entry;
+
+    if ( rle_worker.thread ) {
+	SDL_mutexP(rle_worker.lock);
+	rle_worker.quit = 1;
+	SDL_mutexV(rle_worker.lock);
+	SDL_SemPost(rle_worker.wake);
+	SDL_WaitThread(rle_worker.thread, NULL);
+    }
+    /* Anything left in the queue is encoded when it's next blitted */
+    for ( entry = rle_worker.queue; entry; entry = entry->next_job ) {
+	entry->state = RLE_IDLE;
+    }
+    if ( rle_worker.wake ) {
+	SDL_DestroySemaphore(rle_worker.wake);
+    }
+    if ( rle_worker.done ) {
+	SDL_DestroyCond(rle_worker.done);
+    }
+    if ( rle_worker.lock ) {
+	SDL_DestroyMutex(rle_worker.lock);
+    }
+    SDL_memset(&rle_worker, 0, sizeof(rle_worker));
+}
+
+/* Hand an encoding to the background thread, if it can take it */
+static int RLEQueue(SDL_RLEEntry *entry)
+{
+    SDL_Surface *surface = entry->surface;
+    SDL_RLEEntry **prev;
+
+    /* Surfaces that need locking are encoded on the blitting thread */
+    if ( !rle_worker.thread || surface->offset ||
+	 (surface->flags & (SDL_HWSURFACE|SDL_ASYNCBLIT)) ) {
 	return(0);
+    }
+    for ( prev = &rle_worker.queue; *prev; prev = &(*prev)->next_job )
+	;
+    entry->next_job = NULL;
+    *prev = entry;
+    entry->state = RLE_QUEUED;
+    SDL_SemPost(rle_worker.wake);
+    return(1);
 }
 
-int SDL_RLESurface(SDL_Surface *surface)
+/* Take an encoding away from the background thread; the lock is held */
+static void RLECancel(SDL_RLEEntry *entry)
 {
-	int retcode;
+    SDL_RLEEntry **prev;
+
+    if ( entry->state == RLE_QUEUED ) {
+	for ( prev = &rle_worker.queue; *prev != entry;
+	      prev = &(*prev)->next_job )
+	    ;
+	*prev = entry->next_job;
+	entry->state = RLE_IDLE;
+    }
+    while ( entry->state == RLE_RUNNING ) {
+	SDL_CondWait(rle_worker.done, rle_worker.lock);
+    }
+}
+#else
+void SDL_InitRLEThread(void)
+{
+}
 
-	/* Clear any previous RLE conversion */
-	if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
-		SDL_UnRLESurface(surface, 1);
+void SDL_QuitRLEThread(void)
+{
+}
+
+#define RLE_LOCK()
+#define RLE_UNLOCK()
+#define RLEQueue(entry)		0
+#define RLECancel(entry)
+#endif /* !SDL_THREADS_DISABLED */
+
+/* Drop the least recently used encodings that don't fit in the cache */
+static void RLETrimCache(struct private_swaccel *sw_data)
+{
+    SDL_RLEEntry **prev = &sw_data->rle_cache;
+    SDL_RLEEntry *entry;
+    int count = 0;
+
+    while ( (entry = *prev) != NULL ) {
+	if ( ++count > RLE_CACHE_SIZE
+	     && entry->state != RLE_QUEUED && entry->state != RLE_RUNNING ) {
+	    *prev = entry->next;
+	    SDL_free(entry->data);
+	    SDL_free(entry);
+	} else {
+	    prev = &entry->next;
 	}
+    }
+}
+
+/*
+ * Switch the surface to the RLE blitter for its current mapping.
+ * Returns 0 on success, 1 if the encoding is still being made in the
+ * background, or -1 if the surface can't be RLE encoded for the target.
+ */
+int SDL_RLESurface(SDL_Surface *surface)
+{
+	struct private_swaccel *sw_data = surface->map->sw_data;
+	SDL_PixelFormat *df = surface->map->dst->format;
+	SDL_RLEEntry *entry, **prev;
+	Uint8 *data;
+	int alpha;
+	int retcode;
 
 	/* We don't support RLE encoding of bitmaps */
 	if ( surface->format->BitsPerPixel < 8 ) {
 		return(-1);
 	}
+	if((surface->flags & SDL_SRCCOLORKEY) == SDL_SRCCOLORKEY) {
+	    alpha = 0;
+	} else if((surface->flags & SDL_SRCALPHA) == SDL_SRCALPHA
+		  && surface->format->Amask != 0) {
+	    /* only 32bpp sources and some targets are supported */
+	    if(surface->format->BitsPerPixel != 32 || !RLEAlphaTarget(df))
+		return(-1);
+	    alpha = 1;
+	} else {
+	    return(-1);	/* no RLE for per-surface alpha sans ckey */
+	}
 
-	/* Lock the surface if it's in hardware */
-	if ( SDL_MUSTLOCK(surface) ) {
-		if ( SDL_LockSurface(surface) < 0 ) {
+	RLE_LOCK();
+
+	/* Look for a cached encoding, and make it the most recently used */
+	for ( prev = &sw_data->rle_cache; (entry = *prev) != NULL;
+	      prev = &entry->next ) {
+		if ( RLEMatch(entry, alpha, df) ) {
+			*prev = entry->next;
+			break;
+		}
+	}
+	if ( entry == NULL ) {
+		entry = (SDL_RLEEntry *)SDL_malloc(sizeof(*entry));
+		if ( entry == NULL ) {
+			RLE_UNLOCK();
+			SDL_OutOfMemory();
 			return(-1);
 		}
+		SDL_memset(entry, 0, sizeof(*entry));
+		entry->surface = surface;
+		entry->alpha = alpha;
+		if ( alpha ) {
+			entry->format = *df;
+			entry->format.palette = NULL;
+		}
+		/* The surface must be unencoded before its pixels change */
+		surface->flags |= SDL_RLEACCEL;
 	}
-
-	/* Encode */
-	if((surface->flags & SDL_SRCCOLORKEY) == SDL_SRCCOLORKEY) {
-	    retcode = RLEColorkeySurface(surface);
-	} else {
-	    if((surface->flags & SDL_SRCALPHA) == SDL_SRCALPHA
-	       && surface->format->Amask != 0)
-		retcode = RLEAlphaSurface(surface);
-	    else
-		retcode = -1;	/* no RLE for per-surface alpha sans ckey */
+	entry->next = sw_data->rle_cache;
+	sw_data->rle_cache = entry;
+	RLETrimCache(sw_data);
+
+	if ( entry->state == RLE_IDLE && !RLEQueue(entry) ) {
+		RLE_UNLOCK();
+		data = NULL;
+		if ( SDL_LockSurfaceReadOnly(surface) == 0 ) {
+			data = RLEEncode(entry);
+			SDL_UnlockSurface(surface);
+		}
+		RLE_LOCK();
+		entry->data = data;
+		entry->state = data ? RLE_READY : RLE_FAILED;
 	}
 
-	/* Unlock the surface if it's in hardware */
-	if ( SDL_MUSTLOCK(surface) ) {
-		SDL_UnlockSurface(surface);
+	switch (entry->state) {
+	    case RLE_READY:
+		sw_data->aux_data = entry->data;
+		surface->map->sw_blit = alpha ? SDL_RLEAlphaBlit : SDL_RLEBlit;
+		retcode = 0;
+		break;
+	    case RLE_FAILED:
+		retcode = -1;
+		break;
+	    default:
+		retcode = 1;
+		break;
 	}
 
-	if(retcode < 0)
-	    return -1;
-
-	/* The surface is now accelerated */
-	surface->flags |= SDL_RLEACCEL;
-
-	return(0);
+	RLE_UNLOCK();
+	return(retcode);
 }
 
 /*
- * Un-RLE a surface with pixel alpha
- * This may not give back exactly the image before RLE-encoding; all
- * completely transparent pixels will be lost, and colour and alpha depth
- * may have been reduced (when encoding for 16bpp targets).
+ * Throw away all the RLE encodings of a surface, because its pixels or
+ * colorkey are about to change, or the surface is being freed.
  */
-static SDL_bool UnRLEAlpha(SDL_Surface *surface)
+void SDL_UnRLESurface(SDL_Surface *surface)
 {
-    Uint8 *srcbuf;
-    Uint32 *dst;
-    SDL_PixelFormat *sf = surface->format;
-    RLEDestFormat *df = surface->map->sw_data->aux_data;
-    int (*uncopy_opaque)(Uint32 *, void *, int,
-			 RLEDestFormat *, SDL_PixelFormat *);
-    int (*uncopy_transl)(Uint32 *, void *, int,
-			 RLEDestFormat *, SDL_PixelFormat *);
-    int w = surface->w;
-    int bpp = df->BytesPerPixel;
-
-    if(bpp == 2) {
-	uncopy_opaque = uncopy_opaque_16;
-	uncopy_transl = uncopy_transl_16;
-    } else {
-	uncopy_opaque = uncopy_transl = uncopy_32;
-    }
+    struct private_swaccel *sw_data;
+    SDL_RLEEntry *entry;
 
-    surface->pixels = SDL_malloc(surface->h * surface->pitch);
-    if ( !surface->pixels ) {
-        return(SDL_FALSE);
-    }
-    /* fill background with transparent pixels */
-    SDL_memset(surface->pixels, 0, surface->h * surface->pitch);
-
-    dst = surface->pixels;
-    srcbuf = (Uint8 *)(df + 1);
-    for(;;) {
-	/* copy opaque pixels */
-	int ofs = 0;
-	do {
-	    unsigned run;
-	    if(bpp == 2) {
-		ofs += srcbuf[0];
-		run = srcbuf[1];
-		srcbuf += 2;
-	    } else {
-		ofs += ((Uint16 *)srcbuf)[0];
-		run = ((Uint16 *)srcbuf)[1];
-		srcbuf += 4;
-	    }
-	    if(run) {
-		srcbuf += uncopy_opaque(dst + ofs, srcbuf, run, df, sf);
-		ofs += run;
-	    } else if(!ofs)
-		return(SDL_TRUE);
-	} while(ofs < w);
-
-	/* skip padding if needed */
-	if(bpp == 2)
-	    srcbuf += (uintptr_t)srcbuf & 2;
-	
-	/* copy translucent pixels */
-	ofs = 0;
-	do {
-	    unsigned run;
-	    ofs += ((Uint16 *)srcbuf)[0];
-	    run = ((Uint16 *)srcbuf)[1];
-	    srcbuf += 4;
-	    if(run) {
-		srcbuf += uncopy_transl(dst + ofs, srcbuf, run, df, sf);
-		ofs += run;
-	    }
-	} while(ofs < w);
-	dst += surface->pitch >> 2;
-    }
-    /* Make the compiler happy */
-    return(SDL_TRUE);
-}
-
-void SDL_UnRLESurface(SDL_Surface *surface, int recode)
-{
     if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
 	surface->flags &= ~SDL_RLEACCEL;
 
-	if(recode && (surface->flags & SDL_PREALLOC) != SDL_PREALLOC
-	   && (surface->flags & SDL_HWSURFACE) != SDL_HWSURFACE) {
-	    if((surface->flags & SDL_SRCCOLORKEY) == SDL_SRCCOLORKEY) {
-		SDL_Rect full;
-		unsigned alpha_flag;
-
-		/* re-create the original surface */
-		surface->pixels = SDL_malloc(surface->h * surface->pitch);
-		if ( !surface->pixels ) {
-			/* Oh crap... */
-			surface->flags |= SDL_RLEACCEL;
-			return;
-		}
-
-		/* fill it with the background colour */
-		SDL_FillRect(surface, NULL, surface->format->colorkey);
-
-		/* now render the encoded surface */
-		full.x = full.y = 0;
-		full.w = surface->w;
-		full.h = surface->h;
-		alpha_flag = surface->flags & SDL_SRCALPHA;
-		surface->flags &= ~SDL_SRCALPHA; /* opaque blit */
-		SDL_RLEBlit(surface, &full, surface, &full);
-		surface->flags |= alpha_flag;
-	    } else {
-		if ( !UnRLEAlpha(surface) ) {
-		    /* Oh crap... */
-		    surface->flags |= SDL_RLEACCEL;
-		    return;
-		}
-	    }
+	sw_data = surface->map->sw_data;
+	RLE_LOCK();
+	while ( (entry = sw_data->rle_cache) != NULL ) {
+	    sw_data->rle_cache = entry->next;
+	    RLECancel(entry);
+	    SDL_free(entry->data);
+	    SDL_free(entry);
 	}
+	RLE_UNLOCK();
 
-	if ( surface->map && surface->map->sw_data->aux_data ) {
-	    SDL_free(surface->map->sw_data->aux_data);
-	    surface->map->sw_data->aux_data = NULL;
-	}
+	/* The blitter may have been using one of them */
+	sw_data->aux_data = NULL;
+	SDL_InvalidateMap(surface->map);
     }
 }
-
-
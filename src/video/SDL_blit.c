@@ -39,6 +39,229 @@
 #include "mmx.h"
 #endif
 
+#if !SDL_THREADS_DISABLED
+#include "SDL_thread.h"
+
+/*
+   Large software blits can be split into bands of rows which run in
+   parallel on a pool of worker threads.  This is off unless the
+   SDL_VIDEO_BLIT_THREADS environment variable asks for more than one
+   thread, and only blits of at least SDL_VIDEO_BLIT_THREAD_PIXELS pixels
+   are split, since waking the workers costs more than a small blit.
+   Other software drawing, like YUV overlays, uses the same threads
+   through SDL_RunBands().  The threads are started by SDL_Init(), on
+   the application's main thread, and stopped by SDL_Quit().
+*/
+#define MAX_BLIT_THREADS	16
+#define MIN_BLIT_BAND_ROWS	16
+#define DEFAULT_BLIT_THREAD_PIXELS	(256*256)
+
+typedef struct {
+	SDL_Thread *thread;
+	SDL_sem *start;
+	SDL_BandFunc func;
+	void *data;
+	int first;
+	int count;
+} SDL_BlitWorker;
+
+static struct {
+	int initialized;
+	int quit;
+	int num_workers;
+	int min_pixels;
+	SDL_mutex *lock;
+	SDL_sem *done;
+	SDL_BlitWorker workers[MAX_BLIT_THREADS-1];
+} blit_pool;
+
+static int SDLCALL SDL_BlitWorkerThread(void *data)
+{
+	SDL_BlitWorker *worker = (SDL_BlitWorker *)data;
+
+	for ( ; ; ) {
+		SDL_SemWait(worker->start);
+		if ( blit_pool.quit ) {
+			break;
+		}
+		worker->func(worker->data, worker->first, worker->count);
+		SDL_SemPost(blit_pool.done);
+	}
+	return(0);
+}
+
+void SDL_InitBlitThreads(void)
+{
+	const char *env;
+	int threads;
+	int i;
+
+	if ( blit_pool.initialized ) {
+		return;
+	}
+	blit_pool.initialized = 1;
+
+	env = SDL_getenv("SDL_VIDEO_BLIT_THREADS");
+	threads = env ? SDL_atoi(env) : 0;
+	if ( threads <= 1 ) {
+		return;
+	}
+	if ( threads > MAX_BLIT_THREADS ) {
+		threads = MAX_BLIT_THREADS;
+	}
+	env = SDL_getenv("SDL_VIDEO_BLIT_THREAD_PIXELS");
+	blit_pool.min_pixels = env ? SDL_atoi(env) : DEFAULT_BLIT_THREAD_PIXELS;
+
+	blit_pool.lock = SDL_CreateMutex();
+	blit_pool.done = SDL_CreateSemaphore(0);
+	if ( !blit_pool.lock || !blit_pool.done ) {
+		SDL_QuitBlitThreads();
+		blit_pool.initialized = 1;
+		return;
+	}
+
+	/* The thread doing the blit runs one of the bands itself */
+	for ( i = 0; i < threads-1; ++i ) {
+		SDL_BlitWorker *worker = &blit_pool.workers[i];
+
+		worker->start = SDL_CreateSemaphore(0);
+		if ( worker->start == NULL ) {
+			break;
+		}
+		worker->thread = SDL_CreateThread(SDL_BlitWorkerThread, worker);
+		if ( worker->thread == NULL ) {
+			SDL_DestroySemaphore(worker->start);
+			worker->start = NULL;
+			break;
+		}
+	}
+	blit_pool.num_workers = i;
+}
+
+void SDL_QuitBlitThreads(void)
+{
+	int i;
+
+	blit_pool.quit = 1;
+	for ( i = 0; i < blit_pool.num_workers; ++i ) {
+		SDL_SemPost(blit_pool.workers[i].start);
+	}
+	for ( i = 0; i < blit_pool.num_workers; ++i ) {
+		SDL_WaitThread(blit_pool.workers[i].thread, NULL);
+		SDL_DestroySemaphore(blit_pool.workers[i].start);
+	}
+	if ( blit_pool.done ) {
+		SDL_DestroySemaphore(blit_pool.done);
+	}
+	if ( blit_pool.lock ) {
+		SDL_DestroyMutex(blit_pool.lock);
+	}
+	SDL_memset(&blit_pool, 0, sizeof(blit_pool));
+}
+
+int SDL_RunBands(SDL_BandFunc func, void *data, int rows, int align, int pixels)
+{
+	int bands, units, per, extra;
+	int first, count;
+	int i;
+
+	if ( !blit_pool.num_workers || pixels < blit_pool.min_pixels ) {
+		return(0);
+	}
+	bands = rows / MIN_BLIT_BAND_ROWS;
+	if ( bands > blit_pool.num_workers + 1 ) {
+		bands = blit_pool.num_workers + 1;
+	}
+	units = rows / align;
+	if ( bands > units ) {
+		bands = units;
+	}
+	if ( bands < 2 ) {
+		return(0);
+	}
+	per = units / bands;
+	extra = units % bands;
+
+	SDL_mutexP(blit_pool.lock);
+	first = 0;
+	for ( i = 0; i < bands; ++i ) {
+		count = (per + (i < extra)) * align;
+		if ( i == bands-1 ) {
+			/* The last band also takes any rows left over */
+			func(data, first, rows - first);
+		} else {
+			SDL_BlitWorker *worker = &blit_pool.workers[i];
+
+			worker->func = func;
+			worker->data = data;
+			worker->first = first;
+			worker->count = count;
+			SDL_SemPost(worker->start);
+		}
+		first += count;
+	}
+	for ( i = 0; i < bands-1; ++i ) {
+		SDL_SemWait(blit_pool.done);
+	}
+	SDL_mutexV(blit_pool.lock);
+
+	return(1);
+}
+
+typedef struct {
+	SDL_loblit blit;
+	SDL_BlitInfo *info;
+	int s_pitch;
+	int d_pitch;
+} SDL_BlitBands;
+
+static void SDL_BlitBand(void *data, int first, int count)
+{
+	SDL_BlitBands *bands = (SDL_BlitBands *)data;
+	SDL_BlitInfo info = *bands->info;
+
+	info.s_pixels += first * bands->s_pitch;
+	info.d_pixels += first * bands->d_pitch;
+	info.s_height = info.d_height = count;
+	bands->blit(&info);
+}
+
+/* Split a large blit into bands of rows and run them in parallel.
+   Returns 0 if the blit should be run on this thread as usual. */
+static int SDL_ThreadedBlit(SDL_Surface *src, SDL_Surface *dst,
+			    SDL_loblit RunBlit, SDL_BlitInfo *info)
+{
+	SDL_BlitBands bands;
+
+	/* Overlapping blits depend on the order rows are copied in, and
+	   bitmap sources don't advance a whole pitch per row */
+	if ( src == dst || src->format->BitsPerPixel < 8 ) {
+		return(0);
+	}
+	bands.blit = RunBlit;
+	bands.info = info;
+	bands.s_pitch = info->s_width * src->format->BytesPerPixel + info->s_skip;
+	bands.d_pitch = info->d_width * dst->format->BytesPerPixel + info->d_skip;
+	return SDL_RunBands(SDL_BlitBand, &bands, info->d_height, 1,
+			    info->d_width * info->d_height);
+}
+#else
+void SDL_InitBlitThreads(void)
+{
+}
+
+void SDL_QuitBlitThreads(void)
+{
+}
+
+int SDL_RunBands(SDL_BandFunc func, void *data, int rows, int align, int pixels)
+{
+	return(0);
+}
+
+#define SDL_ThreadedBlit(src, dst, RunBlit, info)	0
+#endif /* !SDL_THREADS_DISABLED */
+
 /* The general purpose software blit routine */
 static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
 			SDL_Surface *dst, SDL_Rect *dstrect)
@@ -62,7 +285,7 @@ static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
 	/* Lock the source if it's in hardware */
 	src_locked = 0;
 	if ( SDL_MUSTLOCK(src) ) {
-		if ( SDL_LockSurface(src) < 0 ) {
+		if ( SDL_LockSurfaceReadOnly(src) < 0 ) {
 			okay = 0;
 		} else {
 			src_locked = 1;
@@ -94,7 +317,9 @@ static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
 		RunBlit = src->map->sw_data->blit;
 
 		/* Run the actual software blit */
-		RunBlit(&info);
+		if ( !SDL_ThreadedBlit(src, dst, RunBlit, &info) ) {
+			RunBlit(&info);
+		}
 	}
 
 	/* We need to unlock the surfaces if they're locked */
@@ -108,6 +333,44 @@ static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
 	return(okay ? 0 : -1);
 }
 
+/* Switch to the RLE blitter once the surface has been encoded */
+static int SDL_LazyRLEBlit(SDL_Surface *src, SDL_Rect *srcrect,
+			   SDL_Surface *dst, SDL_Rect *dstrect)
+{
+	switch (SDL_RLESurface(src)) {
+	    case 0:
+		return(src->map->sw_blit(src, srcrect, dst, dstrect));
+	    case -1:
+		src->map->sw_blit = SDL_SoftBlit;
+		break;
+	    default:
+		/* Still being encoded in the background */
+		break;
+	}
+	return(SDL_SoftBlit(src, srcrect, dst, dstrect));
+}
+
+int SDL_PrepareRLE(SDL_Surface *surface, SDL_Surface *dst)
+{
+	/* Make sure the blit mapping is valid, as in SDL_LowerBlit() */
+	if ( (surface->map->dst != dst) ||
+	     (surface->map->dst->format_version != surface->map->format_version) ) {
+		if ( SDL_MapSurface(surface, dst) < 0 ) {
+			return(-1);
+		}
+	}
+	if ( surface->map->sw_blit == SDL_RLEBlit ||
+	     surface->map->sw_blit == SDL_RLEAlphaBlit ) {
+		return(0);
+	}
+	if ( surface->map->sw_blit != SDL_LazyRLEBlit ||
+	     SDL_RLESurface(surface) < 0 ) {
+		SDL_SetError("Surface can't be RLE accelerated for this destination");
+		return(-1);
+	}
+	return(0);
+}
+
 #ifdef MMX_ASMBLIT
 static __inline__ void SDL_memcpyMMX(Uint8 *to, const Uint8 *from, int len)
 {
@@ -229,16 +492,38 @@ static void SDL_BlitCopyOverlap(SDL_BlitInfo *info)
 	}
 }
 
+static int SDL_SameLayout(const SDL_PixelFormat *a, const SDL_PixelFormat *b)
+{
+	return(a->BytesPerPixel == b->BytesPerPixel &&
+	       a->Rmask == b->Rmask && a->Gmask == b->Gmask &&
+	       a->Bmask == b->Bmask && a->Amask == b->Amask);
+}
+
+/* Look up the specialized version of a generic blitter for a surface,
+   returning the generic one if there isn't one for its formats */
+SDL_loblit SDL_FindAutoBlit(const SDL_AutoBlit *table, SDL_Surface *surface,
+			    SDL_loblit generic)
+{
+	const SDL_PixelFormat *srcfmt = surface->format;
+	const SDL_PixelFormat *dstfmt = surface->map->dst->format;
+
+	for ( ; table->blit; ++table ) {
+		if ( SDL_SameLayout(&table->src, srcfmt) &&
+		     SDL_SameLayout(&table->dst, dstfmt) ) {
+			return(table->blit);
+		}
+	}
+	return(generic);
+}
+
 /* Figure out which of many blit routines to set up on a surface */
 int SDL_CalculateBlit(SDL_Surface *surface)
 {
 	int blit_index;
 
-	/* Clean everything out to start */
-	if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
-		SDL_UnRLESurface(surface, 1);
-	}
+	/* Clean everything out to start (RLE encodings stay cached) */
 	surface->map->sw_blit = NULL;
+	surface->map->sw_data->aux_data = NULL;
 
 	/* Figure out if an accelerated hardware blit is possible */
 	surface->flags &= ~SDL_HWACCEL;
@@ -341,14 +626,11 @@ int SDL_CalculateBlit(SDL_Surface *surface)
 	if(surface->flags & SDL_RLEACCELOK
 	   && (surface->flags & SDL_HWACCEL) != SDL_HWACCEL) {
 
-	        if(surface->map->identity
-		   && (blit_index == 1
-		       || (blit_index == 3 && !surface->format->Amask))) {
-		        if ( SDL_RLESurface(surface) == 0 )
-			        surface->map->sw_blit = SDL_RLEBlit;
-		} else if(blit_index == 2 && surface->format->Amask) {
-		        if ( SDL_RLESurface(surface) == 0 )
-			        surface->map->sw_blit = SDL_RLEAlphaBlit;
+	        if((surface->map->identity
+		    && (blit_index == 1
+			|| (blit_index == 3 && !surface->format->Amask)))
+		   || (blit_index == 2 && surface->format->Amask)) {
+		        surface->map->sw_blit = SDL_LazyRLEBlit;
 		}
 	}
 	
@@ -26,6 +26,35 @@
 
 #include "SDL_endian.h"
 
+/*
+  SSE2 is always there on x86-64, so those intrinsics need no extra compiler
+   flags.  The SSSE3 and AVX2 paths are compiled with a per-function target
+   attribute and only picked when SDL_HasSSSE3()/SDL_HasAVX2() say the CPU
+   (and OS) support them.  NEON is a compile-time choice.
+*/
+#if SDL_ASSEMBLY_ROUTINES && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__SSE2__))
+#  define SSE2_BLIT 1
+#  if (__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) || \
+      (defined(__clang__) && ((__clang_major__ > 3) || \
+       (__clang_major__ == 3 && __clang_minor__ >= 8)))
+#    define SSSE3_BLIT 1
+#    define AVX2_BLIT 1
+#  endif
+#endif
+#if SDL_ASSEMBLY_ROUTINES && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#  define NEON_BLIT 1
+#endif
+
+#if AVX2_BLIT
+#include <immintrin.h>
+#elif SSE2_BLIT
+#include <emmintrin.h>
+#endif
+#if NEON_BLIT
+#include <arm_neon.h>
+#endif
+
 /* The structure passed to the low level blit functions */
 typedef struct {
 	Uint8 *s_pixels;
@@ -49,8 +78,12 @@ typedef void (*SDL_loblit)(SDL_BlitInfo *info);
 struct private_swaccel {
 	SDL_loblit blit;
 	void *aux_data;
+	struct SDL_RLEEntry *rle_cache;
 };
 
+/* RLE encodings of a surface, see SDL_RLEaccel.c */
+typedef struct SDL_RLEEntry SDL_RLEEntry;
+
 /* Blit mapping definition */
 typedef struct SDL_BlitMap {
 	SDL_Surface *dst;
@@ -64,11 +97,79 @@ typedef struct SDL_BlitMap {
 	/* the version count matches the destination; mismatch indicates
 	   an invalid mapping */
         unsigned int format_version;
+
+	/* earlier mappings to other destinations, most recently used first */
+	struct SDL_BlitMap *next;
 } SDL_BlitMap;
 
 
 /* Functions found in SDL_blit.c */
 extern int SDL_CalculateBlit(SDL_Surface *surface);
+extern void SDL_InitBlitThreads(void);
+extern void SDL_QuitBlitThreads(void);
+
+/* Run rows [first, first+count) of some software drawing */
+typedef void (*SDL_BandFunc)(void *data, int first, int count);
+
+/* Split 'rows' rows into bands, each a multiple of 'align' rows except
+   the last, and run them in parallel on the blit threads.  Returns 0 if
+   the work is too small or there are no threads, so the caller should
+   run all the rows itself. */
+extern int SDL_RunBands(SDL_BandFunc func, void *data,
+			int rows, int align, int pixels);
+
+/*
+ * Constant pixel layouts, in SDL_PixelFormat field order.  The generic
+ * blitters are templates over their source and destination formats, and
+ * instantiating them with one of these turns every mask, shift and loss
+ * into an immediate.  The surface's colorkey and alpha are always read
+ * from the real format at run time.
+ */
+#define SDL_AUTOFMT_RGB555	{ NULL, 15, 2, 3, 3, 3, 8, 10, 5, 0, 0, \
+				  0x00007C00, 0x000003E0, 0x0000001F, 0, 0, 0 }
+#define SDL_AUTOFMT_RGB565	{ NULL, 16, 2, 3, 2, 3, 8, 11, 5, 0, 0, \
+				  0x0000F800, 0x000007E0, 0x0000001F, 0, 0, 0 }
+#define SDL_AUTOFMT_RGB888	{ NULL, 24, 3, 0, 0, 0, 8, 16, 8, 0, 0, \
+				  0x00FF0000, 0x0000FF00, 0x000000FF, 0, 0, 0 }
+#define SDL_AUTOFMT_BGR888	{ NULL, 24, 3, 0, 0, 0, 8, 0, 8, 16, 0, \
+				  0x000000FF, 0x0000FF00, 0x00FF0000, 0, 0, 0 }
+#define SDL_AUTOFMT_XRGB8888	{ NULL, 32, 4, 0, 0, 0, 8, 16, 8, 0, 0, \
+				  0x00FF0000, 0x0000FF00, 0x000000FF, 0, 0, 0 }
+#define SDL_AUTOFMT_XBGR8888	{ NULL, 32, 4, 0, 0, 0, 8, 0, 8, 16, 0, \
+				  0x000000FF, 0x0000FF00, 0x00FF0000, 0, 0, 0 }
+#define SDL_AUTOFMT_ARGB8888	{ NULL, 32, 4, 0, 0, 0, 0, 16, 8, 0, 24, \
+				  0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000, 0, 0 }
+#define SDL_AUTOFMT_ABGR8888	{ NULL, 32, 4, 0, 0, 0, 0, 0, 8, 16, 24, \
+				  0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000, 0, 0 }
+#define SDL_AUTOFMT_RGBA8888	{ NULL, 32, 4, 0, 0, 0, 0, 24, 16, 8, 0, \
+				  0xFF000000, 0x00FF0000, 0x0000FF00, 0x000000FF, 0, 0 }
+#define SDL_AUTOFMT_BGRA8888	{ NULL, 32, 4, 0, 0, 0, 0, 8, 16, 24, 0, \
+				  0x0000FF00, 0x00FF0000, 0xFF000000, 0x000000FF, 0, 0 }
+
+/* Define generic_src_dst(), which instantiates the template behind the
+   generic blitter with two constant layouts */
+#define SDL_AUTO_BLIT(generic, template, src, dst)			\
+static void generic##_##src##_##dst(SDL_BlitInfo *info)			\
+{									\
+	const SDL_PixelFormat srcauto = SDL_AUTOFMT_##src;		\
+	const SDL_PixelFormat dstauto = SDL_AUTOFMT_##dst;		\
+	template(info, &srcauto, &dstauto);				\
+}
+
+/* A table of such blitters, ended by SDL_AUTO_BLIT_END */
+typedef struct {
+	SDL_PixelFormat src;
+	SDL_PixelFormat dst;
+	SDL_loblit blit;
+} SDL_AutoBlit;
+
+#define SDL_AUTO_BLIT_ENTRY(generic, template, src, dst)		\
+	{ SDL_AUTOFMT_##src, SDL_AUTOFMT_##dst, generic##_##src##_##dst },
+#define SDL_AUTO_BLIT_END	{ { NULL }, { NULL }, NULL }
+
+/* Find the blitter in such a table for a surface (in SDL_blit.c) */
+extern SDL_loblit SDL_FindAutoBlit(const SDL_AutoBlit *table,
+				   SDL_Surface *surface, SDL_loblit generic);
 
 /* Functions found in SDL_blit_{0,1,N,A}.c */
 extern SDL_loblit SDL_CalculateBlit0(SDL_Surface *surface, int complex);
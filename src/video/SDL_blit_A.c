@@ -1524,6 +1524,154 @@ static void BlitRGBtoRGBSurfaceAlpha(SDL_BlitInfo *info)
 	}
 }
 
+#if SSE2_BLIT || NEON_BLIT
+/*
+ * Per-surface alpha blend of one 32-bit pixel with RGB in the low three
+ * bytes.  Each channel is (s*a + d*(256-a)) >> 8, the same as
+ * d + ((s-d)*a >> 8) above (and the 50% average for a == 128), and the
+ * unused byte is set from 'opaque'.  The vector versions compute the
+ * same thing.  Other layouts are left to BlitNtoNSurfaceAlpha, which
+ * rounds differently.
+ */
+static __inline__ Uint32 BlendSurface32(Uint32 s, Uint32 d,
+					Uint32 alpha, Uint32 opaque)
+{
+	Uint32 result = opaque;
+	int shift;
+
+	for(shift = 0; shift < 32; shift += 8) {
+	    Uint32 c = ((s >> shift) & 0xff) * alpha
+		     + ((d >> shift) & 0xff) * (256 - alpha);
+	    result |= ((c >> 8) & 0xff) << shift;
+	}
+	return result;
+}
+#endif
+
+#if SSE2_BLIT
+/* SSE2 RGB888->(A)RGB888 blending with surface alpha, 4 pixels at a time */
+static void BlitRGBtoRGBSurfaceAlphaSSE2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	Uint32 alpha = info->src->alpha;
+	Uint32 opaque = ~(info->dst->Rmask | info->dst->Gmask | info->dst->Bmask);
+	__m128i va = _mm_set1_epi16((short)alpha);
+	__m128i vinva = _mm_set1_epi16((short)(256 - alpha));
+	__m128i vopaque = _mm_set1_epi32(opaque);
+	__m128i zero = _mm_setzero_si128();
+
+	while(height--) {
+	    int n = width;
+	    for(; n >= 4; n -= 4, srcp += 4, dstp += 4) {
+		__m128i s = _mm_loadu_si128((__m128i *)srcp);
+		__m128i d = _mm_loadu_si128((__m128i *)dstp);
+		__m128i lo = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), va),
+			_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), vinva));
+		__m128i hi = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), va),
+			_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), vinva));
+		d = _mm_packus_epi16(_mm_srli_epi16(lo, 8),
+				     _mm_srli_epi16(hi, 8));
+		_mm_storeu_si128((__m128i *)dstp, _mm_or_si128(d, vopaque));
+	    }
+	    for(; n > 0; --n, ++srcp, ++dstp) {
+		*dstp = BlendSurface32(*srcp, *dstp, alpha, opaque);
+	    }
+	    srcp += srcskip;
+	    dstp += dstskip;
+	}
+}
+#endif /* SSE2_BLIT */
+
+#if AVX2_BLIT
+/* AVX2 RGB888->(A)RGB888 blending with surface alpha, 8 pixels at a time */
+static __attribute__((target("avx2")))
+void BlitRGBtoRGBSurfaceAlphaAVX2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	Uint32 alpha = info->src->alpha;
+	Uint32 opaque = ~(info->dst->Rmask | info->dst->Gmask | info->dst->Bmask);
+	__m256i va = _mm256_set1_epi16((short)alpha);
+	__m256i vinva = _mm256_set1_epi16((short)(256 - alpha));
+	__m256i vopaque = _mm256_set1_epi32(opaque);
+	__m256i zero = _mm256_setzero_si256();
+
+	while(height--) {
+	    int n = width;
+	    for(; n >= 8; n -= 8, srcp += 8, dstp += 8) {
+		__m256i s = _mm256_loadu_si256((__m256i *)srcp);
+		__m256i d = _mm256_loadu_si256((__m256i *)dstp);
+		__m256i lo = _mm256_add_epi16(
+			_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), va),
+			_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), vinva));
+		__m256i hi = _mm256_add_epi16(
+			_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), va),
+			_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), vinva));
+		d = _mm256_packus_epi16(_mm256_srli_epi16(lo, 8),
+					_mm256_srli_epi16(hi, 8));
+		_mm256_storeu_si256((__m256i *)dstp,
+				    _mm256_or_si256(d, vopaque));
+	    }
+	    for(; n > 0; --n, ++srcp, ++dstp) {
+		*dstp = BlendSurface32(*srcp, *dstp, alpha, opaque);
+	    }
+	    srcp += srcskip;
+	    dstp += dstskip;
+	}
+}
+#endif /* AVX2_BLIT */
+
+#if NEON_BLIT
+/* NEON RGB888->(A)RGB888 blending with surface alpha, 4 pixels at a time */
+static void BlitRGBtoRGBSurfaceAlphaNEON(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	Uint32 alpha = info->src->alpha;
+	Uint32 opaque = ~(info->dst->Rmask | info->dst->Gmask | info->dst->Bmask);
+	uint8x8_t va = vdup_n_u8((Uint8)alpha);
+	uint8x8_t vinva = vdup_n_u8((Uint8)(255 - alpha));
+	uint8x16_t vopaque = vreinterpretq_u8_u32(vdupq_n_u32(opaque));
+
+	while(height--) {
+	    int n = width;
+	    for(; n >= 4; n -= 4, srcp += 4, dstp += 4) {
+		uint8x16_t s = vreinterpretq_u8_u32(vld1q_u32(srcp));
+		uint8x16_t d = vreinterpretq_u8_u32(vld1q_u32(dstp));
+		/* s*a + d*(255-a) + d == s*a + d*(256-a) */
+		uint16x8_t lo = vmull_u8(vget_low_u8(s), va);
+		uint16x8_t hi = vmull_u8(vget_high_u8(s), va);
+		lo = vmlal_u8(lo, vget_low_u8(d), vinva);
+		hi = vmlal_u8(hi, vget_high_u8(d), vinva);
+		lo = vaddw_u8(lo, vget_low_u8(d));
+		hi = vaddw_u8(hi, vget_high_u8(d));
+		d = vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8));
+		vst1q_u32(dstp, vreinterpretq_u32_u8(vorrq_u8(d, vopaque)));
+	    }
+	    for(; n > 0; --n, ++srcp, ++dstp) {
+		*dstp = BlendSurface32(*srcp, *dstp, alpha, opaque);
+	    }
+	    srcp += srcskip;
+	    dstp += dstskip;
+	}
+}
+#endif /* NEON_BLIT */
+
 /* fast ARGB888->(A)RGB888 blending with pixel alpha */
 static void BlitRGBtoRGBPixelAlpha(SDL_BlitInfo *info)
 {
@@ -1573,6 +1721,197 @@ static void BlitRGBtoRGBPixelAlpha(SDL_BlitInfo *info)
 	}
 }
 
+#if SSE2_BLIT
+/*
+ * Blend one 32-bit pixel with byte-aligned channels, keeping the
+ * destination alpha.  Each channel is (s*a + d*(256-a) + bias) >> 8,
+ * which is d + (((s-d)*a + bias) >> 8) in 16 bits.  With bias 0 and
+ * alpha 255 counted as 256 that is BlitRGBtoRGBPixelAlpha(), and with
+ * bias 255 it is ALPHA_BLEND() as in BlitNtoNPixelAlpha().  The vector
+ * versions below compute the same thing.
+ */
+static __inline__ Uint32 BlendPixel32(Uint32 s, Uint32 d, Uint32 amask,
+				      int ashift, Uint32 bias)
+{
+	Uint32 alpha = (s >> ashift) & 0xff;
+	Uint32 result = d & amask;
+	int shift;
+
+	if(alpha == 255 && bias == 0)
+	    alpha = 256;
+	for(shift = 0; shift < 32; shift += 8) {
+	    Uint32 sc = (s >> shift) & 0xff;
+	    Uint32 dc = (d >> shift) & 0xff;
+	    Uint32 c = (sc * alpha + dc * (256 - alpha) + bias) >> 8;
+	    result |= (c << shift) & ~amask;
+	}
+	return result;
+}
+
+/*
+ * blend 4 pixels, 16 bits per channel in two halves; alpha equal to
+ * 'opaque' counts as 256
+ */
+static __inline__ __m128i BlendPixelsSSE2(__m128i s, __m128i d,
+					  __m128i amask, __m128i ashift,
+					  __m128i bias, __m128i opaque)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i c256 = _mm_set1_epi16(256);
+	__m128i a, alo, ahi, lo, hi;
+
+	a = _mm_and_si128(_mm_srl_epi32(s, ashift), _mm_set1_epi32(0xff));
+	a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+	a = _mm_sub_epi16(a, _mm_cmpeq_epi16(a, opaque));
+	alo = _mm_unpacklo_epi32(a, a);
+	ahi = _mm_unpackhi_epi32(a, a);
+
+	lo = _mm_add_epi16(
+		_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), alo),
+		_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero),
+				_mm_sub_epi16(c256, alo)));
+	hi = _mm_add_epi16(
+		_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), ahi),
+		_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero),
+				_mm_sub_epi16(c256, ahi)));
+	lo = _mm_srli_epi16(_mm_add_epi16(lo, bias), 8);
+	hi = _mm_srli_epi16(_mm_add_epi16(hi, bias), 8);
+
+	return _mm_or_si128(_mm_andnot_si128(amask, _mm_packus_epi16(lo, hi)),
+			    _mm_and_si128(d, amask));
+}
+
+/* SSE2 (A)RGB888->(A)RGB888 blending with pixel alpha, 4 pixels at a time */
+static void BlitRGBtoRGBPixelAlphaSSE2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	Uint32 amask = info->src->Amask;
+	int ashift = info->src->Ashift;
+	/* round the way the C blitter for this format does */
+	int exact = (amask == 0xff000000);
+	Uint32 bias = exact ? 0 : 255;
+	__m128i vamask = _mm_set1_epi32(amask);
+	__m128i vashift = _mm_cvtsi32_si128(ashift);
+	__m128i vbias = _mm_set1_epi16(bias);
+	__m128i vopaque = _mm_set1_epi16(exact ? 255 : -1);
+	__m128i zero = _mm_setzero_si128();
+
+	while(height--) {
+	    int n = width;
+	    for(; n >= 4; n -= 4, srcp += 4, dstp += 4) {
+		__m128i s = _mm_loadu_si128((__m128i *)srcp);
+		__m128i sa = _mm_and_si128(s, vamask);
+		__m128i d;
+
+		/* skip fully transparent runs, copy fully opaque ones */
+		if(_mm_movemask_epi8(_mm_cmpeq_epi32(sa, zero)) == 0xffff)
+		    continue;
+		d = _mm_loadu_si128((__m128i *)dstp);
+		if(exact &&
+		   _mm_movemask_epi8(_mm_cmpeq_epi32(sa, vamask)) == 0xffff)
+		    d = _mm_or_si128(_mm_andnot_si128(vamask, s),
+				     _mm_and_si128(d, vamask));
+		else
+		    d = BlendPixelsSSE2(s, d, vamask, vashift,
+					vbias, vopaque);
+		_mm_storeu_si128((__m128i *)dstp, d);
+	    }
+	    for(; n > 0; --n, ++srcp, ++dstp) {
+		*dstp = BlendPixel32(*srcp, *dstp, amask, ashift, bias);
+	    }
+	    srcp += srcskip;
+	    dstp += dstskip;
+	}
+}
+#endif /* SSE2_BLIT */
+
+#if AVX2_BLIT
+/* the same as BlendPixelsSSE2(), 8 pixels at a time */
+static __inline__ __attribute__((target("avx2")))
+__m256i BlendPixelsAVX2(__m256i s, __m256i d, __m256i amask, __m128i ashift,
+			__m256i bias, __m256i opaque)
+{
+	__m256i zero = _mm256_setzero_si256();
+	__m256i c256 = _mm256_set1_epi16(256);
+	__m256i a, alo, ahi, lo, hi;
+
+	a = _mm256_and_si256(_mm256_srl_epi32(s, ashift),
+			     _mm256_set1_epi32(0xff));
+	a = _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+	a = _mm256_sub_epi16(a, _mm256_cmpeq_epi16(a, opaque));
+	alo = _mm256_unpacklo_epi32(a, a);
+	ahi = _mm256_unpackhi_epi32(a, a);
+
+	lo = _mm256_add_epi16(
+		_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), alo),
+		_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero),
+				   _mm256_sub_epi16(c256, alo)));
+	hi = _mm256_add_epi16(
+		_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), ahi),
+		_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero),
+				   _mm256_sub_epi16(c256, ahi)));
+	lo = _mm256_srli_epi16(_mm256_add_epi16(lo, bias), 8);
+	hi = _mm256_srli_epi16(_mm256_add_epi16(hi, bias), 8);
+
+	/* unpack and pack both work within 128-bit lanes, so this lines up */
+	return _mm256_or_si256(
+		_mm256_andnot_si256(amask, _mm256_packus_epi16(lo, hi)),
+		_mm256_and_si256(d, amask));
+}
+
+/* AVX2 (A)RGB888->(A)RGB888 blending with pixel alpha, 8 pixels at a time */
+static __attribute__((target("avx2")))
+void BlitRGBtoRGBPixelAlphaAVX2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	Uint32 amask = info->src->Amask;
+	int ashift = info->src->Ashift;
+	int exact = (amask == 0xff000000);
+	Uint32 bias = exact ? 0 : 255;
+	__m256i vamask = _mm256_set1_epi32(amask);
+	__m128i vashift = _mm_cvtsi32_si128(ashift);
+	__m256i vbias = _mm256_set1_epi16(bias);
+	__m256i vopaque = _mm256_set1_epi16(exact ? 255 : -1);
+	__m256i zero = _mm256_setzero_si256();
+
+	while(height--) {
+	    int n = width;
+	    for(; n >= 8; n -= 8, srcp += 8, dstp += 8) {
+		__m256i s = _mm256_loadu_si256((__m256i *)srcp);
+		__m256i sa = _mm256_and_si256(s, vamask);
+		__m256i d;
+
+		if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(sa, zero)) == -1)
+		    continue;
+		d = _mm256_loadu_si256((__m256i *)dstp);
+		if(exact &&
+		   _mm256_movemask_epi8(_mm256_cmpeq_epi32(sa, vamask)) == -1)
+		    d = _mm256_or_si256(_mm256_andnot_si256(vamask, s),
+					_mm256_and_si256(d, vamask));
+		else
+		    d = BlendPixelsAVX2(s, d, vamask, vashift,
+					vbias, vopaque);
+		_mm256_storeu_si256((__m256i *)dstp, d);
+	    }
+	    for(; n > 0; --n, ++srcp, ++dstp) {
+		*dstp = BlendPixel32(*srcp, *dstp, amask, ashift, bias);
+	    }
+	    srcp += srcskip;
+	    dstp += dstskip;
+	}
+}
+#endif /* AVX2_BLIT */
+
 #if GCC_ASMBLIT
 /* fast (as in MMX with prefetch) ARGB888->(A)RGB888 blending with pixel alpha */
 static void BlitRGBtoRGBPixelAlphaMMX3DNOW(SDL_BlitInfo *info)
@@ -2497,6 +2836,221 @@ static void Blit555to555SurfaceAlpha(SDL_BlitInfo *info)
 	}
 }
 
+#if SSE2_BLIT || NEON_BLIT
+/*
+ * Per-surface alpha blend of one RGB565 or RGB555 pixel: each channel is
+ * d + ((s-d)*alpha >> 5) with 5-bit alpha.  'rshift' is 11 or 10 and
+ * 'gmask' 0x3f or 0x1f.  Alpha 128 goes to Blit16to16SurfaceAlpha128(),
+ * as in the C blitters, since that carries the unused bit of RGB555 into
+ * red.
+ */
+static __inline__ Uint16 BlendSurface16(Uint32 s, Uint32 d, int alpha,
+					int rshift, int gmask)
+{
+	int sr = (s >> rshift) & 0x1f, dr = (d >> rshift) & 0x1f;
+	int sg = (s >> 5) & gmask, dg = (d >> 5) & gmask;
+	int sb = s & 0x1f, db = d & 0x1f;
+
+	dr += (sr - dr) * alpha >> 5;
+	dg += (sg - dg) * alpha >> 5;
+	db += (sb - db) * alpha >> 5;
+	return (Uint16)((dr << rshift) | (dg << 5) | db);
+}
+#endif
+
+#if SSE2_BLIT
+/* SSE2 RGB565/RGB555 blending with surface alpha, 8 pixels at a time */
+static __inline__ void Blit16to16SurfaceAlphaSSE2(SDL_BlitInfo *info,
+						  int rshift, int gmask)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint16 *srcp = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip >> 1;
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip >> 1;
+	int alpha = info->src->alpha >> 3;	/* downscale alpha to 5 bits */
+	__m128i va = _mm_set1_epi16((short)alpha);
+	__m128i m5 = _mm_set1_epi16(0x1f);
+	__m128i mg = _mm_set1_epi16((short)gmask);
+
+	while(height--) {
+	    int n = width;
+	    for(; n >= 8; n -= 8, srcp += 8, dstp += 8) {
+		__m128i s = _mm_loadu_si128((__m128i *)srcp);
+		__m128i d = _mm_loadu_si128((__m128i *)dstp);
+		__m128i sr = _mm_and_si128(_mm_srli_epi16(s, rshift), m5);
+		__m128i dr = _mm_and_si128(_mm_srli_epi16(d, rshift), m5);
+		__m128i sg = _mm_and_si128(_mm_srli_epi16(s, 5), mg);
+		__m128i dg = _mm_and_si128(_mm_srli_epi16(d, 5), mg);
+		__m128i sb = _mm_and_si128(s, m5);
+		__m128i db = _mm_and_si128(d, m5);
+
+		dr = _mm_add_epi16(dr, _mm_srai_epi16(
+			_mm_mullo_epi16(_mm_sub_epi16(sr, dr), va), 5));
+		dg = _mm_add_epi16(dg, _mm_srai_epi16(
+			_mm_mullo_epi16(_mm_sub_epi16(sg, dg), va), 5));
+		db = _mm_add_epi16(db, _mm_srai_epi16(
+			_mm_mullo_epi16(_mm_sub_epi16(sb, db), va), 5));
+		d = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(dr, rshift),
+					      _mm_slli_epi16(dg, 5)), db);
+		_mm_storeu_si128((__m128i *)dstp, d);
+	    }
+	    for(; n > 0; --n, ++srcp, ++dstp) {
+		*dstp = BlendSurface16(*srcp, *dstp, alpha, rshift, gmask);
+	    }
+	    srcp += srcskip;
+	    dstp += dstskip;
+	}
+}
+
+static void Blit565to565SurfaceAlphaSSE2(SDL_BlitInfo *info)
+{
+	if(info->src->alpha == 128)
+		Blit16to16SurfaceAlpha128(info, 0xf7de);
+	else
+		Blit16to16SurfaceAlphaSSE2(info, 11, 0x3f);
+}
+
+static void Blit555to555SurfaceAlphaSSE2(SDL_BlitInfo *info)
+{
+	if(info->src->alpha == 128)
+		Blit16to16SurfaceAlpha128(info, 0xfbde);
+	else
+		Blit16to16SurfaceAlphaSSE2(info, 10, 0x1f);
+}
+#endif /* SSE2_BLIT */
+
+#if AVX2_BLIT
+/* AVX2 RGB565/RGB555 blending with surface alpha, 16 pixels at a time */
+static __inline__ __attribute__((target("avx2")))
+void Blit16to16SurfaceAlphaAVX2(SDL_BlitInfo *info, int rshift, int gmask)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint16 *srcp = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip >> 1;
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip >> 1;
+	int alpha = info->src->alpha >> 3;	/* downscale alpha to 5 bits */
+	__m256i va = _mm256_set1_epi16((short)alpha);
+	__m256i m5 = _mm256_set1_epi16(0x1f);
+	__m256i mg = _mm256_set1_epi16((short)gmask);
+
+	while(height--) {
+	    int n = width;
+	    for(; n >= 16; n -= 16, srcp += 16, dstp += 16) {
+		__m256i s = _mm256_loadu_si256((__m256i *)srcp);
+		__m256i d = _mm256_loadu_si256((__m256i *)dstp);
+		__m256i sr = _mm256_and_si256(_mm256_srli_epi16(s, rshift), m5);
+		__m256i dr = _mm256_and_si256(_mm256_srli_epi16(d, rshift), m5);
+		__m256i sg = _mm256_and_si256(_mm256_srli_epi16(s, 5), mg);
+		__m256i dg = _mm256_and_si256(_mm256_srli_epi16(d, 5), mg);
+		__m256i sb = _mm256_and_si256(s, m5);
+		__m256i db = _mm256_and_si256(d, m5);
+
+		dr = _mm256_add_epi16(dr, _mm256_srai_epi16(
+			_mm256_mullo_epi16(_mm256_sub_epi16(sr, dr), va), 5));
+		dg = _mm256_add_epi16(dg, _mm256_srai_epi16(
+			_mm256_mullo_epi16(_mm256_sub_epi16(sg, dg), va), 5));
+		db = _mm256_add_epi16(db, _mm256_srai_epi16(
+			_mm256_mullo_epi16(_mm256_sub_epi16(sb, db), va), 5));
+		d = _mm256_or_si256(_mm256_or_si256(
+			_mm256_slli_epi16(dr, rshift),
+			_mm256_slli_epi16(dg, 5)), db);
+		_mm256_storeu_si256((__m256i *)dstp, d);
+	    }
+	    for(; n > 0; --n, ++srcp, ++dstp) {
+		*dstp = BlendSurface16(*srcp, *dstp, alpha, rshift, gmask);
+	    }
+	    srcp += srcskip;
+	    dstp += dstskip;
+	}
+}
+
+static __attribute__((target("avx2")))
+void Blit565to565SurfaceAlphaAVX2(SDL_BlitInfo *info)
+{
+	if(info->src->alpha == 128)
+		Blit16to16SurfaceAlpha128(info, 0xf7de);
+	else
+		Blit16to16SurfaceAlphaAVX2(info, 11, 0x3f);
+}
+
+static __attribute__((target("avx2")))
+void Blit555to555SurfaceAlphaAVX2(SDL_BlitInfo *info)
+{
+	if(info->src->alpha == 128)
+		Blit16to16SurfaceAlpha128(info, 0xfbde);
+	else
+		Blit16to16SurfaceAlphaAVX2(info, 10, 0x1f);
+}
+#endif /* AVX2_BLIT */
+
+#if NEON_BLIT
+/* NEON RGB565/RGB555 blending with surface alpha, 8 pixels at a time */
+static __inline__ void Blit16to16SurfaceAlphaNEON(SDL_BlitInfo *info,
+						  int rshift, int gmask)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint16 *srcp = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip >> 1;
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip >> 1;
+	int alpha = info->src->alpha >> 3;	/* downscale alpha to 5 bits */
+	int16x8_t va = vdupq_n_s16((short)alpha);
+	int16x8_t vrshift = vdupq_n_s16((short)rshift);
+	int16x8_t vrshiftr = vdupq_n_s16((short)-rshift);
+	uint16x8_t m5 = vdupq_n_u16(0x1f);
+	uint16x8_t mg = vdupq_n_u16((Uint16)gmask);
+
+	while(height--) {
+	    int n = width;
+	    for(; n >= 8; n -= 8, srcp += 8, dstp += 8) {
+		uint16x8_t s = vld1q_u16(srcp);
+		uint16x8_t d = vld1q_u16(dstp);
+		int16x8_t sr = vreinterpretq_s16_u16(vandq_u16(vshlq_u16(s, vrshiftr), m5));
+		int16x8_t dr = vreinterpretq_s16_u16(vandq_u16(vshlq_u16(d, vrshiftr), m5));
+		int16x8_t sg = vreinterpretq_s16_u16(vandq_u16(vshrq_n_u16(s, 5), mg));
+		int16x8_t dg = vreinterpretq_s16_u16(vandq_u16(vshrq_n_u16(d, 5), mg));
+		int16x8_t sb = vreinterpretq_s16_u16(vandq_u16(s, m5));
+		int16x8_t db = vreinterpretq_s16_u16(vandq_u16(d, m5));
+
+		dr = vaddq_s16(dr, vshrq_n_s16(vmulq_s16(vsubq_s16(sr, dr), va), 5));
+		dg = vaddq_s16(dg, vshrq_n_s16(vmulq_s16(vsubq_s16(sg, dg), va), 5));
+		db = vaddq_s16(db, vshrq_n_s16(vmulq_s16(vsubq_s16(sb, db), va), 5));
+		d = vorrq_u16(vorrq_u16(
+			vshlq_u16(vreinterpretq_u16_s16(dr), vrshift),
+			vshlq_n_u16(vreinterpretq_u16_s16(dg), 5)),
+			vreinterpretq_u16_s16(db));
+		vst1q_u16(dstp, d);
+	    }
+	    for(; n > 0; --n, ++srcp, ++dstp) {
+		*dstp = BlendSurface16(*srcp, *dstp, alpha, rshift, gmask);
+	    }
+	    srcp += srcskip;
+	    dstp += dstskip;
+	}
+}
+
+static void Blit565to565SurfaceAlphaNEON(SDL_BlitInfo *info)
+{
+	if(info->src->alpha == 128)
+		Blit16to16SurfaceAlpha128(info, 0xf7de);
+	else
+		Blit16to16SurfaceAlphaNEON(info, 11, 0x3f);
+}
+
+static void Blit555to555SurfaceAlphaNEON(SDL_BlitInfo *info)
+{
+	if(info->src->alpha == 128)
+		Blit16to16SurfaceAlpha128(info, 0xfbde);
+	else
+		Blit16to16SurfaceAlphaNEON(info, 10, 0x1f);
+}
+#endif /* NEON_BLIT */
+
 /* fast ARGB8888->RGB565 blending with pixel alpha */
 static void BlitARGBto565PixelAlpha(SDL_BlitInfo *info)
 {
@@ -2585,141 +3139,235 @@ static void BlitARGBto555PixelAlpha(SDL_BlitInfo *info)
 }
 
 /* General (slow) N->N blending with per-surface alpha */
+#define BLIT_NTON_SURFACEALPHA(info, sfmt, dfmt)			\
+do {									\
+	int width = info->d_width;					\
+	int height = info->d_height;					\
+	Uint8 *src = info->s_pixels;					\
+	int srcskip = info->s_skip;					\
+	Uint8 *dst = info->d_pixels;					\
+	int dstskip = info->d_skip;					\
+	const SDL_PixelFormat *srcfmt = sfmt;				\
+	const SDL_PixelFormat *dstfmt = dfmt;				\
+	int srcbpp = srcfmt->BytesPerPixel;				\
+	int dstbpp = dstfmt->BytesPerPixel;				\
+	unsigned sA = info->src->alpha;					\
+	unsigned dA = dstfmt->Amask ? SDL_ALPHA_OPAQUE : 0;		\
+									\
+	if(sA) {							\
+	  while ( height-- ) {						\
+	    DUFFS_LOOP4(						\
+	    {								\
+		Uint32 Pixel;						\
+		unsigned sR;						\
+		unsigned sG;						\
+		unsigned sB;						\
+		unsigned dR;						\
+		unsigned dG;						\
+		unsigned dB;						\
+		DISEMBLE_RGB(src, srcbpp, srcfmt, Pixel, sR, sG, sB);	\
+		DISEMBLE_RGB(dst, dstbpp, dstfmt, Pixel, dR, dG, dB);	\
+		ALPHA_BLEND(sR, sG, sB, sA, dR, dG, dB);		\
+		ASSEMBLE_RGBA(dst, dstbpp, dstfmt, dR, dG, dB, dA);	\
+		src += srcbpp;						\
+		dst += dstbpp;						\
+	    },								\
+	    width);							\
+	    src += srcskip;						\
+	    dst += dstskip;						\
+	  }								\
+	}								\
+} while(0)
+
 static void BlitNtoNSurfaceAlpha(SDL_BlitInfo *info)
 {
-	int width = info->d_width;
-	int height = info->d_height;
-	Uint8 *src = info->s_pixels;
-	int srcskip = info->s_skip;
-	Uint8 *dst = info->d_pixels;
-	int dstskip = info->d_skip;
-	SDL_PixelFormat *srcfmt = info->src;
-	SDL_PixelFormat *dstfmt = info->dst;
-	int srcbpp = srcfmt->BytesPerPixel;
-	int dstbpp = dstfmt->BytesPerPixel;
-	unsigned sA = srcfmt->alpha;
-	unsigned dA = dstfmt->Amask ? SDL_ALPHA_OPAQUE : 0;
-
-	if(sA) {
-	  while ( height-- ) {
-	    DUFFS_LOOP4(
-	    {
-		Uint32 Pixel;
-		unsigned sR;
-		unsigned sG;
-		unsigned sB;
-		unsigned dR;
-		unsigned dG;
-		unsigned dB;
-		DISEMBLE_RGB(src, srcbpp, srcfmt, Pixel, sR, sG, sB);
-		DISEMBLE_RGB(dst, dstbpp, dstfmt, Pixel, dR, dG, dB);
-		ALPHA_BLEND(sR, sG, sB, sA, dR, dG, dB);
-		ASSEMBLE_RGBA(dst, dstbpp, dstfmt, dR, dG, dB, dA);
-		src += srcbpp;
-		dst += dstbpp;
-	    },
-	    width);
-	    src += srcskip;
-	    dst += dstskip;
-	  }
-	}
+	BLIT_NTON_SURFACEALPHA(info, info->src, info->dst);
 }
 
 /* General (slow) colorkeyed N->N blending with per-surface alpha */
+#define BLIT_NTON_SURFACEALPHA_KEY(info, sfmt, dfmt)			\
+do {									\
+	int width = info->d_width;					\
+	int height = info->d_height;					\
+	Uint8 *src = info->s_pixels;					\
+	int srcskip = info->s_skip;					\
+	Uint8 *dst = info->d_pixels;					\
+	int dstskip = info->d_skip;					\
+	const SDL_PixelFormat *srcfmt = sfmt;				\
+	const SDL_PixelFormat *dstfmt = dfmt;				\
+	Uint32 ckey = info->src->colorkey;				\
+	int srcbpp = srcfmt->BytesPerPixel;				\
+	int dstbpp = dstfmt->BytesPerPixel;				\
+	unsigned sA = info->src->alpha;					\
+	unsigned dA = dstfmt->Amask ? SDL_ALPHA_OPAQUE : 0;		\
+									\
+	while ( height-- ) {						\
+	    DUFFS_LOOP4(						\
+	    {								\
+		Uint32 Pixel;						\
+		unsigned sR;						\
+		unsigned sG;						\
+		unsigned sB;						\
+		unsigned dR;						\
+		unsigned dG;						\
+		unsigned dB;						\
+		RETRIEVE_RGB_PIXEL(src, srcbpp, Pixel);			\
+		if(sA && Pixel != ckey) {				\
+		    RGB_FROM_PIXEL(Pixel, srcfmt, sR, sG, sB);		\
+		    DISEMBLE_RGB(dst, dstbpp, dstfmt, Pixel, dR, dG, dB); \
+		    ALPHA_BLEND(sR, sG, sB, sA, dR, dG, dB);		\
+		    ASSEMBLE_RGBA(dst, dstbpp, dstfmt, dR, dG, dB, dA);	\
+		}							\
+		src += srcbpp;						\
+		dst += dstbpp;						\
+	    },								\
+	    width);							\
+	    src += srcskip;						\
+	    dst += dstskip;						\
+	}								\
+} while(0)
+
 static void BlitNtoNSurfaceAlphaKey(SDL_BlitInfo *info)
 {
-	int width = info->d_width;
-	int height = info->d_height;
-	Uint8 *src = info->s_pixels;
-	int srcskip = info->s_skip;
-	Uint8 *dst = info->d_pixels;
-	int dstskip = info->d_skip;
-	SDL_PixelFormat *srcfmt = info->src;
-	SDL_PixelFormat *dstfmt = info->dst;
-	Uint32 ckey = srcfmt->colorkey;
-	int srcbpp = srcfmt->BytesPerPixel;
-	int dstbpp = dstfmt->BytesPerPixel;
-	unsigned sA = srcfmt->alpha;
-	unsigned dA = dstfmt->Amask ? SDL_ALPHA_OPAQUE : 0;
-
-	while ( height-- ) {
-	    DUFFS_LOOP4(
-	    {
-		Uint32 Pixel;
-		unsigned sR;
-		unsigned sG;
-		unsigned sB;
-		unsigned dR;
-		unsigned dG;
-		unsigned dB;
-		RETRIEVE_RGB_PIXEL(src, srcbpp, Pixel);
-		if(sA && Pixel != ckey) {
-		    RGB_FROM_PIXEL(Pixel, srcfmt, sR, sG, sB);
-		    DISEMBLE_RGB(dst, dstbpp, dstfmt, Pixel, dR, dG, dB);
-		    ALPHA_BLEND(sR, sG, sB, sA, dR, dG, dB);
-		    ASSEMBLE_RGBA(dst, dstbpp, dstfmt, dR, dG, dB, dA);
-		}
-		src += srcbpp;
-		dst += dstbpp;
-	    },
-	    width);
-	    src += srcskip;
-	    dst += dstskip;
-	}
+	BLIT_NTON_SURFACEALPHA_KEY(info, info->src, info->dst);
 }
 
 /* General (slow) N->N blending with pixel alpha */
+#define BLIT_NTON_PIXELALPHA(info, sfmt, dfmt)				\
+do {									\
+	int width = info->d_width;					\
+	int height = info->d_height;					\
+	Uint8 *src = info->s_pixels;					\
+	int srcskip = info->s_skip;					\
+	Uint8 *dst = info->d_pixels;					\
+	int dstskip = info->d_skip;					\
+	const SDL_PixelFormat *srcfmt = sfmt;				\
+	const SDL_PixelFormat *dstfmt = dfmt;				\
+									\
+	int  srcbpp;							\
+	int  dstbpp;							\
+									\
+	/* Set up some basic variables */				\
+	srcbpp = srcfmt->BytesPerPixel;					\
+	dstbpp = dstfmt->BytesPerPixel;					\
+									\
+	/* FIXME: for 8bpp source alpha, this doesn't get opaque values	\
+	   quite right. for <8bpp source alpha, it gets them very wrong	\
+	   (check all macros!)						\
+	   It is unclear whether there is a good general solution that doesn't \
+	   need a branch (or a divide). */				\
+	while ( height-- ) {						\
+	    DUFFS_LOOP4(						\
+	    {								\
+		Uint32 Pixel;						\
+		unsigned sR;						\
+		unsigned sG;						\
+		unsigned sB;						\
+		unsigned dR;						\
+		unsigned dG;						\
+		unsigned dB;						\
+		unsigned sA;						\
+		unsigned dA;						\
+		DISEMBLE_RGBA(src, srcbpp, srcfmt, Pixel, sR, sG, sB, sA); \
+		if(sA) {						\
+		  DISEMBLE_RGBA(dst, dstbpp, dstfmt, Pixel, dR, dG, dB, dA); \
+		  ALPHA_BLEND(sR, sG, sB, sA, dR, dG, dB);		\
+		  ASSEMBLE_RGBA(dst, dstbpp, dstfmt, dR, dG, dB, dA);	\
+		}							\
+		src += srcbpp;						\
+		dst += dstbpp;						\
+	    },								\
+	    width);							\
+	    src += srcskip;						\
+	    dst += dstskip;						\
+	}								\
+} while(0)
+
 static void BlitNtoNPixelAlpha(SDL_BlitInfo *info)
 {
-	int width = info->d_width;
-	int height = info->d_height;
-	Uint8 *src = info->s_pixels;
-	int srcskip = info->s_skip;
-	Uint8 *dst = info->d_pixels;
-	int dstskip = info->d_skip;
-	SDL_PixelFormat *srcfmt = info->src;
-	SDL_PixelFormat *dstfmt = info->dst;
-
-	int  srcbpp;
-	int  dstbpp;
-
-	/* Set up some basic variables */
-	srcbpp = srcfmt->BytesPerPixel;
-	dstbpp = dstfmt->BytesPerPixel;
-
-	/* FIXME: for 8bpp source alpha, this doesn't get opaque values
-	   quite right. for <8bpp source alpha, it gets them very wrong
-	   (check all macros!)
-	   It is unclear whether there is a good general solution that doesn't
-	   need a branch (or a divide). */
-	while ( height-- ) {
-	    DUFFS_LOOP4(
-	    {
-		Uint32 Pixel;
-		unsigned sR;
-		unsigned sG;
-		unsigned sB;
-		unsigned dR;
-		unsigned dG;
-		unsigned dB;
-		unsigned sA;
-		unsigned dA;
-		DISEMBLE_RGBA(src, srcbpp, srcfmt, Pixel, sR, sG, sB, sA);
-		if(sA) {
-		  DISEMBLE_RGBA(dst, dstbpp, dstfmt, Pixel, dR, dG, dB, dA);
-		  ALPHA_BLEND(sR, sG, sB, sA, dR, dG, dB);
-		  ASSEMBLE_RGBA(dst, dstbpp, dstfmt, dR, dG, dB, dA);
-		}
-		src += srcbpp;
-		dst += dstbpp;
-	    },
-	    width);
-	    src += srcskip;
-	    dst += dstskip;
-	}
+	BLIT_NTON_PIXELALPHA(info, info->src, info->dst);
 }
 
 
+/*
+ * Specialized copies of the generic C blenders for common layouts.  They
+ * are only used where SDL_CalculateAlphaBlit() would otherwise pick the
+ * generic loop, so pairs that already have a faster blitter are left out.
+ */
+#define SURFACEALPHA_AUTO_BLITS_TO(X, dst)				\
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, RGB888, dst)	\
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, BGR888, dst)
+#define SURFACEALPHA_AUTO_BLITS(X)					\
+	SURFACEALPHA_AUTO_BLITS_TO(X, XRGB8888)				\
+	SURFACEALPHA_AUTO_BLITS_TO(X, XBGR8888)				\
+	SURFACEALPHA_AUTO_BLITS_TO(X, RGB888)				\
+	SURFACEALPHA_AUTO_BLITS_TO(X, RGB565)				\
+	SURFACEALPHA_AUTO_BLITS_TO(X, RGB555)				\
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, XRGB8888, XBGR8888) \
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, XRGB8888, RGB888) \
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, XRGB8888, RGB565) \
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, XRGB8888, RGB555) \
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, XBGR8888, XRGB8888) \
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, XBGR8888, RGB888) \
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, XBGR8888, RGB565) \
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, XBGR8888, RGB555) \
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, RGB565, XRGB8888) \
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, RGB565, XBGR8888) \
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, RGB565, RGB888)	\
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, RGB565, RGB555)	\
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, RGB555, XRGB8888) \
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, RGB555, XBGR8888) \
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, RGB555, RGB888)	\
+	X(BlitNtoNSurfaceAlpha, BLIT_NTON_SURFACEALPHA, RGB555, RGB565)
+
+#define SURFACEALPHA_KEY_AUTO_BLITS_FROM(X, src)			\
+	X(BlitNtoNSurfaceAlphaKey, BLIT_NTON_SURFACEALPHA_KEY, src, XRGB8888) \
+	X(BlitNtoNSurfaceAlphaKey, BLIT_NTON_SURFACEALPHA_KEY, src, RGB888) \
+	X(BlitNtoNSurfaceAlphaKey, BLIT_NTON_SURFACEALPHA_KEY, src, RGB565) \
+	X(BlitNtoNSurfaceAlphaKey, BLIT_NTON_SURFACEALPHA_KEY, src, RGB555)
+#define SURFACEALPHA_KEY_AUTO_BLITS(X)					\
+	SURFACEALPHA_KEY_AUTO_BLITS_FROM(X, XRGB8888)			\
+	SURFACEALPHA_KEY_AUTO_BLITS_FROM(X, RGB888)			\
+	SURFACEALPHA_KEY_AUTO_BLITS_FROM(X, RGB565)			\
+	SURFACEALPHA_KEY_AUTO_BLITS_FROM(X, RGB555)
+
+#define PIXELALPHA_AUTO_BLITS_FROM(X, src)				\
+	X(BlitNtoNPixelAlpha, BLIT_NTON_PIXELALPHA, src, XRGB8888)	\
+	X(BlitNtoNPixelAlpha, BLIT_NTON_PIXELALPHA, src, XBGR8888)	\
+	X(BlitNtoNPixelAlpha, BLIT_NTON_PIXELALPHA, src, RGB888)	\
+	X(BlitNtoNPixelAlpha, BLIT_NTON_PIXELALPHA, src, RGB565)	\
+	X(BlitNtoNPixelAlpha, BLIT_NTON_PIXELALPHA, src, RGB555)	\
+	X(BlitNtoNPixelAlpha, BLIT_NTON_PIXELALPHA, src, ARGB8888)	\
+	X(BlitNtoNPixelAlpha, BLIT_NTON_PIXELALPHA, src, ABGR8888)
+#define PIXELALPHA_AUTO_BLITS(X)					\
+	PIXELALPHA_AUTO_BLITS_FROM(X, RGBA8888)				\
+	PIXELALPHA_AUTO_BLITS_FROM(X, BGRA8888)				\
+	X(BlitNtoNPixelAlpha, BLIT_NTON_PIXELALPHA, ARGB8888, XBGR8888)	\
+	X(BlitNtoNPixelAlpha, BLIT_NTON_PIXELALPHA, ARGB8888, RGB888)	\
+	X(BlitNtoNPixelAlpha, BLIT_NTON_PIXELALPHA, ARGB8888, ABGR8888)	\
+	X(BlitNtoNPixelAlpha, BLIT_NTON_PIXELALPHA, ABGR8888, XRGB8888)	\
+	X(BlitNtoNPixelAlpha, BLIT_NTON_PIXELALPHA, ABGR8888, RGB888)	\
+	X(BlitNtoNPixelAlpha, BLIT_NTON_PIXELALPHA, ABGR8888, RGB565)	\
+	X(BlitNtoNPixelAlpha, BLIT_NTON_PIXELALPHA, ABGR8888, RGB555)	\
+	X(BlitNtoNPixelAlpha, BLIT_NTON_PIXELALPHA, ABGR8888, ARGB8888)
+
+SURFACEALPHA_AUTO_BLITS(SDL_AUTO_BLIT)
+SURFACEALPHA_KEY_AUTO_BLITS(SDL_AUTO_BLIT)
+PIXELALPHA_AUTO_BLITS(SDL_AUTO_BLIT)
+
+static const SDL_AutoBlit surfacealpha_auto[] = {
+	SURFACEALPHA_AUTO_BLITS(SDL_AUTO_BLIT_ENTRY)
+	SDL_AUTO_BLIT_END
+};
+static const SDL_AutoBlit surfacealpha_key_auto[] = {
+	SURFACEALPHA_KEY_AUTO_BLITS(SDL_AUTO_BLIT_ENTRY)
+	SDL_AUTO_BLIT_END
+};
+static const SDL_AutoBlit pixelalpha_auto[] = {
+	PIXELALPHA_AUTO_BLITS(SDL_AUTO_BLIT_ENTRY)
+	SDL_AUTO_BLIT_END
+};
+
 SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 {
     SDL_PixelFormat *sf = surface->format;
@@ -2736,7 +3384,8 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
             return Blit32to32SurfaceAlphaKeyAltivec;
         else
 #endif
-            return BlitNtoNSurfaceAlphaKey;
+            return SDL_FindAutoBlit(surfacealpha_key_auto, surface,
+				    BlitNtoNSurfaceAlphaKey);
 	} else {
 	    /* Per-surface alpha blits */
 	    switch(df->BytesPerPixel) {
@@ -2747,6 +3396,17 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		if(surface->map->identity) {
 		    if(df->Gmask == 0x7e0)
 		    {
+#if AVX2_BLIT
+		if(SDL_HasAVX2())
+			return Blit565to565SurfaceAlphaAVX2;
+#endif
+#if SSE2_BLIT
+		if(SDL_HasSSE2())
+			return Blit565to565SurfaceAlphaSSE2;
+#endif
+#if NEON_BLIT
+		return Blit565to565SurfaceAlphaNEON;
+#endif
 #if MMX_ASMBLIT
 		if(SDL_HasMMX())
 			return Blit565to565SurfaceAlphaMMX;
@@ -2756,6 +3416,17 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		    }
 		    else if(df->Gmask == 0x3e0)
 		    {
+#if AVX2_BLIT
+		if(SDL_HasAVX2())
+			return Blit555to555SurfaceAlphaAVX2;
+#endif
+#if SSE2_BLIT
+		if(SDL_HasSSE2())
+			return Blit555to555SurfaceAlphaSSE2;
+#endif
+#if NEON_BLIT
+		return Blit555to555SurfaceAlphaNEON;
+#endif
 #if MMX_ASMBLIT
 		if(SDL_HasMMX())
 			return Blit555to555SurfaceAlphaMMX;
@@ -2764,7 +3435,8 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 			return Blit555to555SurfaceAlpha;
 		    }
 		}
-		return BlitNtoNSurfaceAlpha;
+		return SDL_FindAutoBlit(surfacealpha_auto, surface,
+					BlitNtoNSurfaceAlpha);
 
 	    case 4:
 		if(sf->Rmask == df->Rmask
@@ -2772,6 +3444,22 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		   && sf->Bmask == df->Bmask
 		   && sf->BytesPerPixel == 4)
 		{
+#if SSE2_BLIT || NEON_BLIT
+			/* Only where the C code is BlitRGBtoRGBSurfaceAlpha */
+			if((sf->Rmask | sf->Gmask | sf->Bmask) == 0xffffff)
+			{
+#if AVX2_BLIT
+			    if(SDL_HasAVX2())
+				return BlitRGBtoRGBSurfaceAlphaAVX2;
+#endif
+#if SSE2_BLIT
+			    if(SDL_HasSSE2())
+				return BlitRGBtoRGBSurfaceAlphaSSE2;
+#else
+			    return BlitRGBtoRGBSurfaceAlphaNEON;
+#endif
+			}
+#endif
 #if MMX_ASMBLIT
 			if(sf->Rshift % 8 == 0
 			   && sf->Gshift % 8 == 0
@@ -2795,11 +3483,13 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 			return Blit32to32SurfaceAlphaAltivec;
 		else
 #endif
-			return BlitNtoNSurfaceAlpha;
+			return SDL_FindAutoBlit(surfacealpha_auto, surface,
+						BlitNtoNSurfaceAlpha);
 
 	    case 3:
 	    default:
-		return BlitNtoNSurfaceAlpha;
+		return SDL_FindAutoBlit(surfacealpha_auto, surface,
+					BlitNtoNSurfaceAlpha);
 	    }
 	}
     } else {
@@ -2825,7 +3515,8 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		else if(df->Gmask == 0x3e0)
 		    return BlitARGBto555PixelAlpha;
 	    }
-	    return BlitNtoNPixelAlpha;
+	    return SDL_FindAutoBlit(pixelalpha_auto, surface,
+				    BlitNtoNPixelAlpha);
 
 	case 4:
 	    if(sf->Rmask == df->Rmask
@@ -2833,6 +3524,23 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 	       && sf->Bmask == df->Bmask
 	       && sf->BytesPerPixel == 4)
 	    {
+#if SSE2_BLIT
+		/* Other than ARGB, this stands in for BlitNtoNPixelAlpha(),
+		   which only keeps the destination alpha if it has one */
+		if(sf->Rshift % 8 == 0 && sf->Rloss == 0
+		   && sf->Gshift % 8 == 0 && sf->Gloss == 0
+		   && sf->Bshift % 8 == 0 && sf->Bloss == 0
+		   && sf->Ashift % 8 == 0 && sf->Aloss == 0
+		   && (sf->Amask == 0xff000000 || df->Amask == sf->Amask))
+		{
+#if AVX2_BLIT
+			if(SDL_HasAVX2())
+				return BlitRGBtoRGBPixelAlphaAVX2;
+#endif
+			if(SDL_HasSSE2())
+				return BlitRGBtoRGBPixelAlphaSSE2;
+		}
+#endif
 #if MMX_ASMBLIT
 		if(sf->Rshift % 8 == 0
 		   && sf->Gshift % 8 == 0
@@ -2862,11 +3570,13 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		return Blit32to32PixelAlphaAltivec;
 	    else
 #endif
-		return BlitNtoNPixelAlpha;
+		return SDL_FindAutoBlit(pixelalpha_auto, surface,
+					BlitNtoNPixelAlpha);
 
 	case 3:
 	default:
-	    return BlitNtoNPixelAlpha;
+	    return SDL_FindAutoBlit(pixelalpha_auto, surface,
+				    BlitNtoNPixelAlpha);
 	}
     }
 }
@@ -837,8 +837,17 @@ static Uint32 GetBlitFeatures( void )
 #pragma altivec_model off
 #endif
 #else
-/* Feature 1 is has-MMX */
-#define GetBlitFeatures() ((Uint32)(SDL_HasMMX() ? 1 : 0))
+/* Feature 1 is has-MMX, 8 has-SSE2, 16 has-SSSE3, 32 has-AVX2, 64 has-NEON */
+#if NEON_BLIT
+#define HAS_NEON_BLIT_FEATURE	64
+#else
+#define HAS_NEON_BLIT_FEATURE	0
+#endif
+#define GetBlitFeatures() ((Uint32)((SDL_HasMMX() ? 1 : 0) | \
+				    (SDL_HasSSE2() ? 8 : 0) | \
+				    (SDL_HasSSSE3() ? 16 : 0) | \
+				    (SDL_HasAVX2() ? 32 : 0) | \
+				    HAS_NEON_BLIT_FEATURE))
 #endif
 
 /* This is now endian dependent */
@@ -2031,67 +2040,77 @@ static void Blit4to4MaskAlpha(SDL_BlitInfo *info)
 	}
 }
 
+#define BLIT_NTON(info, sfmt, dfmt)					\
+do {									\
+	int width = info->d_width;					\
+	int height = info->d_height;					\
+	Uint8 *src = info->s_pixels;					\
+	int srcskip = info->s_skip;					\
+	Uint8 *dst = info->d_pixels;					\
+	int dstskip = info->d_skip;					\
+	const SDL_PixelFormat *srcfmt = sfmt;				\
+	int srcbpp = srcfmt->BytesPerPixel;				\
+	const SDL_PixelFormat *dstfmt = dfmt;				\
+	int dstbpp = dstfmt->BytesPerPixel;				\
+	unsigned alpha = dstfmt->Amask ? info->src->alpha : 0;		\
+									\
+	while ( height-- ) {						\
+		DUFFS_LOOP(						\
+		{							\
+		        Uint32 Pixel;					\
+			unsigned sR;					\
+			unsigned sG;					\
+			unsigned sB;					\
+			DISEMBLE_RGB(src, srcbpp, srcfmt, Pixel, sR, sG, sB); \
+			ASSEMBLE_RGBA(dst, dstbpp, dstfmt, sR, sG, sB, alpha); \
+			dst += dstbpp;					\
+			src += srcbpp;					\
+		},							\
+		width);							\
+		src += srcskip;						\
+		dst += dstskip;						\
+	}								\
+} while(0)
+
 static void BlitNtoN(SDL_BlitInfo *info)
 {
-	int width = info->d_width;
-	int height = info->d_height;
-	Uint8 *src = info->s_pixels;
-	int srcskip = info->s_skip;
-	Uint8 *dst = info->d_pixels;
-	int dstskip = info->d_skip;
-	SDL_PixelFormat *srcfmt = info->src;
-	int srcbpp = srcfmt->BytesPerPixel;
-	SDL_PixelFormat *dstfmt = info->dst;
-	int dstbpp = dstfmt->BytesPerPixel;
-	unsigned alpha = dstfmt->Amask ? srcfmt->alpha : 0;
-
-	while ( height-- ) {
-		DUFFS_LOOP(
-		{
-		        Uint32 Pixel;
-			unsigned sR;
-			unsigned sG;
-			unsigned sB;
-			DISEMBLE_RGB(src, srcbpp, srcfmt, Pixel, sR, sG, sB);
-			ASSEMBLE_RGBA(dst, dstbpp, dstfmt, sR, sG, sB, alpha);
-			dst += dstbpp;
-			src += srcbpp;
-		},
-		width);
-		src += srcskip;
-		dst += dstskip;
-	}
+	BLIT_NTON(info, info->src, info->dst);
 }
 
+#define BLIT_NTON_COPYALPHA(info, sfmt, dfmt)				\
+do {									\
+	int width = info->d_width;					\
+	int height = info->d_height;					\
+	Uint8 *src = info->s_pixels;					\
+	int srcskip = info->s_skip;					\
+	Uint8 *dst = info->d_pixels;					\
+	int dstskip = info->d_skip;					\
+	const SDL_PixelFormat *srcfmt = sfmt;				\
+	int srcbpp = srcfmt->BytesPerPixel;				\
+	const SDL_PixelFormat *dstfmt = dfmt;				\
+	int dstbpp = dstfmt->BytesPerPixel;				\
+	int c;								\
+									\
+	/* FIXME: should map alpha to [0..255] correctly! */		\
+	while ( height-- ) {						\
+		for ( c=width; c; --c ) {				\
+		        Uint32 Pixel;					\
+			unsigned sR, sG, sB, sA;			\
+			DISEMBLE_RGBA(src, srcbpp, srcfmt, Pixel,	\
+				      sR, sG, sB, sA);			\
+			ASSEMBLE_RGBA(dst, dstbpp, dstfmt,		\
+				      sR, sG, sB, sA);			\
+			dst += dstbpp;					\
+			src += srcbpp;					\
+		}							\
+		src += srcskip;						\
+		dst += dstskip;						\
+	}								\
+} while(0)
+
 static void BlitNtoNCopyAlpha(SDL_BlitInfo *info)
 {
-	int width = info->d_width;
-	int height = info->d_height;
-	Uint8 *src = info->s_pixels;
-	int srcskip = info->s_skip;
-	Uint8 *dst = info->d_pixels;
-	int dstskip = info->d_skip;
-	SDL_PixelFormat *srcfmt = info->src;
-	int srcbpp = srcfmt->BytesPerPixel;
-	SDL_PixelFormat *dstfmt = info->dst;
-	int dstbpp = dstfmt->BytesPerPixel;
-	int c;
-
-	/* FIXME: should map alpha to [0..255] correctly! */
-	while ( height-- ) {
-		for ( c=width; c; --c ) {
-		        Uint32 Pixel;
-			unsigned sR, sG, sB, sA;
-			DISEMBLE_RGBA(src, srcbpp, srcfmt, Pixel,
-				      sR, sG, sB, sA);
-			ASSEMBLE_RGBA(dst, dstbpp, dstfmt,
-				      sR, sG, sB, sA);
-			dst += dstbpp;
-			src += srcbpp;
-		}
-		src += srcskip;
-		dst += dstskip;
-	}
+	BLIT_NTON_COPYALPHA(info, info->src, info->dst);
 }
 
 static void BlitNto1Key(SDL_BlitInfo *info)
@@ -2186,88 +2205,644 @@ static void Blit2to2Key(SDL_BlitInfo *info)
 	}
 }
 
+#define BLIT_NTON_KEY(info, sfmt, dfmt)					\
+do {									\
+	int width = info->d_width;					\
+	int height = info->d_height;					\
+	Uint8 *src = info->s_pixels;					\
+	int srcskip = info->s_skip;					\
+	Uint8 *dst = info->d_pixels;					\
+	int dstskip = info->d_skip;					\
+	Uint32 ckey = info->src->colorkey;				\
+	const SDL_PixelFormat *srcfmt = sfmt;				\
+	const SDL_PixelFormat *dstfmt = dfmt;				\
+	int srcbpp = srcfmt->BytesPerPixel;				\
+	int dstbpp = dstfmt->BytesPerPixel;				\
+	unsigned alpha = dstfmt->Amask ? info->src->alpha : 0;		\
+	Uint32 rgbmask = ~srcfmt->Amask;				\
+									\
+	/* Set up some basic variables */				\
+	ckey &= rgbmask;						\
+									\
+	while ( height-- ) {						\
+		DUFFS_LOOP(						\
+		{							\
+		        Uint32 Pixel;					\
+			unsigned sR;					\
+			unsigned sG;					\
+			unsigned sB;					\
+			RETRIEVE_RGB_PIXEL(src, srcbpp, Pixel);		\
+			if ( (Pixel & rgbmask) != ckey ) {		\
+			        RGB_FROM_PIXEL(Pixel, srcfmt, sR, sG, sB); \
+				ASSEMBLE_RGBA(dst, dstbpp, dstfmt,	\
+					      sR, sG, sB, alpha);	\
+			}						\
+			dst += dstbpp;					\
+			src += srcbpp;					\
+		},							\
+		width);							\
+		src += srcskip;						\
+		dst += dstskip;						\
+	}								\
+} while(0)
+
 static void BlitNtoNKey(SDL_BlitInfo *info)
+{
+	BLIT_NTON_KEY(info, info->src, info->dst);
+}
+
+#define BLIT_NTON_KEY_COPYALPHA(info, sfmt, dfmt)			\
+do {									\
+	int width = info->d_width;					\
+	int height = info->d_height;					\
+	Uint8 *src = info->s_pixels;					\
+	int srcskip = info->s_skip;					\
+	Uint8 *dst = info->d_pixels;					\
+	int dstskip = info->d_skip;					\
+	Uint32 ckey = info->src->colorkey;				\
+	const SDL_PixelFormat *srcfmt = sfmt;				\
+	const SDL_PixelFormat *dstfmt = dfmt;				\
+	Uint32 rgbmask = ~srcfmt->Amask;				\
+									\
+	Uint8 srcbpp;							\
+	Uint8 dstbpp;							\
+	Uint32 Pixel;							\
+	unsigned sR, sG, sB, sA;					\
+									\
+	/* Set up some basic variables */				\
+	srcbpp = srcfmt->BytesPerPixel;					\
+	dstbpp = dstfmt->BytesPerPixel;					\
+	ckey &= rgbmask;						\
+									\
+	/* FIXME: should map alpha to [0..255] correctly! */		\
+	while ( height-- ) {						\
+		DUFFS_LOOP(						\
+		{							\
+			DISEMBLE_RGBA(src, srcbpp, srcfmt, Pixel,	\
+				      sR, sG, sB, sA);			\
+			if ( (Pixel & rgbmask) != ckey ) {		\
+				  ASSEMBLE_RGBA(dst, dstbpp, dstfmt,	\
+						sR, sG, sB, sA);	\
+			}						\
+			dst += dstbpp;					\
+			src += srcbpp;					\
+		},							\
+		width);							\
+		src += srcskip;						\
+		dst += dstskip;						\
+	}								\
+} while(0)
+
+static void BlitNtoNKeyCopyAlpha(SDL_BlitInfo *info)
+{
+	BLIT_NTON_KEY_COPYALPHA(info, info->src, info->dst);
+}
+
+#if SSE2_BLIT || NEON_BLIT
+/*
+ * Vector pixel format converters.  Each one produces exactly what the
+ * generic C blitter it replaces would.  Formats they can't handle
+ * (channels that aren't 8 bits wide in a 32-bit pixel, mostly) are kept
+ * away from them by the BLIT_FEATURE_* format bits in their table entries.
+ */
+
+/* Byte offset in memory of the 8-bit channel at 'shift' in a 32-bit pixel */
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#define BYTE_OF(shift)	((shift) >> 3)
+#else
+#define BYTE_OF(shift)	(3 - ((shift) >> 3))
+#endif
+
+static int Is8888(const SDL_PixelFormat *fmt)
+{
+	return (fmt->BytesPerPixel == 4 &&
+		fmt->Rloss == 0 && (fmt->Rshift % 8) == 0 &&
+		fmt->Gloss == 0 && (fmt->Gshift % 8) == 0 &&
+		fmt->Bloss == 0 && (fmt->Bshift % 8) == 0 &&
+		(!fmt->Amask || (fmt->Aloss == 0 && (fmt->Ashift % 8) == 0)));
+}
+
+#if SSSE3_BLIT || NEON_BLIT
+/*
+ * Byte shuffle for a 32->32 blit between 8888 formats: dst byte i of each
+ * pixel comes from src byte shuffle[i], or is cleared if that is 0x80.
+ * The returned value is then ORed in to set the alpha channel, the same
+ * as BlitNtoN() does.
+ */
+static Uint32 CalcSwizzle32(const SDL_PixelFormat *srcfmt,
+			    const SDL_PixelFormat *dstfmt, Uint8 shuffle[4])
+{
+	SDL_memset(shuffle, 0x80, 4);
+	shuffle[BYTE_OF(dstfmt->Rshift)] = BYTE_OF(srcfmt->Rshift);
+	shuffle[BYTE_OF(dstfmt->Gshift)] = BYTE_OF(srcfmt->Gshift);
+	shuffle[BYTE_OF(dstfmt->Bshift)] = BYTE_OF(srcfmt->Bshift);
+	if ( !dstfmt->Amask ) {
+		return 0;
+	}
+	if ( srcfmt->Amask ) {
+		shuffle[BYTE_OF(dstfmt->Ashift)] = BYTE_OF(srcfmt->Ashift);
+		return 0;
+	}
+	return (srcfmt->alpha >> dstfmt->Aloss) << dstfmt->Ashift;
+}
+
+static __inline__ Uint32 Swizzle32(const Uint8 *src, const Uint8 shuffle[4],
+				   Uint32 alpha)
+{
+	Uint8 out[4];
+	Uint32 pixel;
+	int i;
+
+	for ( i = 0; i < 4; ++i ) {
+		out[i] = (shuffle[i] & 0x80) ? 0 : src[shuffle[i]];
+	}
+	SDL_memcpy(&pixel, out, 4);
+	return pixel | alpha;
+}
+#endif /* SSSE3_BLIT || NEON_BLIT */
+
+/* Expand a channel of a 16-bit pixel to 8 bits, as RGB_FROM_PIXEL() does */
+static __inline__ Uint32 Expand16(Uint32 pixel, Uint32 mask, int shift,
+				  int loss)
+{
+	return ((pixel & mask) >> shift) << loss;
+}
+
+static __inline__ Uint32 Pixel16to32(Uint32 pixel, const SDL_PixelFormat *srcfmt,
+				     const SDL_PixelFormat *dstfmt, Uint32 alpha)
+{
+	return (Expand16(pixel, srcfmt->Rmask, srcfmt->Rshift,
+			 srcfmt->Rloss) << dstfmt->Rshift) |
+	       (Expand16(pixel, srcfmt->Gmask, srcfmt->Gshift,
+			 srcfmt->Gloss) << dstfmt->Gshift) |
+	       (Expand16(pixel, srcfmt->Bmask, srcfmt->Bshift,
+			 srcfmt->Bloss) << dstfmt->Bshift) |
+	       alpha;
+}
+
+/* RGB565 to 8888 the way the RGB565_*8888_LUT tables expand it: red and
+   blue are scaled by 255/31, and green by 255/63 separately for the top
+   and bottom three bits, which live in different bytes of the pixel */
+static __inline__ Uint32 Pixel565to32(Uint32 pixel, const SDL_PixelFormat *dstfmt,
+				      Uint32 alpha)
+{
+	Uint32 r = (pixel >> 11) * 255 / 31;
+	Uint32 g = ((pixel >> 8) & 7) * 8 * 255 / 63 + ((pixel >> 5) & 7) * 255 / 63;
+	Uint32 b = (pixel & 0x1f) * 255 / 31;
+
+	return (r << dstfmt->Rshift) | (g << dstfmt->Gshift) |
+	       (b << dstfmt->Bshift) | alpha;
+}
+
+static __inline__ Uint16 Pixel32to16(Uint32 pixel, const SDL_PixelFormat *srcfmt,
+				     const SDL_PixelFormat *dstfmt)
+{
+	return (Uint16)(
+		((((pixel >> srcfmt->Rshift) & 0xff) >> dstfmt->Rloss) << dstfmt->Rshift) |
+		((((pixel >> srcfmt->Gshift) & 0xff) >> dstfmt->Gloss) << dstfmt->Gshift) |
+		((((pixel >> srcfmt->Bshift) & 0xff) >> dstfmt->Bloss) << dstfmt->Bshift));
+}
+
+/* 16-bit source channels can be expanded in 16-bit lanes if they are
+   between 4 and 8 bits wide, and the destination needs 8-bit channels */
+static int CanExpand16to32(const SDL_PixelFormat *srcfmt,
+			   const SDL_PixelFormat *dstfmt)
+{
+	return (srcfmt->Rloss <= 4 && srcfmt->Gloss <= 4 && srcfmt->Bloss <= 4 &&
+		dstfmt->Rloss == 0 && dstfmt->Gloss == 0 && dstfmt->Bloss == 0);
+}
+#endif /* SSE2_BLIT || NEON_BLIT */
+
+#if SSE2_BLIT
+/* expand one channel of 8 16-bit pixels to 8 bits, in 16-bit lanes */
+static __inline__ __m128i Expand16SSE2(__m128i p, Uint32 mask, int shift,
+				       int loss)
+{
+	__m128i v = _mm_and_si128(_mm_srl_epi16(p, _mm_cvtsi32_si128(shift)),
+				  _mm_set1_epi16((short)(mask >> shift)));
+	return _mm_sll_epi16(v, _mm_cvtsi32_si128(loss));
+}
+
+/* Pixel565to32() for 8 pixels; the divisions become a multiply-high by
+   a reciprocal which is exact over each input range */
+static __inline__ void Expand565SSE2(__m128i p, __m128i *r, __m128i *g,
+				     __m128i *b)
+{
+	__m128i k31 = _mm_set1_epi16((short)33693);
+	__m128i seven = _mm_set1_epi16(7);
+	__m128i gh = _mm_and_si128(_mm_srli_epi16(p, 8), seven);
+	__m128i gl = _mm_and_si128(_mm_srli_epi16(p, 5), seven);
+
+	*r = _mm_mulhi_epu16(_mm_slli_epi16(_mm_srli_epi16(p, 11), 4), k31);
+	*g = _mm_add_epi16(_mm_mulhi_epu16(_mm_slli_epi16(gh, 6),
+					   _mm_set1_epi16((short)33110)),
+			   _mm_slli_epi16(gl, 2));
+	*b = _mm_mulhi_epu16(_mm_slli_epi16(
+		_mm_and_si128(p, _mm_set1_epi16(0x1f)), 4), k31);
+}
+
+static __inline__ void Convert16to32SSE2(SDL_BlitInfo *info, int lut565)
 {
 	int width = info->d_width;
 	int height = info->d_height;
-	Uint8 *src = info->s_pixels;
-	int srcskip = info->s_skip;
-	Uint8 *dst = info->d_pixels;
-	int dstskip = info->d_skip;
-	Uint32 ckey = info->src->colorkey;
+	Uint16 *src = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip >> 1;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
 	SDL_PixelFormat *srcfmt = info->src;
 	SDL_PixelFormat *dstfmt = info->dst;
-	int srcbpp = srcfmt->BytesPerPixel;
-	int dstbpp = dstfmt->BytesPerPixel;
-	unsigned alpha = dstfmt->Amask ? srcfmt->alpha : 0;
-	Uint32 rgbmask = ~srcfmt->Amask;
-
-	/* Set up some basic variables */
-	ckey &= rgbmask;
+	Uint32 alpha = dstfmt->Amask ?
+		(srcfmt->alpha >> dstfmt->Aloss) << dstfmt->Ashift : 0;
+	__m128i dR = _mm_cvtsi32_si128(dstfmt->Rshift);
+	__m128i dG = _mm_cvtsi32_si128(dstfmt->Gshift);
+	__m128i dB = _mm_cvtsi32_si128(dstfmt->Bshift);
+	__m128i valpha = _mm_set1_epi32(alpha);
+	__m128i zero = _mm_setzero_si128();
 
 	while ( height-- ) {
-		DUFFS_LOOP(
-		{
-		        Uint32 Pixel;
-			unsigned sR;
-			unsigned sG;
-			unsigned sB;
-			RETRIEVE_RGB_PIXEL(src, srcbpp, Pixel);
-			if ( (Pixel & rgbmask) != ckey ) {
-			        RGB_FROM_PIXEL(Pixel, srcfmt, sR, sG, sB);
-				ASSEMBLE_RGBA(dst, dstbpp, dstfmt,
-					      sR, sG, sB, alpha);
+		int n = width;
+		for ( ; n >= 8; n -= 8, src += 8, dst += 8 ) {
+			__m128i p = _mm_loadu_si128((__m128i *)src);
+			__m128i r, g, b, lo, hi;
+			if ( lut565 ) {
+				Expand565SSE2(p, &r, &g, &b);
+			} else {
+				r = Expand16SSE2(p, srcfmt->Rmask, srcfmt->Rshift, srcfmt->Rloss);
+				g = Expand16SSE2(p, srcfmt->Gmask, srcfmt->Gshift, srcfmt->Gloss);
+				b = Expand16SSE2(p, srcfmt->Bmask, srcfmt->Bshift, srcfmt->Bloss);
 			}
-			dst += dstbpp;
-			src += srcbpp;
-		},
-		width);
+			lo = _mm_or_si128(_mm_or_si128(valpha,
+				_mm_sll_epi32(_mm_unpacklo_epi16(r, zero), dR)),
+				_mm_or_si128(
+				_mm_sll_epi32(_mm_unpacklo_epi16(g, zero), dG),
+				_mm_sll_epi32(_mm_unpacklo_epi16(b, zero), dB)));
+			hi = _mm_or_si128(_mm_or_si128(valpha,
+				_mm_sll_epi32(_mm_unpackhi_epi16(r, zero), dR)),
+				_mm_or_si128(
+				_mm_sll_epi32(_mm_unpackhi_epi16(g, zero), dG),
+				_mm_sll_epi32(_mm_unpackhi_epi16(b, zero), dB)));
+			_mm_storeu_si128((__m128i *)dst, lo);
+			_mm_storeu_si128((__m128i *)(dst + 4), hi);
+		}
+		for ( ; n > 0; --n, ++src ) {
+			*dst++ = lut565 ? Pixel565to32(*src, dstfmt, alpha) :
+				 Pixel16to32(*src, srcfmt, dstfmt, alpha);
+		}
 		src += srcskip;
 		dst += dstskip;
 	}
 }
 
-static void BlitNtoNKeyCopyAlpha(SDL_BlitInfo *info)
+/* RGB565 to one of the 8888 formats Blit_RGB565_ARGB8888() and friends
+   handle, with the same rounding as their lookup tables */
+static void Blit_RGB565_8888SSE2(SDL_BlitInfo *info)
+{
+	Convert16to32SSE2(info, 1);
+}
+
+static void Blit16to32SSE2(SDL_BlitInfo *info)
+{
+	Convert16to32SSE2(info, 0);
+}
+
+static void Blit32to16SSE2(SDL_BlitInfo *info)
 {
 	int width = info->d_width;
 	int height = info->d_height;
-	Uint8 *src = info->s_pixels;
-	int srcskip = info->s_skip;
-	Uint8 *dst = info->d_pixels;
-	int dstskip = info->d_skip;
-	Uint32 ckey = info->src->colorkey;
+	Uint32 *src = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint16 *dst = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip >> 1;
 	SDL_PixelFormat *srcfmt = info->src;
 	SDL_PixelFormat *dstfmt = info->dst;
-	Uint32 rgbmask = ~srcfmt->Amask;
+	__m128i sR = _mm_cvtsi32_si128(srcfmt->Rshift + dstfmt->Rloss);
+	__m128i sG = _mm_cvtsi32_si128(srcfmt->Gshift + dstfmt->Gloss);
+	__m128i sB = _mm_cvtsi32_si128(srcfmt->Bshift + dstfmt->Bloss);
+	__m128i dR = _mm_cvtsi32_si128(dstfmt->Rshift);
+	__m128i dG = _mm_cvtsi32_si128(dstfmt->Gshift);
+	__m128i dB = _mm_cvtsi32_si128(dstfmt->Bshift);
+	__m128i mR = _mm_set1_epi32(0xff >> dstfmt->Rloss);
+	__m128i mG = _mm_set1_epi32(0xff >> dstfmt->Gloss);
+	__m128i mB = _mm_set1_epi32(0xff >> dstfmt->Bloss);
 
-	Uint8 srcbpp;
-	Uint8 dstbpp;
-	Uint32 Pixel;
-	unsigned sR, sG, sB, sA;
+	while ( height-- ) {
+		int n = width;
+		for ( ; n >= 8; n -= 8, src += 8, dst += 8 ) {
+			__m128i p, lo, hi;
+
+			p = _mm_loadu_si128((__m128i *)src);
+			lo = _mm_or_si128(_mm_or_si128(
+			  _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, sR), mR), dR),
+			  _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, sG), mG), dG)),
+			  _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, sB), mB), dB));
+			p = _mm_loadu_si128((__m128i *)(src + 4));
+			hi = _mm_or_si128(_mm_or_si128(
+			  _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, sR), mR), dR),
+			  _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, sG), mG), dG)),
+			  _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, sB), mB), dB));
+			/* sign extend so the saturating pack keeps all 16 bits */
+			lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+			hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+			_mm_storeu_si128((__m128i *)dst, _mm_packs_epi32(lo, hi));
+		}
+		for ( ; n > 0; --n ) {
+			*dst++ = Pixel32to16(*src++, srcfmt, dstfmt);
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+#endif /* SSE2_BLIT */
 
-	/* Set up some basic variables */
-	srcbpp = srcfmt->BytesPerPixel;
-	dstbpp = dstfmt->BytesPerPixel;
-	ckey &= rgbmask;
+#if SSSE3_BLIT
+/* 32->32 between any two 8888 formats with one byte shuffle, 4 pixels at a time */
+static __attribute__((target("ssse3")))
+void Blit32to32SwizzleSSSE3(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *src = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	Uint8 shuffle[4];
+	Uint8 vshuffle[16];
+	Uint32 alpha;
+	__m128i vmask, valpha;
+	int i;
+
+	alpha = CalcSwizzle32(info->src, info->dst, shuffle);
+	for ( i = 0; i < 16; ++i ) {
+		vshuffle[i] = shuffle[i % 4] | (i & ~3);
+	}
+	vmask = _mm_loadu_si128((__m128i *)vshuffle);
+	valpha = _mm_set1_epi32(alpha);
 
-	/* FIXME: should map alpha to [0..255] correctly! */
 	while ( height-- ) {
-		DUFFS_LOOP(
-		{
-			DISEMBLE_RGBA(src, srcbpp, srcfmt, Pixel,
-				      sR, sG, sB, sA);
-			if ( (Pixel & rgbmask) != ckey ) {
-				  ASSEMBLE_RGBA(dst, dstbpp, dstfmt,
-						sR, sG, sB, sA);
+		int n = width;
+		for ( ; n >= 4; n -= 4, src += 4, dst += 4 ) {
+			__m128i p = _mm_loadu_si128((__m128i *)src);
+			p = _mm_or_si128(_mm_shuffle_epi8(p, vmask), valpha);
+			_mm_storeu_si128((__m128i *)dst, p);
+		}
+		for ( ; n > 0; --n ) {
+			*dst++ = Swizzle32((Uint8 *)src++, shuffle, alpha);
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+#endif /* SSSE3_BLIT */
+
+#if AVX2_BLIT
+/* the same as Blit32to32SwizzleSSSE3(), 8 pixels at a time */
+static __attribute__((target("avx2")))
+void Blit32to32SwizzleAVX2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *src = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	Uint8 shuffle[4];
+	Uint8 vshuffle[32];
+	Uint32 alpha;
+	__m256i vmask, valpha;
+	int i;
+
+	alpha = CalcSwizzle32(info->src, info->dst, shuffle);
+	/* vpshufb works within each 128-bit lane */
+	for ( i = 0; i < 32; ++i ) {
+		vshuffle[i] = shuffle[i % 4] | (i & 0xc);
+	}
+	vmask = _mm256_loadu_si256((__m256i *)vshuffle);
+	valpha = _mm256_set1_epi32(alpha);
+
+	while ( height-- ) {
+		int n = width;
+		for ( ; n >= 8; n -= 8, src += 8, dst += 8 ) {
+			__m256i p = _mm256_loadu_si256((__m256i *)src);
+			p = _mm256_or_si256(_mm256_shuffle_epi8(p, vmask), valpha);
+			_mm256_storeu_si256((__m256i *)dst, p);
+		}
+		for ( ; n > 0; --n ) {
+			*dst++ = Swizzle32((Uint8 *)src++, shuffle, alpha);
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+#endif /* AVX2_BLIT */
+
+#if NEON_BLIT
+/* 32->32 between any two 8888 formats with one table lookup per 2 pixels */
+static void Blit32to32SwizzleNEON(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *src = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	Uint8 shuffle[4];
+	Uint8 vshuffle[8];
+	Uint32 alpha;
+	uint8x8_t vmask;
+	uint8x16_t valpha;
+	int i;
+
+	alpha = CalcSwizzle32(info->src, info->dst, shuffle);
+	/* out of range indices (0x80) give zero */
+	for ( i = 0; i < 8; ++i ) {
+		vshuffle[i] = shuffle[i % 4] | (i & 4);
+	}
+	vmask = vld1_u8(vshuffle);
+	valpha = vreinterpretq_u8_u32(vdupq_n_u32(alpha));
+
+	while ( height-- ) {
+		int n = width;
+		for ( ; n >= 4; n -= 4, src += 4, dst += 4 ) {
+			uint8x16_t p = vreinterpretq_u8_u32(vld1q_u32(src));
+			p = vcombine_u8(vtbl1_u8(vget_low_u8(p), vmask),
+					vtbl1_u8(vget_high_u8(p), vmask));
+			vst1q_u32(dst, vreinterpretq_u32_u8(vorrq_u8(p, valpha)));
+		}
+		for ( ; n > 0; --n ) {
+			*dst++ = Swizzle32((Uint8 *)src++, shuffle, alpha);
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+
+/* expand one channel of 8 16-bit pixels to 8 bits, in 16-bit lanes */
+static __inline__ uint16x8_t Expand16NEON(uint16x8_t p, Uint32 mask,
+					  int shift, int loss)
+{
+	uint16x8_t v = vandq_u16(vshlq_u16(p, vdupq_n_s16((short)-shift)),
+				 vdupq_n_u16((Uint16)(mask >> shift)));
+	return vshlq_u16(v, vdupq_n_s16((short)loss));
+}
+
+static __inline__ uint16x8_t MulHi16NEON(uint16x8_t v, Uint16 k)
+{
+	return vcombine_u16(
+		vshrn_n_u32(vmull_u16(vget_low_u16(v), vdup_n_u16(k)), 16),
+		vshrn_n_u32(vmull_u16(vget_high_u16(v), vdup_n_u16(k)), 16));
+}
+
+/* Pixel565to32() for 8 pixels, see Expand565SSE2() */
+static __inline__ void Expand565NEON(uint16x8_t p, uint16x8_t *r,
+				     uint16x8_t *g, uint16x8_t *b)
+{
+	uint16x8_t seven = vdupq_n_u16(7);
+	uint16x8_t gh = vandq_u16(vshrq_n_u16(p, 8), seven);
+	uint16x8_t gl = vandq_u16(vshrq_n_u16(p, 5), seven);
+
+	*r = MulHi16NEON(vshlq_n_u16(vshrq_n_u16(p, 11), 4), 33693);
+	*g = vaddq_u16(MulHi16NEON(vshlq_n_u16(gh, 6), 33110),
+		       vshlq_n_u16(gl, 2));
+	*b = MulHi16NEON(vshlq_n_u16(vandq_u16(p, vdupq_n_u16(0x1f)), 4), 33693);
+}
+
+static __inline__ void Convert16to32NEON(SDL_BlitInfo *info, int lut565)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint16 *src = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip >> 1;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	Uint32 alpha = dstfmt->Amask ?
+		(srcfmt->alpha >> dstfmt->Aloss) << dstfmt->Ashift : 0;
+	int32x4_t dR = vdupq_n_s32(dstfmt->Rshift);
+	int32x4_t dG = vdupq_n_s32(dstfmt->Gshift);
+	int32x4_t dB = vdupq_n_s32(dstfmt->Bshift);
+	uint32x4_t valpha = vdupq_n_u32(alpha);
+
+	while ( height-- ) {
+		int n = width;
+		for ( ; n >= 8; n -= 8, src += 8, dst += 8 ) {
+			uint16x8_t p = vld1q_u16(src);
+			uint16x8_t r, g, b;
+			uint32x4_t lo, hi;
+			if ( lut565 ) {
+				Expand565NEON(p, &r, &g, &b);
+			} else {
+				r = Expand16NEON(p, srcfmt->Rmask, srcfmt->Rshift, srcfmt->Rloss);
+				g = Expand16NEON(p, srcfmt->Gmask, srcfmt->Gshift, srcfmt->Gloss);
+				b = Expand16NEON(p, srcfmt->Bmask, srcfmt->Bshift, srcfmt->Bloss);
 			}
-			dst += dstbpp;
-			src += srcbpp;
-		},
-		width);
+			lo = vorrq_u32(vorrq_u32(valpha,
+				vshlq_u32(vmovl_u16(vget_low_u16(r)), dR)),
+				vorrq_u32(vshlq_u32(vmovl_u16(vget_low_u16(g)), dG),
+					  vshlq_u32(vmovl_u16(vget_low_u16(b)), dB)));
+			hi = vorrq_u32(vorrq_u32(valpha,
+				vshlq_u32(vmovl_u16(vget_high_u16(r)), dR)),
+				vorrq_u32(vshlq_u32(vmovl_u16(vget_high_u16(g)), dG),
+					  vshlq_u32(vmovl_u16(vget_high_u16(b)), dB)));
+			vst1q_u32(dst, lo);
+			vst1q_u32(dst + 4, hi);
+		}
+		for ( ; n > 0; --n, ++src ) {
+			*dst++ = lut565 ? Pixel565to32(*src, dstfmt, alpha) :
+				 Pixel16to32(*src, srcfmt, dstfmt, alpha);
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+
+static void Blit_RGB565_8888NEON(SDL_BlitInfo *info)
+{
+	Convert16to32NEON(info, 1);
+}
+
+static void Blit16to32NEON(SDL_BlitInfo *info)
+{
+	Convert16to32NEON(info, 0);
+}
+
+static void Blit32to16NEON(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *src = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint16 *dst = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip >> 1;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	int32x4_t sR = vdupq_n_s32(-(srcfmt->Rshift + dstfmt->Rloss));
+	int32x4_t sG = vdupq_n_s32(-(srcfmt->Gshift + dstfmt->Gloss));
+	int32x4_t sB = vdupq_n_s32(-(srcfmt->Bshift + dstfmt->Bloss));
+	int32x4_t dR = vdupq_n_s32(dstfmt->Rshift);
+	int32x4_t dG = vdupq_n_s32(dstfmt->Gshift);
+	int32x4_t dB = vdupq_n_s32(dstfmt->Bshift);
+	uint32x4_t mR = vdupq_n_u32(0xff >> dstfmt->Rloss);
+	uint32x4_t mG = vdupq_n_u32(0xff >> dstfmt->Gloss);
+	uint32x4_t mB = vdupq_n_u32(0xff >> dstfmt->Bloss);
+
+	while ( height-- ) {
+		int n = width;
+		for ( ; n >= 4; n -= 4, src += 4, dst += 4 ) {
+			uint32x4_t p = vld1q_u32(src);
+			uint32x4_t v = vorrq_u32(vorrq_u32(
+			  vshlq_u32(vandq_u32(vshlq_u32(p, sR), mR), dR),
+			  vshlq_u32(vandq_u32(vshlq_u32(p, sG), mG), dG)),
+			  vshlq_u32(vandq_u32(vshlq_u32(p, sB), mB), dB));
+			vst1_u16(dst, vmovn_u32(v));
+		}
+		for ( ; n > 0; --n ) {
+			*dst++ = Pixel32to16(*src++, srcfmt, dstfmt);
+		}
 		src += srcskip;
 		dst += dstskip;
 	}
 }
+#endif /* NEON_BLIT */
+
+#if SSE2_BLIT
+#define BLIT_FEATURE_VECTOR	8	/* has-SSE2 */
+#define Blit_RGB565_8888Vector	Blit_RGB565_8888SSE2
+#define Blit16to32Vector	Blit16to32SSE2
+#define Blit32to16Vector	Blit32to16SSE2
+#elif NEON_BLIT
+#define BLIT_FEATURE_VECTOR	64	/* has-NEON */
+#define Blit_RGB565_8888Vector	Blit_RGB565_8888NEON
+#define Blit16to32Vector	Blit16to32NEON
+#define Blit32to16Vector	Blit32to16NEON
+#endif
+
+/* Pseudo features telling the table which pixel formats the vector
+   converters can take; GetFormatFeatures() sets them for a blit */
+#define BLIT_FEATURE_SRC8888	0x100	/* 8-bit channels, 32-bit source */
+#define BLIT_FEATURE_DST8888	0x200	/* 8-bit channels, 32-bit dest */
+#define BLIT_FEATURE_EXPAND16	0x400	/* CanExpand16to32() */
+
+#if SSE2_BLIT || NEON_BLIT
+static Uint32 GetFormatFeatures(const SDL_PixelFormat *srcfmt,
+				const SDL_PixelFormat *dstfmt)
+{
+	Uint32 features = 0;
+
+	if ( Is8888(srcfmt) ) {
+		features |= BLIT_FEATURE_SRC8888;
+	}
+	if ( Is8888(dstfmt) ) {
+		features |= BLIT_FEATURE_DST8888;
+	}
+	if ( srcfmt->BytesPerPixel == 2 && CanExpand16to32(srcfmt, dstfmt) ) {
+		features |= BLIT_FEATURE_EXPAND16;
+	}
+	return features;
+}
+#else
+#define GetFormatFeatures(srcfmt, dstfmt)	0
+#endif
 
 /* Normal N to N optimized blitters */
 struct blit_table {
@@ -2297,6 +2872,17 @@ static const struct blit_table normal_blit_2[] = {
       2, NULL, Blit_RGB565_32Altivec, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
     { 0x00007C00,0x000003E0,0x0000001F, 4, 0x00000000,0x00000000,0x00000000,
       2, NULL, Blit_RGB555_32Altivec, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+#endif
+#if SSE2_BLIT || NEON_BLIT
+    /* has-SSE2 or has-NEON */
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      BLIT_FEATURE_VECTOR, NULL, Blit_RGB565_8888Vector, SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      BLIT_FEATURE_VECTOR, NULL, Blit_RGB565_8888Vector, SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0xFF000000,0x00FF0000,0x0000FF00,
+      BLIT_FEATURE_VECTOR, NULL, Blit_RGB565_8888Vector, SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x0000FF00,0x00FF0000,0xFF000000,
+      BLIT_FEATURE_VECTOR, NULL, Blit_RGB565_8888Vector, SET_ALPHA },
 #endif
     { 0x0000F800,0x000007E0,0x0000001F, 4, 0x00FF0000,0x0000FF00,0x000000FF,
       0, NULL, Blit_RGB565_ARGB8888, SET_ALPHA },
@@ -2306,6 +2892,12 @@ static const struct blit_table normal_blit_2[] = {
       0, NULL, Blit_RGB565_RGBA8888, SET_ALPHA },
     { 0x0000F800,0x000007E0,0x0000001F, 4, 0x0000FF00,0x00FF0000,0xFF000000,
       0, NULL, Blit_RGB565_BGRA8888, SET_ALPHA },
+#if SSE2_BLIT || NEON_BLIT
+    /* has-SSE2 or has-NEON */
+    { 0x00000000,0x00000000,0x00000000, 4, 0x00000000,0x00000000,0x00000000,
+      BLIT_FEATURE_VECTOR | BLIT_FEATURE_EXPAND16,
+      NULL, Blit16to32Vector, NO_ALPHA | SET_ALPHA },
+#endif
 
     /* Default for 16-bit RGB source, used if no other blitter matches */
     { 0,0,0, 0, 0,0,0, 0, NULL, BlitNtoN, 0 }
@@ -2355,6 +2947,30 @@ static const struct blit_table normal_blit_4[] = {
     /* has-altivec */
     { 0x00000000,0x00000000,0x00000000, 2, 0x0000F800,0x000007E0,0x0000001F,
       2, NULL, Blit_RGB888_RGB565Altivec, NO_ALPHA },
+#endif
+#if AVX2_BLIT
+    /* has-AVX2 */
+    { 0x00000000,0x00000000,0x00000000, 4, 0x00000000,0x00000000,0x00000000,
+      32 | BLIT_FEATURE_SRC8888 | BLIT_FEATURE_DST8888,
+      NULL, Blit32to32SwizzleAVX2, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+#endif
+#if SSSE3_BLIT
+    /* has-SSSE3 */
+    { 0x00000000,0x00000000,0x00000000, 4, 0x00000000,0x00000000,0x00000000,
+      16 | BLIT_FEATURE_SRC8888 | BLIT_FEATURE_DST8888,
+      NULL, Blit32to32SwizzleSSSE3, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+#endif
+#if NEON_BLIT
+    /* has-NEON */
+    { 0x00000000,0x00000000,0x00000000, 4, 0x00000000,0x00000000,0x00000000,
+      64 | BLIT_FEATURE_SRC8888 | BLIT_FEATURE_DST8888,
+      NULL, Blit32to32SwizzleNEON, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+#endif
+#if SSE2_BLIT || NEON_BLIT
+    /* has-SSE2 or has-NEON */
+    { 0x00000000,0x00000000,0x00000000, 2, 0x00000000,0x00000000,0x00000000,
+      BLIT_FEATURE_VECTOR | BLIT_FEATURE_SRC8888,
+      NULL, Blit32to16Vector, NO_ALPHA },
 #endif
     { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
       0, NULL, Blit_RGB888_RGB565, NO_ALPHA },
@@ -2371,6 +2987,92 @@ static const struct blit_table *normal_blit[] = {
 /* Mask matches table, or table entry is zero */
 #define MASKOK(x, y) (((x) == (y)) || ((y) == 0x00000000))
 
+/*
+ * Specialized copies of the generic C blitters for common layouts.  They
+ * are only used where SDL_CalculateBlitN() would otherwise pick the
+ * generic loop, so pairs that already have a faster blitter are left out.
+ */
+#define NTON_AUTO_BLITS(X)						\
+	X(BlitNtoN, BLIT_NTON, RGB888, XRGB8888)			\
+	X(BlitNtoN, BLIT_NTON, RGB888, XBGR8888)			\
+	X(BlitNtoN, BLIT_NTON, RGB888, ARGB8888)			\
+	X(BlitNtoN, BLIT_NTON, RGB888, RGB565)				\
+	X(BlitNtoN, BLIT_NTON, RGB888, RGB555)				\
+	X(BlitNtoN, BLIT_NTON, BGR888, XRGB8888)			\
+	X(BlitNtoN, BLIT_NTON, BGR888, XBGR8888)			\
+	X(BlitNtoN, BLIT_NTON, BGR888, ARGB8888)			\
+	X(BlitNtoN, BLIT_NTON, BGR888, RGB565)				\
+	X(BlitNtoN, BLIT_NTON, BGR888, RGB555)				\
+	X(BlitNtoN, BLIT_NTON, XRGB8888, RGB888)			\
+	X(BlitNtoN, BLIT_NTON, XRGB8888, BGR888)			\
+	X(BlitNtoN, BLIT_NTON, XRGB8888, XBGR8888)			\
+	X(BlitNtoN, BLIT_NTON, XRGB8888, ABGR8888)			\
+	X(BlitNtoN, BLIT_NTON, XBGR8888, XRGB8888)			\
+	X(BlitNtoN, BLIT_NTON, XBGR8888, RGB888)			\
+	X(BlitNtoN, BLIT_NTON, ARGB8888, RGB888)			\
+	X(BlitNtoN, BLIT_NTON, ABGR8888, XRGB8888)			\
+	X(BlitNtoN, BLIT_NTON, ABGR8888, RGB888)			\
+	X(BlitNtoN, BLIT_NTON, RGBA8888, XRGB8888)			\
+	X(BlitNtoN, BLIT_NTON, RGB565, RGB555)				\
+	X(BlitNtoN, BLIT_NTON, RGB565, RGB888)				\
+	X(BlitNtoN, BLIT_NTON, RGB555, RGB565)				\
+	X(BlitNtoN, BLIT_NTON, RGB555, RGB888)
+
+#define NTON_COPYALPHA_AUTO_BLITS(X)					\
+	X(BlitNtoNCopyAlpha, BLIT_NTON_COPYALPHA, ARGB8888, ABGR8888)	\
+	X(BlitNtoNCopyAlpha, BLIT_NTON_COPYALPHA, ARGB8888, RGBA8888)	\
+	X(BlitNtoNCopyAlpha, BLIT_NTON_COPYALPHA, ABGR8888, ARGB8888)	\
+	X(BlitNtoNCopyAlpha, BLIT_NTON_COPYALPHA, RGBA8888, ARGB8888)	\
+	X(BlitNtoNCopyAlpha, BLIT_NTON_COPYALPHA, BGRA8888, ARGB8888)
+
+#define NTON_KEY_AUTO_BLITS_FROM(X, src)				\
+	X(BlitNtoNKey, BLIT_NTON_KEY, src, XRGB8888)			\
+	X(BlitNtoNKey, BLIT_NTON_KEY, src, XBGR8888)			\
+	X(BlitNtoNKey, BLIT_NTON_KEY, src, RGB888)
+#define NTON_KEY_AUTO_BLITS(X)						\
+	NTON_KEY_AUTO_BLITS_FROM(X, XRGB8888)				\
+	NTON_KEY_AUTO_BLITS_FROM(X, XBGR8888)				\
+	NTON_KEY_AUTO_BLITS_FROM(X, RGB888)				\
+	NTON_KEY_AUTO_BLITS_FROM(X, RGB565)				\
+	NTON_KEY_AUTO_BLITS_FROM(X, RGB555)				\
+	X(BlitNtoNKey, BLIT_NTON_KEY, XRGB8888, ARGB8888)		\
+	X(BlitNtoNKey, BLIT_NTON_KEY, XRGB8888, RGB565)			\
+	X(BlitNtoNKey, BLIT_NTON_KEY, XRGB8888, RGB555)			\
+	X(BlitNtoNKey, BLIT_NTON_KEY, XBGR8888, RGB565)			\
+	X(BlitNtoNKey, BLIT_NTON_KEY, RGB888, RGB565)			\
+	X(BlitNtoNKey, BLIT_NTON_KEY, RGB888, RGB555)			\
+	X(BlitNtoNKey, BLIT_NTON_KEY, RGB565, RGB555)			\
+	X(BlitNtoNKey, BLIT_NTON_KEY, RGB555, RGB565)			\
+	X(BlitNtoNKey, BLIT_NTON_KEY, ARGB8888, XRGB8888)		\
+	X(BlitNtoNKey, BLIT_NTON_KEY, ARGB8888, RGB565)
+
+#define NTON_KEY_COPYALPHA_AUTO_BLITS(X)				\
+	X(BlitNtoNKeyCopyAlpha, BLIT_NTON_KEY_COPYALPHA, ARGB8888, ARGB8888) \
+	X(BlitNtoNKeyCopyAlpha, BLIT_NTON_KEY_COPYALPHA, ABGR8888, ABGR8888) \
+	X(BlitNtoNKeyCopyAlpha, BLIT_NTON_KEY_COPYALPHA, ABGR8888, ARGB8888)
+
+NTON_AUTO_BLITS(SDL_AUTO_BLIT)
+NTON_COPYALPHA_AUTO_BLITS(SDL_AUTO_BLIT)
+NTON_KEY_AUTO_BLITS(SDL_AUTO_BLIT)
+NTON_KEY_COPYALPHA_AUTO_BLITS(SDL_AUTO_BLIT)
+
+static const SDL_AutoBlit nton_auto[] = {
+	NTON_AUTO_BLITS(SDL_AUTO_BLIT_ENTRY)
+	SDL_AUTO_BLIT_END
+};
+static const SDL_AutoBlit nton_copyalpha_auto[] = {
+	NTON_COPYALPHA_AUTO_BLITS(SDL_AUTO_BLIT_ENTRY)
+	SDL_AUTO_BLIT_END
+};
+static const SDL_AutoBlit nton_key_auto[] = {
+	NTON_KEY_AUTO_BLITS(SDL_AUTO_BLIT_ENTRY)
+	SDL_AUTO_BLIT_END
+};
+static const SDL_AutoBlit nton_key_copyalpha_auto[] = {
+	NTON_KEY_COPYALPHA_AUTO_BLITS(SDL_AUTO_BLIT_ENTRY)
+	SDL_AUTO_BLIT_END
+};
+
 SDL_loblit SDL_CalculateBlitN(SDL_Surface *surface, int blit_index)
 {
 	struct private_swaccel *sdata;
@@ -2413,9 +3115,11 @@ SDL_loblit SDL_CalculateBlitN(SDL_Surface *surface, int blit_index)
 #endif
 
 		if(srcfmt->Amask && dstfmt->Amask)
-		    return BlitNtoNKeyCopyAlpha;
+		    return SDL_FindAutoBlit(nton_key_copyalpha_auto,
+					    surface, BlitNtoNKeyCopyAlpha);
 		else
-		    return BlitNtoNKey;
+		    return SDL_FindAutoBlit(nton_key_auto,
+					    surface, BlitNtoNKey);
 	    }
 	}
 
@@ -2442,6 +3146,8 @@ SDL_loblit SDL_CalculateBlitN(SDL_Surface *surface, int blit_index)
 	} else {
 		/* Now the meat, choose the blitter we want */
 		int a_need = NO_ALPHA;
+		Uint32 features = GetBlitFeatures() |
+				  GetFormatFeatures(srcfmt, dstfmt);
 		if(dstfmt->Amask)
 		    a_need = srcfmt->Amask ? COPY_ALPHA : SET_ALPHA;
 		table = normal_blit[srcfmt->BytesPerPixel-1];
@@ -2454,7 +3160,7 @@ SDL_loblit SDL_CalculateBlitN(SDL_Surface *surface, int blit_index)
 			    MASKOK(dstfmt->Bmask, table[which].dstB) &&
 			    dstfmt->BytesPerPixel == table[which].dstbpp &&
 			    (a_need & table[which].alpha) == a_need &&
-			    ((table[which].blit_features & GetBlitFeatures()) == table[which].blit_features) )
+			    ((table[which].blit_features & features) == table[which].blit_features) )
 				break;
 		}
 		sdata->aux_data = table[which].aux_data;
@@ -2468,7 +3174,11 @@ SDL_loblit SDL_CalculateBlitN(SDL_Surface *surface, int blit_index)
 			     srcfmt->Bmask == dstfmt->Bmask ) {
 				blitfun = Blit4to4MaskAlpha;
 			} else if ( a_need == COPY_ALPHA ) {
-			    blitfun = BlitNtoNCopyAlpha;
+			    blitfun = SDL_FindAutoBlit(nton_copyalpha_auto,
+						       surface, BlitNtoNCopyAlpha);
+			} else {
+			    blitfun = SDL_FindAutoBlit(nton_auto,
+						       surface, BlitNtoN);
 			}
 		}
 	}
@@ -24,6 +24,7 @@
 /* General (mostly internal) pixel/color manipulation routines for SDL */
 
 #include "SDL_endian.h"
+#include "SDL_mutex.h"
 #include "SDL_video.h"
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
@@ -432,10 +433,95 @@ void SDL_ApplyGamma(Uint16 *gamma, SDL_Color *colors, SDL_Color *output,
 	}
 }
 
+/*
+ * Translating one palette to another searches the whole destination
+ * palette for every colour, so recent translation tables are kept and
+ * reused when the same pair of palettes comes up again.  Palettes have
+ * no version count, so the tables are looked up by palette contents.
+ * Surfaces in different threads share the cache, so it is only used
+ * once SDL_Init() has created its lock.
+ */
+#define PALETTE_MAP_CACHE_SIZE	8
+
+static struct {
+	Uint32 hash;
+	int src_ncolors;
+	int dst_ncolors;
+	SDL_Color src_colors[256];
+	SDL_Color dst_colors[256];
+	Uint8 map[256];
+	Uint32 last_used;
+} palette_maps[PALETTE_MAP_CACHE_SIZE];
+static Uint32 palette_map_clock;
+static SDL_mutex *palette_map_lock;
+
+void SDL_InitPaletteMaps(void)
+{
+	if ( palette_map_lock == NULL ) {
+		palette_map_lock = SDL_CreateMutex();
+	}
+}
+
+void SDL_QuitPaletteMaps(void)
+{
+	if ( palette_map_lock ) {
+		SDL_DestroyMutex(palette_map_lock);
+		palette_map_lock = NULL;
+	}
+	SDL_memset(palette_maps, 0, sizeof(palette_maps));
+	palette_map_clock = 0;
+}
+
+static Uint32 HashPalettes(SDL_Palette *src, SDL_Palette *dst)
+{
+	const Uint8 *p;
+	Uint32 hash = 2166136261u;
+	int i;
+
+	p = (const Uint8 *)src->colors;
+	for ( i=src->ncolors*sizeof(SDL_Color); i; --i ) {
+		hash = (hash ^ *p++) * 16777619u;
+	}
+	p = (const Uint8 *)dst->colors;
+	for ( i=dst->ncolors*sizeof(SDL_Color); i; --i ) {
+		hash = (hash ^ *p++) * 16777619u;
+	}
+	return(hash);
+}
+
+/* Copy a cached translation into map and return -1, or return the
+   cache entry to keep a new translation in */
+static int FindPaletteMap(SDL_Palette *src, SDL_Palette *dst,
+						Uint32 hash, Uint8 *map)
+{
+	int i, oldest;
+
+	oldest = 0;
+	for ( i=0; i<PALETTE_MAP_CACHE_SIZE; ++i ) {
+		if ( palette_maps[i].hash == hash &&
+		     palette_maps[i].src_ncolors == src->ncolors &&
+		     palette_maps[i].dst_ncolors == dst->ncolors &&
+		     SDL_memcmp(palette_maps[i].src_colors, src->colors,
+				src->ncolors*sizeof(SDL_Color)) == 0 &&
+		     SDL_memcmp(palette_maps[i].dst_colors, dst->colors,
+				dst->ncolors*sizeof(SDL_Color)) == 0 ) {
+			palette_maps[i].last_used = ++palette_map_clock;
+			SDL_memcpy(map, palette_maps[i].map, src->ncolors);
+			return(-1);
+		}
+		if ( palette_maps[i].last_used < palette_maps[oldest].last_used ) {
+			oldest = i;
+		}
+	}
+	return(oldest);
+}
+
 /* Map from Palette to Palette */
 static Uint8 *Map1to1(SDL_Palette *src, SDL_Palette *dst, int *identical)
 {
 	Uint8 *map;
+	Uint32 hash = 0;
+	int entry;
 	int i;
 
 	if ( identical ) {
@@ -454,10 +540,36 @@ static Uint8 *Map1to1(SDL_Palette *src, SDL_Palette *dst, int *identical)
 		SDL_OutOfMemory();
 		return(NULL);
 	}
+	if ( !palette_map_lock || src->ncolors > 256 || dst->ncolors > 256 ) {
+		entry = -1;
+	} else {
+		hash = HashPalettes(src, dst);
+		SDL_mutexP(palette_map_lock);
+		entry = FindPaletteMap(src, dst, hash, map);
+		SDL_mutexV(palette_map_lock);
+		if ( entry < 0 ) {
+			return(map);
+		}
+	}
 	for ( i=0; i<src->ncolors; ++i ) {
 		map[i] = SDL_FindColor(dst,
 			src->colors[i].r, src->colors[i].g, src->colors[i].b);
 	}
+	if ( entry >= 0 ) {
+		/* Another thread may have taken the entry meanwhile, and
+		   whichever one stores last keeps it */
+		SDL_mutexP(palette_map_lock);
+		palette_maps[entry].hash = hash;
+		palette_maps[entry].src_ncolors = src->ncolors;
+		palette_maps[entry].dst_ncolors = dst->ncolors;
+		SDL_memcpy(palette_maps[entry].src_colors, src->colors,
+				src->ncolors*sizeof(SDL_Color));
+		SDL_memcpy(palette_maps[entry].dst_colors, dst->colors,
+				dst->ncolors*sizeof(SDL_Color));
+		SDL_memcpy(palette_maps[entry].map, map, src->ncolors);
+		palette_maps[entry].last_used = ++palette_map_clock;
+		SDL_mutexV(palette_map_lock);
+	}
 	return(map);
 }
 /* Map from Palette to BitField */
@@ -527,11 +639,8 @@ SDL_BlitMap *SDL_AllocBlitMap(void)
 	/* It's ready to go */
 	return(map);
 }
-void SDL_InvalidateMap(SDL_BlitMap *map)
+static void SDL_ClearMap(SDL_BlitMap *map)
 {
-	if ( ! map ) {
-		return;
-	}
 	map->dst = NULL;
 	map->format_version = (unsigned int)-1;
 	if ( map->table ) {
@@ -539,18 +648,132 @@ void SDL_InvalidateMap(SDL_BlitMap *map)
 		map->table = NULL;
 	}
 }
+void SDL_InvalidateMap(SDL_BlitMap *map)
+{
+	if ( ! map ) {
+		return;
+	}
+	SDL_ClearMap(map);
+
+	/* The earlier mappings depend on the source too */
+	SDL_FreeBlitMap(map->next);
+	map->next = NULL;
+}
+
+/*
+ * A surface keeps its mappings to the last few destinations it was
+ * blitted to, so a surface alternating between destinations doesn't
+ * rebuild its translation table and blitter on every switch.  The
+ * surface's current map is the head of the list, and changes state
+ * with the saved maps, so surface->map itself never moves.
+ */
+#define SDL_MAX_SAVED_MAPS	3
+
+/* Swap the mapping state of two maps; the links and RLE encodings stay */
+static void SDL_SwapMaps(SDL_BlitMap *a, SDL_BlitMap *b)
+{
+	SDL_BlitMap map;
+	SDL_RLEEntry *rle_cache;
+
+	map = *a;
+	*a = *b;
+	*b = map;
+	b->next = a->next;
+	a->next = map.next;
+	rle_cache = a->sw_data->rle_cache;
+	a->sw_data->rle_cache = b->sw_data->rle_cache;
+	b->sw_data->rle_cache = rle_cache;
+}
+
+/* Make a saved mapping of the surface to dst current, if there is one */
+static int SDL_RestoreMap(SDL_Surface *src, SDL_Surface *dst)
+{
+	SDL_BlitMap *map = src->map;
+	SDL_BlitMap **prev, *saved;
+
+	for ( prev = &map->next; (saved = *prev) != NULL; prev = &saved->next ) {
+		if ( saved->dst == dst &&
+		     saved->format_version == dst->format_version ) {
+			break;
+		}
+	}
+	if ( saved == NULL ) {
+		return(0);
+	}
+	*prev = saved->next;
+	saved->next = NULL;
+	SDL_SwapMaps(map, saved);
+
+	/* The replaced mapping is now the most recently used saved one,
+	   unless it was hardware accelerated, as SDL_SaveMap() won't keep */
+	if ( saved->dst && !(src->flags & SDL_HWACCEL) ) {
+		saved->next = map->next;
+		map->next = saved;
+	} else {
+		SDL_FreeBlitMap(saved);
+	}
+
+	/* Saved maps are never hardware accelerated, see SDL_SaveMap() */
+	src->flags &= ~SDL_HWACCEL;
+
+	/* The RLE encoding may have been dropped from the cache since */
+	if ( map->sw_blit == SDL_RLEBlit || map->sw_blit == SDL_RLEAlphaBlit ) {
+		if ( SDL_RLESurface(src) != 0 ) {
+			return(SDL_CalculateBlit(src) == 0);
+		}
+	}
+	return(1);
+}
+
+/* Save the current mapping of the surface, leaving the current map empty */
+static void SDL_SaveMap(SDL_Surface *src, SDL_Surface *dst)
+{
+	SDL_BlitMap *map = src->map;
+	SDL_BlitMap **prev, *saved;
+	int count;
+
+	/* A mapping to dst is out of date, and hardware blits have their
+	   own state in the video driver */
+	if ( map->dst == NULL || map->dst == dst ||
+	     (src->flags & SDL_HWACCEL) ) {
+		return;
+	}
+
+	/* Reuse the least recently used map if the list is full */
+	count = 0;
+	for ( prev = &map->next; *prev && ++count < SDL_MAX_SAVED_MAPS;
+	      prev = &(*prev)->next )
+		;
+	saved = *prev;
+	if ( saved ) {
+		*prev = NULL;
+		SDL_ClearMap(saved);
+	} else {
+		saved = SDL_AllocBlitMap();
+		if ( saved == NULL ) {
+			return;
+		}
+	}
+	SDL_SwapMaps(map, saved);
+	saved->next = map->next;
+	map->next = saved;
+}
+
 int SDL_MapSurface (SDL_Surface *src, SDL_Surface *dst)
 {
 	SDL_PixelFormat *srcfmt;
 	SDL_PixelFormat *dstfmt;
 	SDL_BlitMap *map;
 
-	/* Clear out any previous mapping */
-	map = src->map;
-	if ( (src->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
-		SDL_UnRLESurface(src, 1);
+	/* Go back to an earlier mapping, or keep the current one for later */
+	if ( SDL_RestoreMap(src, dst) ) {
+		return(0);
 	}
-	SDL_InvalidateMap(map);
+	SDL_SaveMap(src, dst);
+
+	/* Clear out any previous mapping (RLE encodings stay cached) */
+	map = src->map;
+	SDL_ClearMap(map);
 
 	/* Figure out what kind of mapping we're doing */
 	map->identity = 0;
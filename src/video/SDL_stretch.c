@@ -25,134 +25,21 @@
    Tomasz Cejner - thanks! :)
 
    April 27, 2000 - Sam Lantinga
+
+   The filtered paths are separable: each source row that is needed is
+   expanded to 8 bits per channel, resampled horizontally into a small
+   row cache, and the cached rows are then blended vertically.  All the
+   state lives on the stack or in buffers allocated per call, so any
+   number of threads may stretch at the same time.
 */
 
 #include "SDL_video.h"
+#include "SDL_cpuinfo.h"
 #include "SDL_blit.h"
-
-/* This isn't ready for general consumption yet - it should be folded
-   into the general blitting mechanism.
-*/
-
-#if ((defined(_MFC_VER) && defined(_M_IX86)/* && !defined(_WIN32_WCE) still needed? */) || \
-     defined(__WATCOMC__) || \
-     (defined(__GNUC__) && defined(__i386__))) && SDL_ASSEMBLY_ROUTINES
-/* There's a bug with gcc 4.4.1 and -O2 where srcp doesn't get the correct
- * value after the first scanline.  FIXME? */
-/*#define USE_ASM_STRETCH*/
-#endif
-
-#ifdef USE_ASM_STRETCH
-
-#ifdef HAVE_MPROTECT
-#include <sys/types.h>
-#include <sys/mman.h>
-#endif
-#ifdef __GNUC__
-#define PAGE_ALIGNED __attribute__((__aligned__(4096)))
-#else
-#define PAGE_ALIGNED
-#endif
-
-#if defined(_M_IX86) || defined(i386)
-#define PREFIX16	0x66
-#define STORE_BYTE	0xAA
-#define STORE_WORD	0xAB
-#define LOAD_BYTE	0xAC
-#define LOAD_WORD	0xAD
-#define RETURN		0xC3
-#else
-#error Need assembly opcodes for this architecture
-#endif
-
-static unsigned char copy_row[4096] PAGE_ALIGNED;
-
-static int generate_rowbytes(int src_w, int dst_w, int bpp)
-{
-	static struct {
-		int bpp;
-		int src_w;
-		int dst_w;
-		int status;
-	} last;
-
-	int i;
-	int pos, inc;
-	unsigned char *eip, *fence;
-	unsigned char load, store;
-
-	/* See if we need to regenerate the copy buffer */
-	if ( (src_w == last.src_w) &&
-	     (dst_w == last.dst_w) && (bpp == last.bpp) ) {
-		return(last.status);
-	}
-	last.bpp = bpp;
-	last.src_w = src_w;
-	last.dst_w = dst_w;
-	last.status = -1;
-
-	switch (bpp) {
-	    case 1:
-		load = LOAD_BYTE;
-		store = STORE_BYTE;
-		break;
-	    case 2:
-	    case 4:
-		load = LOAD_WORD;
-		store = STORE_WORD;
-		break;
-	    default:
-		SDL_SetError("ASM stretch of %d bytes isn't supported\n", bpp);
-		return(-1);
-	}
-#ifdef HAVE_MPROTECT
-	/* Make the code writeable */
-	if ( mprotect(copy_row, sizeof(copy_row), PROT_READ|PROT_WRITE) < 0 ) {
-		SDL_SetError("Couldn't make copy buffer writeable");
-		return(-1);
-	}
-#endif
-	pos = 0x10000;
-	inc = (src_w << 16) / dst_w;
-	eip = copy_row;
-	fence = copy_row+sizeof(copy_row)-2;
-	for ( i=0; i<dst_w && eip < end; ++i ) {
-		while ( pos >= 0x10000L ) {
-			if ( eip == fence ) {
-				return -1;
-			}
-			if ( bpp == 2 ) {
-				*eip++ = PREFIX16;
-			}
-			*eip++ = load;
-			pos -= 0x10000L;
-		}
-		if ( eip == fence ) {
-			return -1;
-		}
-		if ( bpp == 2 ) {
-			*eip++ = PREFIX16;
-		}
-		*eip++ = store;
-		pos += inc;
-	}
-	*eip++ = RETURN;
-
-#ifdef HAVE_MPROTECT
-	/* Make the code executable but not writeable */
-	if ( mprotect(copy_row, sizeof(copy_row), PROT_READ|PROT_EXEC) < 0 ) {
-		SDL_SetError("Couldn't make copy buffer executable");
-		return(-1);
-	}
-#endif
-	last.status = 0;
-	return(0);
-}
-
-#endif /* USE_ASM_STRETCH */
+#include "SDL_stretch_c.h"
 
 #define DEFINE_COPY_ROW(name, type)			\
-void name(type *src, int src_w, type *dst, int dst_w)	\
+static void name(type *src, int src_w, type *dst, int dst_w)	\
 {							\
 	int i;						\
 	int pos, inc;					\
@@ -173,8 +60,7 @@ DEFINE_COPY_ROW(copy_row1, Uint8)
 DEFINE_COPY_ROW(copy_row2, Uint16)
 DEFINE_COPY_ROW(copy_row4, Uint32)
 
-/* The ASM code doesn't handle 24-bpp stretch blits */
-void copy_row3(Uint8 *src, int src_w, Uint8 *dst, int dst_w)
+static void copy_row3(Uint8 *src, int src_w, Uint8 *dst, int dst_w)
 {
 	int i;
 	int pos, inc;
@@ -196,33 +82,580 @@ void copy_row3(Uint8 *src, int src_w, Uint8 *dst, int dst_w)
 	}
 }
 
-/* Perform a stretch blit between two surfaces of the same format.
-   NOTE:  This function is not safe to call from multiple threads!
-*/
-int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
-                    SDL_Surface *dst, SDL_Rect *dstrect)
+/* Nearest neighbour stretch of raw pixels, both surfaces locked */
+static void SDL_StretchNearest(SDL_Surface *src, SDL_Rect *srcrect,
+                               SDL_Surface *dst, SDL_Rect *dstrect)
 {
-	int src_locked;
-	int dst_locked;
 	int pos, inc;
 	int dst_maxrow;
 	int src_row, dst_row;
 	Uint8 *srcp = NULL;
 	Uint8 *dstp;
-	SDL_Rect full_src;
-	SDL_Rect full_dst;
-#ifdef USE_ASM_STRETCH
-	SDL_bool use_asm = SDL_TRUE;
-#ifdef __GNUC__
-	int u1, u2;
-#endif
-#endif /* USE_ASM_STRETCH */
 	const int bpp = dst->format->BytesPerPixel;
 
-	if ( src->format->BitsPerPixel != dst->format->BitsPerPixel ) {
-		SDL_SetError("Only works with same format surfaces");
+	pos = 0x10000;
+	inc = (srcrect->h << 16) / dstrect->h;
+	src_row = srcrect->y;
+	dst_row = dstrect->y;
+
+	for ( dst_maxrow = dst_row+dstrect->h; dst_row<dst_maxrow; ++dst_row ) {
+		dstp = (Uint8 *)dst->pixels + (dst_row*dst->pitch)
+		                            + (dstrect->x*bpp);
+		while ( pos >= 0x10000L ) {
+			srcp = (Uint8 *)src->pixels + (src_row*src->pitch)
+			                            + (srcrect->x*bpp);
+			++src_row;
+			pos -= 0x10000L;
+		}
+		switch (bpp) {
+		    case 1:
+			copy_row1(srcp, srcrect->w, dstp, dstrect->w);
+			break;
+		    case 2:
+			copy_row2((Uint16 *)srcp, srcrect->w,
+			          (Uint16 *)dstp, dstrect->w);
+			break;
+		    case 3:
+			copy_row3(srcp, srcrect->w, dstp, dstrect->w);
+			break;
+		    case 4:
+			copy_row4((Uint32 *)srcp, srcrect->w,
+			          (Uint32 *)dstp, dstrect->w);
+			break;
+		}
+		pos += inc;
+	}
+}
+
+/* Filter weights are 2.14 fixed point and always sum to STRETCH_ONE, so
+   a weighted sum of 8-bit channels fits in 32 bits and, once rounded and
+   shifted down, in 8 bits again.  That keeps the SIMD paths exact.
+*/
+#define STRETCH_BITS	14
+#define STRETCH_ONE	(1 << STRETCH_BITS)
+#define STRETCH_HALF	(1 << (STRETCH_BITS - 1))
+
+/* For each destination pixel (or row): the first source pixel it reads,
+   how many it reads, and their weights.  Every entry has room for
+   'stride' weights; the unused ones are zero.
+*/
+typedef struct {
+	int stride;
+	int *first;
+	int *count;
+	Sint16 *weights;
+} SDL_StretchKernel;
+
+static int SDL_BuildStretchKernel(SDL_StretchKernel *kernel,
+                                  int src_len, int dst_len,
+                                  SDL_StretchFilter filter)
+{
+	Uint32 step;
+	int i, t;
+
+	step = ((Uint32)src_len << 16) / dst_len;
+	switch (filter) {
+	    case SDL_STRETCH_BILINEAR:
+		kernel->stride = 2;
+		break;
+	    case SDL_STRETCH_AREA:
+		kernel->stride = ((src_len / dst_len) + 3 + 1) & ~1;
+		break;
+	    default:
+		kernel->stride = 1;
+		break;
+	}
+	kernel->first = (int *)SDL_malloc(2 * dst_len * sizeof(int));
+	kernel->weights = (Sint16 *)SDL_calloc(dst_len * kernel->stride,
+	                                       sizeof(Sint16));
+	if ( !kernel->first || !kernel->weights ) {
+		SDL_free(kernel->first);
+		SDL_free(kernel->weights);
+		kernel->first = NULL;
+		kernel->weights = NULL;
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	kernel->count = kernel->first + dst_len;
+
+	for ( i=0; i<dst_len; ++i ) {
+		int *first = &kernel->first[i];
+		int *count = &kernel->count[i];
+		Sint16 *weights = &kernel->weights[i * kernel->stride];
+
+		switch (filter) {
+		    case SDL_STRETCH_BILINEAR: {
+			/* Sample at the centre of the destination pixel */
+			Uint32 center = i * step + step / 2;
+			Uint32 frac;
+
+			if ( center < 0x8000 ) {
+				center = 0;
+			} else {
+				center -= 0x8000;
+			}
+			*first = (int)(center >> 16);
+			frac = (center & 0xFFFF) >> (16 - STRETCH_BITS);
+			if ( (*first >= src_len - 1) || !frac ) {
+				if ( *first > src_len - 1 ) {
+					*first = src_len - 1;
+				}
+				*count = 1;
+				weights[0] = STRETCH_ONE;
+			} else {
+				*count = 2;
+				weights[0] = (Sint16)(STRETCH_ONE - frac);
+				weights[1] = (Sint16)frac;
+			}
+		    }
+		    break;
+
+		    case SDL_STRETCH_AREA: {
+			/* Average the source span the destination covers */
+			Uint32 start = i * step;
+			Uint32 end = (i == dst_len-1) ?
+			             ((Uint32)src_len << 16) : (start + step);
+			Uint32 span = end - start;
+			Uint32 total = 0;
+
+			*first = (int)(start >> 16);
+			*count = 0;
+			for ( t=*first; ((Uint32)t << 16) < end; ++t ) {
+				Uint32 lo = (Uint32)t << 16;
+				Uint32 hi = lo + 0x10000;
+				Uint32 w;
+
+				if ( lo < start ) {
+					lo = start;
+				}
+				if ( hi > end ) {
+					hi = end;
+				}
+				w = ((hi - lo) << STRETCH_BITS) / span;
+				weights[(*count)++] = (Sint16)w;
+				total += w;
+			}
+			/* Give the rounding error to the last tap */
+			weights[*count-1] += (Sint16)(STRETCH_ONE - total);
+		    }
+		    break;
+
+		    default:
+			/* Matches the copy_row*() stepping */
+			*first = (int)((i * step) >> 16);
+			*count = 1;
+			weights[0] = STRETCH_ONE;
+			break;
+		}
+	}
+	return(0);
+}
+
+static void SDL_FreeStretchKernel(SDL_StretchKernel *kernel)
+{
+	SDL_free(kernel->first);
+	SDL_free(kernel->weights);
+}
+
+/* Resample one row of 8888 pixels horizontally */
+static void SDL_StretchRow(const Uint32 *src, Uint32 *dst, int width,
+                           const SDL_StretchKernel *kernel)
+{
+	int x, t;
+
+	for ( x=0; x<width; ++x ) {
+		const Uint32 *p = src + kernel->first[x];
+		const Sint16 *w = &kernel->weights[x * kernel->stride];
+		const int count = kernel->count[x];
+		Uint32 c0, c1, c2, c3;
+
+		if ( count == 1 ) {
+			dst[x] = *p;
+			continue;
+		}
+		c0 = c1 = c2 = c3 = STRETCH_HALF;
+		for ( t=0; t<count; ++t ) {
+			Uint32 pixel = p[t];
+			Uint32 weight = (Uint32)w[t];
+
+			c0 += (pixel & 0xFF) * weight;
+			c1 += ((pixel >> 8) & 0xFF) * weight;
+			c2 += ((pixel >> 16) & 0xFF) * weight;
+			c3 += (pixel >> 24) * weight;
+		}
+		dst[x] = (c0 >> STRETCH_BITS) |
+		         ((c1 >> STRETCH_BITS) << 8) |
+		         ((c2 >> STRETCH_BITS) << 16) |
+		         ((c3 >> STRETCH_BITS) << 24);
+	}
+}
+
+/* Add weight * row to the per-channel accumulators */
+static void SDL_StretchAccumulate(Uint32 *acc, const Uint32 *row,
+                                  int width, int weight)
+{
+	int x;
+
+	for ( x=0; x<width; ++x ) {
+		Uint32 pixel = row[x];
+
+		acc[0] += (pixel & 0xFF) * weight;
+		acc[1] += ((pixel >> 8) & 0xFF) * weight;
+		acc[2] += ((pixel >> 16) & 0xFF) * weight;
+		acc[3] += (pixel >> 24) * weight;
+		acc += 4;
+	}
+}
+
+static void SDL_StretchResolve(const Uint32 *acc, Uint32 *dst, int width)
+{
+	int x;
+
+	for ( x=0; x<width; ++x ) {
+		dst[x] = ((acc[0] + STRETCH_HALF) >> STRETCH_BITS) |
+		         (((acc[1] + STRETCH_HALF) >> STRETCH_BITS) << 8) |
+		         (((acc[2] + STRETCH_HALF) >> STRETCH_BITS) << 16) |
+		         (((acc[3] + STRETCH_HALF) >> STRETCH_BITS) << 24);
+		acc += 4;
+	}
+}
+
+#if SSE2_BLIT
+/* Taps are taken in pairs so one pmaddwd does two of them per channel */
+static void SDL_StretchRowSSE2(const Uint32 *src, Uint32 *dst, int width,
+                               const SDL_StretchKernel *kernel)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i half = _mm_set1_epi32(STRETCH_HALF);
+	int x, t;
+
+	for ( x=0; x<width; ++x ) {
+		const Uint32 *p = src + kernel->first[x];
+		const Sint16 *w = &kernel->weights[x * kernel->stride];
+		const int count = kernel->count[x];
+		__m128i sum = half;
+
+		if ( count == 1 ) {
+			dst[x] = *p;
+			continue;
+		}
+		for ( t=0; t<count; t+=2 ) {
+			const Uint32 next = (t+1 < count) ? p[t+1] : 0;
+			__m128i ab = _mm_unpacklo_epi8(
+				_mm_cvtsi32_si128((int)p[t]),
+				_mm_cvtsi32_si128((int)next));
+			__m128i wv = _mm_set1_epi32((int)((Uint16)w[t] |
+			                            ((Uint32)(Uint16)w[t+1] << 16)));
+			ab = _mm_unpacklo_epi8(ab, zero);
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(ab, wv));
+		}
+		sum = _mm_srli_epi32(sum, STRETCH_BITS);
+		sum = _mm_packs_epi32(sum, sum);
+		dst[x] = (Uint32)_mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+	}
+}
+
+static void SDL_StretchAccumulateSSE2(Uint32 *acc, const Uint32 *row,
+                                      int width, int weight)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i wv = _mm_set1_epi16((short)weight);
+	int x;
+
+	for ( x=0; x+4<=width; x+=4 ) {
+		__m128i p = _mm_loadu_si128((const __m128i *)(row + x));
+		__m128i lo = _mm_unpacklo_epi8(p, zero);
+		__m128i hi = _mm_unpackhi_epi8(p, zero);
+		__m128i lo_l = _mm_mullo_epi16(lo, wv);
+		__m128i lo_h = _mm_mulhi_epu16(lo, wv);
+		__m128i hi_l = _mm_mullo_epi16(hi, wv);
+		__m128i hi_h = _mm_mulhi_epu16(hi, wv);
+		__m128i *a = (__m128i *)(acc + x*4);
+
+		_mm_storeu_si128(a+0, _mm_add_epi32(_mm_loadu_si128(a+0),
+		                      _mm_unpacklo_epi16(lo_l, lo_h)));
+		_mm_storeu_si128(a+1, _mm_add_epi32(_mm_loadu_si128(a+1),
+		                      _mm_unpackhi_epi16(lo_l, lo_h)));
+		_mm_storeu_si128(a+2, _mm_add_epi32(_mm_loadu_si128(a+2),
+		                      _mm_unpacklo_epi16(hi_l, hi_h)));
+		_mm_storeu_si128(a+3, _mm_add_epi32(_mm_loadu_si128(a+3),
+		                      _mm_unpackhi_epi16(hi_l, hi_h)));
+	}
+	SDL_StretchAccumulate(acc + x*4, row + x, width - x, weight);
+}
+
+static void SDL_StretchResolveSSE2(const Uint32 *acc, Uint32 *dst, int width)
+{
+	const __m128i half = _mm_set1_epi32(STRETCH_HALF);
+	int x;
+
+	for ( x=0; x+4<=width; x+=4 ) {
+		const __m128i *a = (const __m128i *)(acc + x*4);
+		__m128i p0 = _mm_srli_epi32(_mm_add_epi32(
+		                 _mm_loadu_si128(a+0), half), STRETCH_BITS);
+		__m128i p1 = _mm_srli_epi32(_mm_add_epi32(
+		                 _mm_loadu_si128(a+1), half), STRETCH_BITS);
+		__m128i p2 = _mm_srli_epi32(_mm_add_epi32(
+		                 _mm_loadu_si128(a+2), half), STRETCH_BITS);
+		__m128i p3 = _mm_srli_epi32(_mm_add_epi32(
+		                 _mm_loadu_si128(a+3), half), STRETCH_BITS);
+
+		_mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(
+		                 _mm_packs_epi32(p0, p1),
+		                 _mm_packs_epi32(p2, p3)));
+	}
+	SDL_StretchResolve(acc + x*4, dst + x, width - x);
+}
+#endif /* SSE2_BLIT */
+
+#if NEON_BLIT
+static void SDL_StretchAccumulateNEON(Uint32 *acc, const Uint32 *row,
+                                      int width, int weight)
+{
+	const uint16_t w = (uint16_t)weight;
+	int x;
+
+	for ( x=0; x+4<=width; x+=4 ) {
+		uint8x16_t p = vreinterpretq_u8_u32(vld1q_u32(row + x));
+		uint16x8_t lo = vmovl_u8(vget_low_u8(p));
+		uint16x8_t hi = vmovl_u8(vget_high_u8(p));
+		uint32_t *a = acc + x*4;
+
+		vst1q_u32(a+0, vmlal_n_u16(vld1q_u32(a+0), vget_low_u16(lo), w));
+		vst1q_u32(a+4, vmlal_n_u16(vld1q_u32(a+4), vget_high_u16(lo), w));
+		vst1q_u32(a+8, vmlal_n_u16(vld1q_u32(a+8), vget_low_u16(hi), w));
+		vst1q_u32(a+12, vmlal_n_u16(vld1q_u32(a+12), vget_high_u16(hi), w));
+	}
+	SDL_StretchAccumulate(acc + x*4, row + x, width - x, weight);
+}
+
+static void SDL_StretchResolveNEON(const Uint32 *acc, Uint32 *dst, int width)
+{
+	int x;
+
+	for ( x=0; x+4<=width; x+=4 ) {
+		const uint32_t *a = acc + x*4;
+		uint16x8_t lo = vcombine_u16(
+			vrshrn_n_u32(vld1q_u32(a+0), STRETCH_BITS),
+			vrshrn_n_u32(vld1q_u32(a+4), STRETCH_BITS));
+		uint16x8_t hi = vcombine_u16(
+			vrshrn_n_u32(vld1q_u32(a+8), STRETCH_BITS),
+			vrshrn_n_u32(vld1q_u32(a+12), STRETCH_BITS));
+
+		vst1q_u32(dst + x, vreinterpretq_u32_u8(
+		          vcombine_u8(vmovn_u16(lo), vmovn_u16(hi))));
+	}
+	SDL_StretchResolve(acc + x*4, dst + x, width - x);
+}
+#endif /* NEON_BLIT */
+
+/* Expand a row of 15/16/24/32 bpp pixels to 8888, alpha in the top byte */
+static void SDL_StretchToARGB(Uint8 *src, Uint32 *dst, int width,
+                              SDL_PixelFormat *fmt)
+{
+	const int bpp = fmt->BytesPerPixel;
+	Uint32 pixel;
+	unsigned sR, sG, sB, sA;
+
+	while ( width-- ) {
+		DISEMBLE_RGBA(src, bpp, fmt, pixel, sR, sG, sB, sA);
+		if ( !fmt->Amask ) {
+			sA = 0xFF;
+		}
+		*dst++ = (sA << 24) | (sR << 16) | (sG << 8) | sB;
+		src += bpp;
+	}
+}
+
+static void SDL_StretchFromARGB(Uint32 *src, Uint8 *dst, int width,
+                                SDL_PixelFormat *fmt)
+{
+	const int bpp = fmt->BytesPerPixel;
+	unsigned sR, sG, sB, sA;
+
+	while ( width-- ) {
+		Uint32 pixel = *src++;
+
+		sA = fmt->Amask ? pixel >> 24 : 0;
+		sR = (pixel >> 16) & 0xFF;
+		sG = (pixel >> 8) & 0xFF;
+		sB = pixel & 0xFF;
+		ASSEMBLE_RGBA(dst, bpp, fmt, sR, sG, sB, sA);
+		dst += bpp;
+	}
+}
+
+/* Filtering works per byte, so 32-bit pixels with a whole byte for each
+   channel don't need to be unpacked at all */
+static int SDL_StretchBytewise(SDL_PixelFormat *fmt)
+{
+	return (fmt->BytesPerPixel == 4) &&
+	       (fmt->Rloss == 0) && ((fmt->Rshift % 8) == 0) &&
+	       (fmt->Gloss == 0) && ((fmt->Gshift % 8) == 0) &&
+	       (fmt->Bloss == 0) && ((fmt->Bshift % 8) == 0) &&
+	       (!fmt->Amask || ((fmt->Aloss == 0) && ((fmt->Ashift % 8) == 0)));
+}
+
+/* Per-call state of a filtered stretch */
+typedef struct {
+	SDL_Surface *src;
+	SDL_Rect *srcrect;
+	int direct;		/* source rows are already 8888 */
+	SDL_StretchKernel h;
+	Uint32 *line;		/* source row expanded to 8888 */
+	Uint32 *rows[2];	/* horizontally resampled source rows */
+	int cached[2];
+	int recent;
+	void (*row)(const Uint32 *, Uint32 *, int, const SDL_StretchKernel *);
+} SDL_StretchState;
+
+/* Return source row 'y' resampled to the destination width */
+static Uint32 *SDL_StretchFetchRow(SDL_StretchState *state, int y, int width)
+{
+	Uint8 *srcp;
+	Uint32 *in;
+	int slot;
+
+	if ( state->cached[0] == y ) {
+		state->recent = 0;
+		return(state->rows[0]);
+	}
+	if ( state->cached[1] == y ) {
+		state->recent = 1;
+		return(state->rows[1]);
+	}
+	slot = !state->recent;
+
+	srcp = (Uint8 *)state->src->pixels +
+	       (state->srcrect->y + y) * state->src->pitch +
+	       state->srcrect->x * state->src->format->BytesPerPixel;
+	if ( state->direct ) {
+		in = (Uint32 *)srcp;
+	} else {
+		in = state->line;
+		SDL_StretchToARGB(srcp, in, state->srcrect->w,
+		                  state->src->format);
+	}
+	state->row(in, state->rows[slot], width, &state->h);
+	state->cached[slot] = y;
+	state->recent = slot;
+	return(state->rows[slot]);
+}
+
+/* Filtered (or format converting) stretch, both surfaces locked */
+static int SDL_StretchFilteredRows(SDL_Surface *src, SDL_Rect *srcrect,
+                                   SDL_Surface *dst, SDL_Rect *dstrect,
+                                   SDL_StretchFilter filter, int direct)
+{
+	SDL_StretchState state;
+	SDL_StretchKernel v;
+	void (*accumulate)(Uint32 *, const Uint32 *, int, int);
+	void (*resolve)(const Uint32 *, Uint32 *, int);
+	const int dst_w = dstrect->w;
+	const int dbpp = dst->format->BytesPerPixel;
+	Uint32 *buffer, *out, *acc;
+	int y, t;
+
+	state.src = src;
+	state.srcrect = srcrect;
+	state.direct = direct;
+	state.cached[0] = state.cached[1] = -1;
+	state.recent = 0;
+	state.row = SDL_StretchRow;
+	accumulate = SDL_StretchAccumulate;
+	resolve = SDL_StretchResolve;
+#if SSE2_BLIT
+	if ( SDL_HasSSE2() ) {
+		state.row = SDL_StretchRowSSE2;
+		accumulate = SDL_StretchAccumulateSSE2;
+		resolve = SDL_StretchResolveSSE2;
+	}
+#endif
+#if NEON_BLIT
+	accumulate = SDL_StretchAccumulateNEON;
+	resolve = SDL_StretchResolveNEON;
+#endif
+
+	if ( SDL_BuildStretchKernel(&state.h, srcrect->w, dst_w, filter) < 0 ) {
+		return(-1);
+	}
+	if ( SDL_BuildStretchKernel(&v, srcrect->h, dstrect->h, filter) < 0 ) {
+		SDL_FreeStretchKernel(&state.h);
 		return(-1);
 	}
+	/* line, two cached rows, the output row and the accumulators */
+	buffer = (Uint32 *)SDL_malloc((srcrect->w + 7 * dst_w) *
+	                              sizeof(Uint32));
+	if ( !buffer ) {
+		SDL_FreeStretchKernel(&v);
+		SDL_FreeStretchKernel(&state.h);
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	state.line = buffer;
+	state.rows[0] = state.line + srcrect->w;
+	state.rows[1] = state.rows[0] + dst_w;
+	out = state.rows[1] + dst_w;
+	acc = out + dst_w;
+
+	for ( y=0; y<dstrect->h; ++y ) {
+		Uint8 *dstp = (Uint8 *)dst->pixels +
+		              (dstrect->y + y) * dst->pitch +
+		              dstrect->x * dbpp;
+		const Sint16 *w = &v.weights[y * v.stride];
+		Uint32 *result;
+
+		if ( v.count[y] == 1 ) {
+			result = SDL_StretchFetchRow(&state, v.first[y], dst_w);
+		} else {
+			SDL_memset(acc, 0, dst_w * 4 * sizeof(Uint32));
+			for ( t=0; t<v.count[y]; ++t ) {
+				accumulate(acc, SDL_StretchFetchRow(&state,
+				           v.first[y] + t, dst_w), dst_w, w[t]);
+			}
+			result = direct ? (Uint32 *)dstp : out;
+			resolve(acc, result, dst_w);
+		}
+		if ( !direct ) {
+			SDL_StretchFromARGB(result, dstp, dst_w, dst->format);
+		} else if ( result != (Uint32 *)dstp ) {
+			SDL_memcpy(dstp, result, dst_w * sizeof(Uint32));
+		}
+	}
+
+	SDL_free(buffer);
+	SDL_FreeStretchKernel(&v);
+	SDL_FreeStretchKernel(&state.h);
+	return(0);
+}
+
+int SDL_SoftStretchFiltered(SDL_Surface *src, SDL_Rect *srcrect,
+                            SDL_Surface *dst, SDL_Rect *dstrect,
+                            SDL_StretchFilter filter)
+{
+	int src_locked;
+	int dst_locked;
+	int same_format;
+	int status;
+	SDL_Rect full_src;
+	SDL_Rect full_dst;
+	SDL_PixelFormat *sfmt = src->format;
+	SDL_PixelFormat *dfmt = dst->format;
+
+	same_format = (sfmt->BitsPerPixel == dfmt->BitsPerPixel) &&
+	              (sfmt->Rmask == dfmt->Rmask) &&
+	              (sfmt->Gmask == dfmt->Gmask) &&
+	              (sfmt->Bmask == dfmt->Bmask) &&
+	              (sfmt->Amask == dfmt->Amask);
+	if ( (sfmt->BytesPerPixel == 1) || (dfmt->BytesPerPixel == 1) ) {
+		/* Palette indices can only be copied */
+		if ( sfmt->BitsPerPixel != dfmt->BitsPerPixel ) {
+			SDL_SetError("Only works with same format surfaces");
+			return(-1);
+		}
+		same_format = 1;
+		filter = SDL_STRETCH_NEAREST;
+	}
 
 	/* Verify the blit rectangles */
 	if ( srcrect ) {
@@ -253,6 +686,9 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 		full_dst.h = dst->h;
 		dstrect = &full_dst;
 	}
+	if ( !srcrect->w || !srcrect->h || !dstrect->w || !dstrect->h ) {
+		return(0);
+	}
 
 	/* Lock the destination if it's in hardware */
 	dst_locked = 0;
@@ -263,10 +699,11 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 		}
 		dst_locked = 1;
 	}
-	/* Lock the source if it's in hardware */
+	/* Lock the source if it's in hardware, only reading it so that any
+	   RLE encoding is kept */
 	src_locked = 0;
 	if ( SDL_MUSTLOCK(src) ) {
-		if ( SDL_LockSurface(src) < 0 ) {
+		if ( SDL_LockSurfaceReadOnly(src) < 0 ) {
 			if ( dst_locked ) {
 				SDL_UnlockSurface(dst);
 			}
@@ -276,74 +713,13 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 		src_locked = 1;
 	}
 
-	/* Set up the data... */
-	pos = 0x10000;
-	inc = (srcrect->h << 16) / dstrect->h;
-	src_row = srcrect->y;
-	dst_row = dstrect->y;
-
-#ifdef USE_ASM_STRETCH
-	/* Write the opcodes for this stretch */
-	if ( (bpp == 3) ||
-	     (generate_rowbytes(srcrect->w, dstrect->w, bpp) < 0) ) {
-		use_asm = SDL_FALSE;
-	}
-#endif
-
 	/* Perform the stretch blit */
-	for ( dst_maxrow = dst_row+dstrect->h; dst_row<dst_maxrow; ++dst_row ) {
-		dstp = (Uint8 *)dst->pixels + (dst_row*dst->pitch)
-		                            + (dstrect->x*bpp);
-		while ( pos >= 0x10000L ) {
-			srcp = (Uint8 *)src->pixels + (src_row*src->pitch)
-			                            + (srcrect->x*bpp);
-			++src_row;
-			pos -= 0x10000L;
-		}
-#ifdef USE_ASM_STRETCH
-		if (use_asm) {
-#ifdef __GNUC__
-			__asm__ __volatile__ (
-			"call *%4"
-			: "=&D" (u1), "=&S" (u2)
-			: "0" (dstp), "1" (srcp), "r" (copy_row)
-			: "memory" );
-#elif defined(_MSC_VER) || defined(__WATCOMC__)
-		{ void *code = copy_row;
-			__asm {
-				push edi
-				push esi
-	
-				mov edi, dstp
-				mov esi, srcp
-				call dword ptr code
-
-				pop esi
-				pop edi
-			}
-		}
-#else
-#error Need inline assembly for this compiler
-#endif
-		} else
-#endif
-		switch (bpp) {
-		    case 1:
-			copy_row1(srcp, srcrect->w, dstp, dstrect->w);
-			break;
-		    case 2:
-			copy_row2((Uint16 *)srcp, srcrect->w,
-			          (Uint16 *)dstp, dstrect->w);
-			break;
-		    case 3:
-			copy_row3(srcp, srcrect->w, dstp, dstrect->w);
-			break;
-		    case 4:
-			copy_row4((Uint32 *)srcp, srcrect->w,
-			          (Uint32 *)dstp, dstrect->w);
-			break;
-		}
-		pos += inc;
+	status = 0;
+	if ( same_format && (filter == SDL_STRETCH_NEAREST) ) {
+		SDL_StretchNearest(src, srcrect, dst, dstrect);
+	} else {
+		status = SDL_StretchFilteredRows(src, srcrect, dst, dstrect,
+		                filter, same_format && SDL_StretchBytewise(dfmt));
 	}
 
 	/* We need to unlock the surfaces if they're locked */
@@ -353,6 +729,12 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 	if ( src_locked ) {
 		SDL_UnlockSurface(src);
 	}
-	return(0);
+	return(status);
 }
 
+int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
+                    SDL_Surface *dst, SDL_Rect *dstrect)
+{
+	return SDL_SoftStretchFiltered(src, srcrect, dst, dstrect,
+	                               SDL_STRETCH_NEAREST);
+}
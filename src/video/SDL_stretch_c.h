@@ -21,9 +21,11 @@
 */
 #include "SDL_config.h"
 
-/* Perform a stretch blit between two surfaces of the same format.
-   NOTE:  This function is not safe to call from multiple threads!
+/* Perform a stretch blit between two surfaces.  Both functions are
+   reentrant; the filtered one also converts between pixel formats.
 */
 extern int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
                            SDL_Surface *dst, SDL_Rect *dstrect);
-
+extern int SDL_SoftStretchFiltered(SDL_Surface *src, SDL_Rect *srcrect,
+                                   SDL_Surface *dst, SDL_Rect *dstrect,
+                                   SDL_StretchFilter filter);
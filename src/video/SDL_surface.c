@@ -22,6 +22,7 @@
 #include "SDL_config.h"
 
 #include "SDL_video.h"
+#include "SDL_cpuinfo.h"
 #include "SDL_sysvideo.h"
 #include "SDL_cursor_c.h"
 #include "SDL_blit.h"
@@ -193,7 +194,7 @@ int SDL_SetColorKey (SDL_Surface *surface, Uint32 flag, Uint32 key)
 
 	/* UnRLE surfaces before we change the colorkey */
 	if ( surface->flags & SDL_RLEACCEL ) {
-	        SDL_UnRLESurface(surface, 1);
+	        SDL_UnRLESurface(surface);
 	}
 
 	if ( flag ) {
@@ -245,7 +246,7 @@ int SDL_SetAlpha (SDL_Surface *surface, Uint32 flag, Uint8 value)
 	}
 
 	if(!(flag & SDL_RLEACCELOK) && (surface->flags & SDL_RLEACCEL))
-		SDL_UnRLESurface(surface, 1);
+		SDL_UnRLESurface(surface);
 
 	if ( flag ) {
 		SDL_VideoDevice *video = current_video;
@@ -547,61 +548,118 @@ static int SDL_FillRect4(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 	return -1;
 }
 
-/* 
- * This function performs a fast fill of the given rectangle with 'color'
- */
-int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
-{
-	SDL_VideoDevice *video = current_video;
-	SDL_VideoDevice *this  = current_video;
-	int x, y;
-	Uint8 *row;
+/* Repeat the bytes of a pixel through 'pattern', which must hold at least
+   FILL_PATTERN_BYTES.  Every multiple of 48 bytes starts a new pixel. */
+#define FILL_PATTERN_BYTES	64
 
-	/* This function doesn't work on surfaces < 8 bpp */
-	if ( dst->format->BitsPerPixel < 8 ) {
-		switch(dst->format->BitsPerPixel) {
-		    case 1:
-			return SDL_FillRect1(dst, dstrect, color);
-			break;
-		    case 4:
-			return SDL_FillRect4(dst, dstrect, color);
-			break;
-		    default:
-			SDL_SetError("Fill rect on unsupported surface format");
-			return(-1);
-			break;
-		}
+static void SDL_FillPattern(Uint8 *pattern, int bpp, Uint32 color)
+{
+	Uint8 pixel[4];
+	int i;
+
+	switch (bpp) {
+	    case 1:
+		pixel[0] = (Uint8)color;
+		break;
+	    case 2: {
+		Uint16 c = (Uint16)color;
+		SDL_memcpy(pixel, &c, 2);
+	    }
+		break;
+	    case 3:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		color <<= 8;
+#endif
+		SDL_memcpy(pixel, &color, 3);
+		break;
+	    default:
+		SDL_memcpy(pixel, &color, 4);
+		break;
 	}
-
-	/* If 'dstrect' == NULL, then fill the whole surface */
-	if ( dstrect ) {
-		/* Perform clipping */
-		if ( !SDL_IntersectRect(dstrect, &dst->clip_rect, dstrect) ) {
-			return(0);
-		}
-	} else {
-		dstrect = &dst->clip_rect;
+	for ( i = 0; i < FILL_PATTERN_BYTES; ++i ) {
+		pattern[i] = pixel[i % bpp];
 	}
+}
 
-	/* Check for hardware acceleration */
-	if ( ((dst->flags & SDL_HWSURFACE) == SDL_HWSURFACE) &&
-					video->info.blit_fill ) {
-		SDL_Rect hw_rect;
-		if ( dst == SDL_VideoSurface ) {
-			hw_rect = *dstrect;
-			hw_rect.x += current_video->offset_x;
-			hw_rect.y += current_video->offset_y;
-			dstrect = &hw_rect;
+#if SSE2_BLIT
+/* Fills bigger than this bypass the caches with streaming stores, since
+   the data would only evict everything else from them */
+#define STREAMING_FILL_BYTES	(4*1024*1024)
+
+/* Fill 'h' rows of 'len' bytes with a pixel of 'bpp' bytes.  The pixel
+   pattern repeats every 48 bytes, three vectors, for any pixel size. */
+static void SDL_FillRectSSE2(Uint8 *row, int pitch, int len, int h,
+			     int bpp, Uint32 color)
+{
+	Uint8 pattern[FILL_PATTERN_BYTES];
+	int stream = (len * h >= STREAMING_FILL_BYTES);
+
+	SDL_FillPattern(pattern, bpp, color);
+	while ( h-- ) {
+		Uint8 *d = row;
+		int n = len;
+		int head = (int)(-(uintptr_t)d & 15);
+		__m128i v0, v1, v2;
+
+		if ( head > n ) {
+			head = n;
 		}
-		return(video->FillHWRect(this, dst, dstrect, color));
+		SDL_memcpy(d, pattern, head);
+		d += head;
+		n -= head;
+
+		v0 = _mm_loadu_si128((__m128i *)(pattern + head % bpp));
+		v1 = _mm_loadu_si128((__m128i *)(pattern + head % bpp + 16));
+		v2 = _mm_loadu_si128((__m128i *)(pattern + head % bpp + 32));
+		if ( stream ) {
+			for ( ; n >= 48; n -= 48, d += 48 ) {
+				_mm_stream_si128((__m128i *)d, v0);
+				_mm_stream_si128((__m128i *)(d + 16), v1);
+				_mm_stream_si128((__m128i *)(d + 32), v2);
+			}
+		} else {
+			for ( ; n >= 48; n -= 48, d += 48 ) {
+				_mm_store_si128((__m128i *)d, v0);
+				_mm_store_si128((__m128i *)(d + 16), v1);
+				_mm_store_si128((__m128i *)(d + 32), v2);
+			}
+		}
+		if ( n >= 16 ) {
+			_mm_store_si128((__m128i *)d, v0);
+			d += 16;
+			n -= 16;
+			if ( n >= 16 ) {
+				_mm_store_si128((__m128i *)d, v1);
+				d += 16;
+				n -= 16;
+			}
+		}
+		SDL_memcpy(d, pattern + (d - row) % bpp, n);
+		row += pitch;
 	}
-
-	/* Perform software fill */
-	if ( SDL_LockSurface(dst) != 0 ) {
-		return(-1);
+	if ( stream ) {
+		/* Make the streamed data visible before the surface unlocks */
+		_mm_sfence();
 	}
+}
+#endif /* SSE2_BLIT */
+
+/* Fill an already clipped rectangle of a locked surface */
+static void SDL_SoftFillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
+{
+	int x, y;
+	Uint8 *row;
+
 	row = (Uint8 *)dst->pixels+dstrect->y*dst->pitch+
 			dstrect->x*dst->format->BytesPerPixel;
+#if SSE2_BLIT
+	if ( SDL_HasSSE2() ) {
+		SDL_FillRectSSE2(row, dst->pitch,
+				 dstrect->w*dst->format->BytesPerPixel,
+				 dstrect->h, dst->format->BytesPerPixel, color);
+		return;
+	}
+#endif
 	if ( dst->format->palette || (color == 0) ) {
 		x = dstrect->w*dst->format->BytesPerPixel;
 		if ( !color && !((uintptr_t)row&3) && !(x&3) && !(dst->pitch&3) ) {
@@ -702,18 +760,27 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 			}
 			break;
 
-		    case 3:
-			#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-				color <<= 8;
-			#endif
-			for ( y=dstrect->h; y; --y ) {
-				Uint8 *pixels = row;
-				for ( x=dstrect->w; x; --x ) {
-					SDL_memcpy(pixels, &color, 3);
-					pixels += 3;
-				}
+		    case 3: {
+			/* Fill the first row by doubling the filled part,
+			   then copy that row to the rest */
+			Uint8 pattern[FILL_PATTERN_BYTES];
+			Uint8 *first = row;
+			int n;
+
+			SDL_FillPattern(pattern, 3, color);
+			x = dstrect->w*3;
+			n = (x < 48) ? x : 48;
+			SDL_memcpy(row, pattern, n);
+			while ( n < x ) {
+				int copy = (n < x-n) ? n : x-n;
+				SDL_memcpy(row+n, row, copy);
+				n += copy;
+			}
+			for ( y=dstrect->h-1; y; --y ) {
 				row += dst->pitch;
+				SDL_memcpy(row, first, x);
 			}
+		    }
 			break;
 
 		    case 4:
@@ -724,16 +791,151 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 			break;
 		}
 	}
+}
+
+/*
+ * Check that a surface can be filled, returning -1 if not
+ */
+static int SDL_CanFillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
+{
+	/* This function doesn't work on surfaces < 8 bpp */
+	if ( dst->format->BitsPerPixel < 8 ) {
+		switch(dst->format->BitsPerPixel) {
+		    case 1:
+			return SDL_FillRect1(dst, dstrect, color);
+			break;
+		    case 4:
+			return SDL_FillRect4(dst, dstrect, color);
+			break;
+		    default:
+			SDL_SetError("Fill rect on unsupported surface format");
+			return(-1);
+			break;
+		}
+	}
+	return(0);
+}
+
+/*
+ * Fill a clipped rectangle with the video hardware, returning 1 if there
+ * is no hardware acceleration for the surface
+ */
+static int SDL_FillHWRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_VideoDevice *this  = current_video;
+	SDL_Rect hw_rect;
+
+	if ( ((dst->flags & SDL_HWSURFACE) != SDL_HWSURFACE) ||
+					!video->info.blit_fill ) {
+		return(1);
+	}
+	if ( dst == SDL_VideoSurface ) {
+		hw_rect = *dstrect;
+		hw_rect.x += current_video->offset_x;
+		hw_rect.y += current_video->offset_y;
+		dstrect = &hw_rect;
+	}
+	return(video->FillHWRect(this, dst, dstrect, color));
+}
+
+/* 
+ * This function performs a fast fill of the given rectangle with 'color'
+ */
+int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
+{
+	int retval;
+
+	if ( SDL_CanFillRect(dst, dstrect, color) < 0 ) {
+		return(-1);
+	}
+
+	/* If 'dstrect' == NULL, then fill the whole surface */
+	if ( dstrect ) {
+		/* Perform clipping */
+		if ( !SDL_IntersectRect(dstrect, &dst->clip_rect, dstrect) ) {
+			return(0);
+		}
+	} else {
+		dstrect = &dst->clip_rect;
+	}
+
+	/* Check for hardware acceleration */
+	retval = SDL_FillHWRect(dst, dstrect, color);
+	if ( retval <= 0 ) {
+		return(retval);
+	}
+
+	/* Perform software fill */
+	if ( SDL_LockSurface(dst) != 0 ) {
+		return(-1);
+	}
+	SDL_SoftFillRect(dst, dstrect, color);
 	SDL_UnlockSurface(dst);
 
 	/* We're done! */
 	return(0);
 }
 
+/*
+ * Fill many rectangles, clipping and locking the surface only once
+ */
+int SDL_FillRects(SDL_Surface *dst, int numrects, SDL_Rect *rects, Uint32 color)
+{
+	int i;
+	int retval;
+	int locked;
+
+	if ( SDL_CanFillRect(dst, rects, color) < 0 ) {
+		return(-1);
+	}
+
+	retval = 0;
+	locked = 0;
+	for ( i = 0; i < numrects; ++i ) {
+		SDL_Rect *rect = &rects[i];
+		int hw;
+
+		/* Perform clipping, leaving empty rectangles for any that
+		   fall outside of the clip area */
+		if ( !SDL_IntersectRect(rect, &dst->clip_rect, rect) ) {
+			continue;
+		}
+
+		hw = locked ? 1 : SDL_FillHWRect(dst, rect, color);
+		if ( hw < 0 ) {
+			retval = -1;
+		} else if ( hw > 0 ) {
+			if ( !locked ) {
+				if ( SDL_LockSurface(dst) != 0 ) {
+					return(-1);
+				}
+				locked = 1;
+			}
+			SDL_SoftFillRect(dst, rect, color);
+		}
+	}
+	if ( locked ) {
+		SDL_UnlockSurface(dst);
+	}
+	return(retval);
+}
+
 /*
  * Lock a surface to directly access the pixels
  */
 int SDL_LockSurface (SDL_Surface *surface)
+{
+	/* The pixels may change, so any RLE encoding will be stale */
+	if ( surface->flags & SDL_RLEACCEL ) {
+		SDL_UnRLESurface(surface);
+	}
+	return(SDL_LockSurfaceReadOnly(surface));
+}
+/*
+ * Lock a surface to read the pixels, keeping any RLE encoding
+ */
+int SDL_LockSurfaceReadOnly (SDL_Surface *surface)
 {
 	if ( ! surface->locked ) {
 		/* Perform the lock */
@@ -744,10 +946,6 @@ int SDL_LockSurface (SDL_Surface *surface)
 				return(-1);
 			}
 		}
-		if ( surface->flags & SDL_RLEACCEL ) {
-			SDL_UnRLESurface(surface, 1);
-			surface->flags |= SDL_RLEACCEL;	/* save accel'd state */
-		}
 		/* This needs to be done here in case pixels changes value */
 		surface->pixels = (Uint8 *)surface->pixels + surface->offset;
 	}
@@ -776,12 +974,6 @@ void SDL_UnlockSurface (SDL_Surface *surface)
 		SDL_VideoDevice *video = current_video;
 		SDL_VideoDevice *this  = current_video;
 		video->UnlockHWSurface(this, surface);
-	} else {
-		/* Update RLE encoded surface with new data */
-		if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
-		        surface->flags &= ~SDL_RLEACCEL; /* stop lying */
-			SDL_RLESurface(surface);
-		}
 	}
 }
 
@@ -915,7 +1107,7 @@ void SDL_FreeSurface (SDL_Surface *surface)
 		SDL_UnlockSurface(surface);
 	}
 	if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
-	        SDL_UnRLESurface(surface, 0);
+	        SDL_UnRLESurface(surface);
 	}
 	if ( surface->format ) {
 		SDL_FreeFormat(surface->format);
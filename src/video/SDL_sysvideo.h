@@ -269,6 +269,7 @@ struct SDL_VideoDevice {
 	char *wm_icon;
 	int offset_x;
 	int offset_y;
+	int max_update_rects;	/* coalesce update rects down to this, if != 0 */
 	SDL_GrabMode input_grab;
 
 	/* Driver information flags */
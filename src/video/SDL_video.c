@@ -225,7 +225,17 @@ int SDL_VideoInit (const char *driver_name, Uint32 flags)
 	video->wm_icon  = NULL;
 	video->offset_x = 0;
 	video->offset_y = 0;
+	video->max_update_rects = 0;
 	SDL_memset(&video->info, 0, (sizeof video->info));
+	{
+		const char *coalesce = SDL_getenv("SDL_VIDEO_COALESCE_RECTS");
+		if ( coalesce ) {
+			video->max_update_rects = SDL_atoi(coalesce);
+			if ( video->max_update_rects < 0 ) {
+				video->max_update_rects = 0;
+			}
+		}
+	}
 	
 	video->displayformatalphapixel = NULL;
 
@@ -1017,6 +1027,156 @@ SDL_Surface *SDL_DisplayFormatAlpha(SDL_Surface *surface)
 	return(converted);
 }
 
+/*
+ * Merge an update rectangle list into a smaller, non-overlapping one.
+ * Overlapping rectangles are replaced by their bounding box, and so are
+ * touching ones when that box covers no more pixels than they did.
+ * If more than maxrects remain, runs of neighbouring rectangles are
+ * folded into their bounding boxes until the list fits.
+ */
+#define RECT_AREA(r)	((int)(r).w * (int)(r).h)
+
+static void SDL_RectUnion(const SDL_Rect *a, const SDL_Rect *b, SDL_Rect *u)
+{
+	int x1 = SDL_min(a->x, b->x);
+	int y1 = SDL_min(a->y, b->y);
+	int x2 = SDL_max(a->x + a->w, b->x + b->w);
+	int y2 = SDL_max(a->y + a->h, b->y + b->h);
+	u->x = x1;
+	u->y = y1;
+	u->w = x2 - x1;
+	u->h = y2 - y1;
+}
+
+/* Sort top to bottom, then left to right */
+static int SDL_CompareRects(const void *p1, const void *p2)
+{
+	const SDL_Rect *a = (const SDL_Rect *)p1;
+	const SDL_Rect *b = (const SDL_Rect *)p2;
+	if ( a->y != b->y ) {
+		return(a->y - b->y);
+	}
+	return(a->x - b->x);
+}
+
+/*
+ * Set u to the bounding box of a and b if they should be merged.
+ * Returns 0 if not, 1 if u covers exactly a and b, or 2 if it covers
+ * more than that.
+ */
+static int SDL_TryMergeRects(const SDL_Rect *a, const SDL_Rect *b, SDL_Rect *u)
+{
+	int iw, ih, area;
+
+	if ( (a->x > b->x + b->w) || (b->x > a->x + a->w) ||
+	     (a->y > b->y + b->h) || (b->y > a->y + a->h) ) {
+		return(0);
+	}
+	iw = SDL_min(a->x + a->w, b->x + b->w) - SDL_max(a->x, b->x);
+	ih = SDL_min(a->y + a->h, b->y + b->h) - SDL_max(a->y, b->y);
+	SDL_RectUnion(a, b, u);
+	area = RECT_AREA(*a) + RECT_AREA(*b);
+	if ( iw > 0 && ih > 0 ) {
+		area -= iw * ih;
+	} else if ( RECT_AREA(*u) > area ) {
+		return(0);	/* only touching, and the box adds pixels */
+	}
+	return(RECT_AREA(*u) > area ? 2 : 1);
+}
+
+/* Merge a list sorted by SDL_CompareRects in place, returning its length */
+static int SDL_MergeRects(SDL_Rect *rects, int n)
+{
+	int i, j, m, first, lo, slot;
+	SDL_Rect r, u;
+
+	m = 0;
+	first = 0;
+	for ( i=0; i<n; ++i ) {
+		r = rects[i];
+
+		/* Output rectangles ending above this one can't touch it or
+		   any rectangle after it, so they needn't be checked again */
+		while ( first < m && (!rects[first].w ||
+		        rects[first].y + rects[first].h < r.y) ) {
+			++first;
+		}
+
+		/* Grow r by every output rectangle it merges with.  Those are
+		   emptied, and r takes the place of the earliest, whose top
+		   edge it keeps, so the output stays sorted.  A box that covers
+		   more than its parts may reach any output rectangle. */
+		slot = m;
+		lo = first;
+		for ( j=m-1; j>=lo; --j ) {
+			int merged;
+			if ( !rects[j].w ) {
+				continue;
+			}
+			merged = SDL_TryMergeRects(&rects[j], &r, &u);
+			if ( !merged ) {
+				continue;
+			}
+			if ( merged == 2 ) {
+				lo = 0;
+			}
+			r = u;
+			rects[j].w = 0;
+			if ( j < slot ) {
+				slot = j;
+			}
+			j = m;	/* r grew, check again */
+		}
+		rects[slot] = r;
+		if ( slot == m ) {
+			++m;
+		}
+		if ( slot < first ) {
+			first = slot;
+		}
+	}
+
+	for ( i=0, j=0; i<m; ++i ) {
+		if ( rects[i].w ) {
+			rects[j++] = rects[i];
+		}
+	}
+	return(j);
+}
+
+static int SDL_CoalesceRects(int numrects, const SDL_Rect *rects,
+                             SDL_Rect *out, int maxrects)
+{
+	int i, j, n, per;
+	SDL_Rect u;
+
+	n = 0;
+	for ( i=0; i<numrects; ++i ) {
+		if ( rects[i].w && rects[i].h ) {
+			out[n++] = rects[i];
+		}
+	}
+	SDL_qsort(out, n, sizeof(*out), SDL_CompareRects);
+	n = SDL_MergeRects(out, n);
+
+	/* Still too many: fold each run of per neighbours in sorted order
+	   into its bounding box.  The boxes stay sorted by top edge, and
+	   are merged again in case they overlap. */
+	if ( n > maxrects ) {
+		per = (n + maxrects - 1) / maxrects;
+		for ( i=0, j=0; i<n; i+=per, ++j ) {
+			int k;
+			u = out[i];
+			for ( k=i+1; k<n && k<i+per; ++k ) {
+				SDL_RectUnion(&u, &out[k], &u);
+			}
+			out[j] = u;
+		}
+		n = SDL_MergeRects(out, j);
+	}
+	return(n);
+}
+
 /*
  * Update a specific portion of the physical screen
  */
@@ -1046,6 +1206,7 @@ void SDL_UpdateRect(SDL_Surface *screen, Sint32 x, Sint32 y, Uint32 w, Uint32 h)
 void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 {
 	int i;
+	SDL_Rect *merged = NULL;
 	SDL_VideoDevice *video = current_video;
 	SDL_VideoDevice *this = current_video;
 
@@ -1053,6 +1214,15 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 		SDL_SetError("OpenGL active, use SDL_GL_SwapBuffers()");
 		return;
 	}
+	if ( video->max_update_rects && numrects > 1 ) {
+		/* Blit and update a minimal set of rectangles instead */
+		merged = SDL_stack_alloc(SDL_Rect, numrects);
+		if ( merged ) {
+			numrects = SDL_CoalesceRects(numrects, rects,
+			                    merged, video->max_update_rects);
+			rects = merged;
+		}
+	}
 	if ( screen == SDL_ShadowSurface ) {
 		/* Blit the shadow surface using saved mapping */
 		SDL_Palette *pal = screen->format->palette;
@@ -1106,6 +1276,9 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 			video->UpdateRects(this, numrects, rects);
 		}
 	}
+	if ( merged ) {
+		SDL_stack_free(merged);
+	}
 }
 
 /*
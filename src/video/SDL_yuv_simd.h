@@ -0,0 +1,269 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+/*
+   The vector YUV to RGB converters.  This file is included by
+   SDL_yuv_sw.c once for each instruction set, after defining:
+
+     YUV_SIMD(name)	the name of a function for this instruction set
+     YUV_TARGET		the attributes of those functions
+     YUV_STEP		the number of 16-bit lanes in a vector
+     V			the vector type, and the V_* operations on it
+
+   They give exactly the results of the table driven C converters: the
+   chroma tables are reproduced with fixed point factors which are
+   checked against the tables when the overlay is created (see
+   SetupSIMD), and clamping the sums to 0-255 does what the spread
+   out ends of rgb_2_pix do.
+*/
+
+/* The chroma table entry for c-128: c times a 1.15 factor, rounded
+   towards zero like the (int) casts in the table generation */
+static __inline__ YUV_TARGET V YUV_SIMD(Scale)(V c, V k)
+{
+	V sign = V_SRAI16(c, 15);
+	V m = V_SUB16(V_XOR(c, sign), sign);
+
+	m = V_MULHI_U16(V_ADD16(m, m), k);
+	return V_SUB16(V_XOR(m, sign), sign);
+}
+
+/* Convert a row of pixels, YUV_STEP at a time, finishing with the C
+   table lookups.  Packed rows have the luma in every other byte and
+   alternating chroma in the bytes between, full rows have a chroma
+   sample for every pixel rather than every pair. */
+static __inline__ YUV_TARGET void YUV_SIMD(Row)(const int *colortab,
+				const Uint32 *rgb_2_pix, const Uint8 *lum,
+				const Uint8 *cr, const Uint8 *cb, Uint8 *out,
+				int cols, int bpp, int layout)
+{
+	int packed = (layout == YUV_PACKED);
+	const int *params = colortab + YUV_SIMD_PARAMS;
+	const V k_rr = V_SET16(params[0]);
+	const V k_gr = V_SET16(params[1]);
+	const V k_gb = V_SET16(params[2]);
+	const V k_bb = V_SET16(params[3]);
+	const V bias = V_SET16(128);
+	const V white = V_SET16(255);
+	const V lowbyte = V_SET16(0x00FF);
+	const V zero = V_ZERO();
+	const __m128i rloss = _mm_cvtsi32_si128(params[4]);
+	const __m128i rshift = _mm_cvtsi32_si128(params[5]);
+	const __m128i gloss = _mm_cvtsi32_si128(params[6]);
+	const __m128i gshift = _mm_cvtsi32_si128(params[7]);
+	const __m128i bloss = _mm_cvtsi32_si128(params[8]);
+	const __m128i bshift = _mm_cvtsi32_si128(params[9]);
+	const Uint8 *base = lum;
+	int lum_odd = 0;
+	int cr_first = (cr < cb);
+	int lstep = packed ? 2 : 1;
+	int cstep = packed ? 4 : 1;
+	int cpixels = (layout == YUV_FULL) ? 1 : 2;
+	Uint32 tmp[YUV_STEP];
+	int x, i;
+
+	if ( packed ) {
+		if ( cr < base ) base = cr;
+		if ( cb < base ) base = cb;
+		lum_odd = (lum != base);
+	}
+	for ( x = 0; x + YUV_STEP <= cols; x += YUV_STEP ) {
+		V y, vcr, vcb, r, g, b;
+
+		if ( packed ) {
+			V w = V_LOAD(base);
+			V c, even, odd;
+
+			if ( lum_odd ) {
+				y = V_SRLI16(w, 8);
+				c = V_AND(w, lowbyte);
+			} else {
+				y = V_AND(w, lowbyte);
+				c = V_SRLI16(w, 8);
+			}
+			/* Each chroma value covers a pair of pixels */
+			even = V_SRLI32(V_SLLI32(c, 16), 16);
+			even = V_OR(even, V_SLLI32(even, 16));
+			odd = V_SRLI32(c, 16);
+			odd = V_OR(odd, V_SLLI32(odd, 16));
+			vcr = cr_first ? even : odd;
+			vcb = cr_first ? odd : even;
+			base += 2*YUV_STEP;
+		} else if ( layout == YUV_FULL ) {
+			y = V_LOAD_LUMA(lum);
+			vcr = V_LOAD_LUMA(cr);
+			vcb = V_LOAD_LUMA(cb);
+			lum += YUV_STEP;
+			cr += YUV_STEP;
+			cb += YUV_STEP;
+		} else {
+			y = V_LOAD_LUMA(lum);
+			vcr = V_LOAD_CHROMA(cr);
+			vcb = V_LOAD_CHROMA(cb);
+			lum += YUV_STEP;
+			cr += YUV_STEP/2;
+			cb += YUV_STEP/2;
+		}
+		vcr = V_SUB16(vcr, bias);
+		vcb = V_SUB16(vcb, bias);
+
+		r = V_ADD16(y, YUV_SIMD(Scale)(vcr, k_rr));
+		g = V_SUB16(y, V_ADD16(YUV_SIMD(Scale)(vcr, k_gr),
+		                       YUV_SIMD(Scale)(vcb, k_gb)));
+		b = V_ADD16(y, YUV_SIMD(Scale)(vcb, k_bb));
+		r = V_SRL16(V_MAX16(V_MIN16(r, white), zero), rloss);
+		g = V_SRL16(V_MAX16(V_MIN16(g, white), zero), gloss);
+		b = V_SRL16(V_MAX16(V_MIN16(b, white), zero), bloss);
+
+		if ( bpp == 2 ) {
+			V p = V_SLL16(r, rshift);
+			p = V_OR(p, V_SLL16(g, gshift));
+			p = V_OR(p, V_SLL16(b, bshift));
+			V_STORE(out, p);
+			out += YUV_STEP*2;
+		} else {
+			V lo = V_SLL32(V_WIDEN_LO(r), rshift);
+			V hi = V_SLL32(V_WIDEN_HI(r), rshift);
+			lo = V_OR(lo, V_SLL32(V_WIDEN_LO(g), gshift));
+			hi = V_OR(hi, V_SLL32(V_WIDEN_HI(g), gshift));
+			lo = V_OR(lo, V_SLL32(V_WIDEN_LO(b), bshift));
+			hi = V_OR(hi, V_SLL32(V_WIDEN_HI(b), bshift));
+			if ( bpp == 4 ) {
+				V_STORE(out, lo);
+				V_STORE(out + YUV_STEP*2, hi);
+				out += YUV_STEP*4;
+			} else {
+				V_STORE(tmp, lo);
+				V_STORE(tmp + YUV_STEP/2, hi);
+				for ( i = 0; i < YUV_STEP; ++i ) {
+					*out++ = (tmp[i]      ) & 0xFF;
+					*out++ = (tmp[i] >>  8) & 0xFF;
+					*out++ = (tmp[i] >> 16) & 0xFF;
+				}
+			}
+		}
+	}
+	if ( packed ) {
+		/* The scalar tail uses the real pointers */
+		lum += x * 2;
+		cr += x * 2;
+		cb += x * 2;
+	}
+	for ( ; x < cols; x += cpixels ) {
+		int cr_r   = 0*768+256 + colortab[ *cr + 0*256 ];
+		int crb_g  = 1*768+256 + colortab[ *cr + 1*256 ]
+		                       + colortab[ *cb + 2*256 ];
+		int cb_b   = 2*768+256 + colortab[ *cb + 3*256 ];
+		cr += cstep; cb += cstep;
+
+		for ( i = 0; i < cpixels; ++i ) {
+			int L = *lum;
+			Uint32 value = (rgb_2_pix[ L + cr_r ] |
+			                rgb_2_pix[ L + crb_g ] |
+			                rgb_2_pix[ L + cb_b ]);
+			lum += lstep;
+			switch (bpp) {
+			    case 2:
+				*(Uint16 *)out = (Uint16)value;
+				break;
+			    case 3:
+				out[0] = (value      ) & 0xFF;
+				out[1] = (value >>  8) & 0xFF;
+				out[2] = (value >> 16) & 0xFF;
+				break;
+			    default:
+				*(Uint32 *)out = value;
+				break;
+			}
+			out += bpp;
+		}
+	}
+}
+
+static __inline__ YUV_TARGET void YUV_SIMD(YV12)(int *colortab,
+				Uint32 *rgb_2_pix, unsigned char *lum,
+				unsigned char *cr, unsigned char *cb,
+				unsigned char *out, int rows, int cols,
+				int mod, int bpp)
+{
+	int pitch = (cols + mod) * bpp;
+	int y;
+
+	/* Like the C converters, an odd last row is left alone */
+	for ( y = 0; y < (rows & ~1); ++y ) {
+		YUV_SIMD(Row)(colortab, rgb_2_pix, lum, cr, cb, out,
+		              cols, bpp, YUV_PAIRED);
+		lum += cols;
+		out += pitch;
+		if ( y & 1 ) {
+			cr += cols / 2;
+			cb += cols / 2;
+		}
+	}
+}
+
+static __inline__ YUV_TARGET void YUV_SIMD(YUY2)(int *colortab,
+				Uint32 *rgb_2_pix, unsigned char *lum,
+				unsigned char *cr, unsigned char *cb,
+				unsigned char *out, int rows, int cols,
+				int mod, int bpp)
+{
+	int pitch = (cols + mod) * bpp;
+	int y;
+
+	for ( y = 0; y < rows; ++y ) {
+		YUV_SIMD(Row)(colortab, rgb_2_pix, lum, cr, cb, out,
+		              cols, bpp, YUV_PACKED);
+		lum += cols * 2;
+		cr += cols * 2;
+		cb += cols * 2;
+		out += pitch;
+	}
+}
+
+#define YUV_SIMD_CONVERTER(name, layout, bpp)				\
+static YUV_TARGET void YUV_SIMD(name)(int *colortab, Uint32 *rgb_2_pix,	\
+				unsigned char *lum, unsigned char *cr,	\
+				unsigned char *cb, unsigned char *out,	\
+				int rows, int cols, int mod)		\
+{									\
+	YUV_SIMD(layout)(colortab, rgb_2_pix, lum, cr, cb, out,		\
+	                 rows, cols, mod, bpp);				\
+}
+
+YUV_SIMD_CONVERTER(Color16YV12, YV12, 2)
+YUV_SIMD_CONVERTER(Color24YV12, YV12, 3)
+YUV_SIMD_CONVERTER(Color32YV12, YV12, 4)
+YUV_SIMD_CONVERTER(Color16YUY2, YUY2, 2)
+YUV_SIMD_CONVERTER(Color24YUY2, YUY2, 3)
+YUV_SIMD_CONVERTER(Color32YUY2, YUY2, 4)
+
+#undef YUV_SIMD_CONVERTER
+
+/* A row with a chroma sample for every pixel, made by the scaler */
+static YUV_TARGET void YUV_SIMD(ColorFullRow)(int *colortab,
+				Uint32 *rgb_2_pix, Uint8 *lum, Uint8 *cr,
+				Uint8 *cb, Uint8 *out, int cols, int bpp)
+{
+	YUV_SIMD(Row)(colortab, rgb_2_pix, lum, cr, cb, out,
+	              cols, bpp, YUV_FULL);
+}
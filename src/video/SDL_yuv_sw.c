@@ -85,6 +85,7 @@
 
 #include "SDL_video.h"
 #include "SDL_cpuinfo.h"
+#include "SDL_blit.h"
 #include "SDL_stretch_c.h"
 #include "SDL_yuvfuncs.h"
 #include "SDL_yuv_sw_c.h"
@@ -101,6 +102,7 @@ static struct private_yuvhwfuncs sw_yuvfuncs = {
 struct private_yuvhwdata {
 	SDL_Surface *stretch;
 	SDL_Surface *display;
+	SDL_StretchFilter filter;
 	Uint8 *pixels;
 	int *colortab;
 	Uint32 *rgb_2_pix;
@@ -112,6 +114,13 @@ struct private_yuvhwdata {
 	                  unsigned char *lum, unsigned char *cr,
                           unsigned char *cb, unsigned char *out,
                           int rows, int cols, int mod );
+	void (*DisplayRow)(int *colortab, Uint32 *rgb_2_pix,
+	                   Uint8 *lum, Uint8 *cr, Uint8 *cb, Uint8 *out,
+	                   int cols, int bpp );
+
+	/* Sampling for each display column when scaling, see ScaleYUV() */
+	int *scale_cols;
+	int scale_srcx, scale_srcw, scale_dstw;
 
 	/* These are just so we don't have to allocate them separately */
 	Uint16 pitches[3];
@@ -132,6 +141,162 @@ extern void ColorRGBDitherYV12MMX1X( int *colortab, Uint32 *rgb_2_pix,
                                      int rows, int cols, int mod );
 #endif 
 
+/*
+ * The fixed point factors and channel shifts used by the vector
+ * converters are kept after the chroma tables in colortab.
+ */
+#define YUV_SIMD_PARAMS	(4*256)
+#define YUV_SIMD_NPARAMS	10
+
+/* The row layouts the vector converters handle */
+#define YUV_PAIRED	0	/* planar, a chroma sample per pixel pair */
+#define YUV_PACKED	1	/* YUY2 and friends */
+#define YUV_FULL	2	/* planar, a chroma sample per pixel */
+
+#if SSE2_BLIT
+#define YUV_SIMD(name)		name##SSE2
+#define YUV_TARGET
+#define YUV_STEP		8
+#define V			__m128i
+#define V_ZERO()		_mm_setzero_si128()
+#define V_SET16(x)		_mm_set1_epi16((short)(x))
+#define V_LOAD(p)		_mm_loadu_si128((const __m128i *)(p))
+#define V_STORE(p, v)		_mm_storeu_si128((__m128i *)(p), v)
+#define V_LOAD_LUMA(p)		_mm_unpacklo_epi8(			\
+				    _mm_loadl_epi64((const __m128i *)(p)), \
+				    _mm_setzero_si128())
+#define V_LOAD_CHROMA(p)	LoadChromaSSE2(p)
+#define V_WIDEN_LO(v)		_mm_unpacklo_epi16(v, _mm_setzero_si128())
+#define V_WIDEN_HI(v)		_mm_unpackhi_epi16(v, _mm_setzero_si128())
+#define V_ADD16			_mm_add_epi16
+#define V_SUB16			_mm_sub_epi16
+#define V_MIN16			_mm_min_epi16
+#define V_MAX16			_mm_max_epi16
+#define V_MULHI_U16		_mm_mulhi_epu16
+#define V_AND			_mm_and_si128
+#define V_OR			_mm_or_si128
+#define V_XOR			_mm_xor_si128
+#define V_SRAI16		_mm_srai_epi16
+#define V_SRLI16		_mm_srli_epi16
+#define V_SRLI32		_mm_srli_epi32
+#define V_SLLI32		_mm_slli_epi32
+#define V_SRL16			_mm_srl_epi16
+#define V_SLL16			_mm_sll_epi16
+#define V_SLL32			_mm_sll_epi32
+
+/* Four chroma values, each repeated for a pair of pixels */
+static __inline__ __m128i LoadChromaSSE2(const Uint8 *p)
+{
+	Uint32 c = p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32)p[3] << 24);
+	__m128i v = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)c),
+	                              _mm_setzero_si128());
+	return _mm_unpacklo_epi16(v, v);
+}
+
+#include "SDL_yuv_simd.h"
+
+#undef YUV_SIMD
+#undef YUV_TARGET
+#undef YUV_STEP
+#undef V
+#undef V_ZERO
+#undef V_SET16
+#undef V_LOAD
+#undef V_STORE
+#undef V_LOAD_LUMA
+#undef V_LOAD_CHROMA
+#undef V_WIDEN_LO
+#undef V_WIDEN_HI
+#undef V_ADD16
+#undef V_SUB16
+#undef V_MIN16
+#undef V_MAX16
+#undef V_MULHI_U16
+#undef V_AND
+#undef V_OR
+#undef V_XOR
+#undef V_SRAI16
+#undef V_SRLI16
+#undef V_SRLI32
+#undef V_SLLI32
+#undef V_SRL16
+#undef V_SLL16
+#undef V_SLL32
+#endif /* SSE2_BLIT */
+
+#if AVX2_BLIT
+#define YUV_SIMD(name)		name##AVX2
+#define YUV_TARGET		__attribute__((target("avx2")))
+#define YUV_STEP		16
+#define V			__m256i
+#define V_ZERO()		_mm256_setzero_si256()
+#define V_SET16(x)		_mm256_set1_epi16((short)(x))
+#define V_LOAD(p)		_mm256_loadu_si256((const __m256i *)(p))
+#define V_STORE(p, v)		_mm256_storeu_si256((__m256i *)(p), v)
+#define V_LOAD_LUMA(p)		_mm256_cvtepu8_epi16(			\
+				    _mm_loadu_si128((const __m128i *)(p)))
+#define V_LOAD_CHROMA(p)	LoadChromaAVX2(p)
+#define V_WIDEN_LO(v)		_mm256_cvtepu16_epi32(			\
+				    _mm256_castsi256_si128(v))
+#define V_WIDEN_HI(v)		_mm256_cvtepu16_epi32(			\
+				    _mm256_extracti128_si256(v, 1))
+#define V_ADD16			_mm256_add_epi16
+#define V_SUB16			_mm256_sub_epi16
+#define V_MIN16			_mm256_min_epi16
+#define V_MAX16			_mm256_max_epi16
+#define V_MULHI_U16		_mm256_mulhi_epu16
+#define V_AND			_mm256_and_si256
+#define V_OR			_mm256_or_si256
+#define V_XOR			_mm256_xor_si256
+#define V_SRAI16		_mm256_srai_epi16
+#define V_SRLI16		_mm256_srli_epi16
+#define V_SRLI32		_mm256_srli_epi32
+#define V_SLLI32		_mm256_slli_epi32
+#define V_SRL16			_mm256_srl_epi16
+#define V_SLL16			_mm256_sll_epi16
+#define V_SLL32			_mm256_sll_epi32
+
+/* Eight chroma values, each repeated for a pair of pixels.  The unpack
+   works within 128-bit lanes, so give each lane its four values first. */
+static __inline__ __attribute__((target("avx2")))
+__m256i LoadChromaAVX2(const Uint8 *p)
+{
+	__m256i v = _mm256_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)p));
+	v = _mm256_permute4x64_epi64(v, 0x50);
+	return _mm256_unpacklo_epi16(v, v);
+}
+
+#include "SDL_yuv_simd.h"
+
+#undef YUV_SIMD
+#undef YUV_TARGET
+#undef YUV_STEP
+#undef V
+#undef V_ZERO
+#undef V_SET16
+#undef V_LOAD
+#undef V_STORE
+#undef V_LOAD_LUMA
+#undef V_LOAD_CHROMA
+#undef V_WIDEN_LO
+#undef V_WIDEN_HI
+#undef V_ADD16
+#undef V_SUB16
+#undef V_MIN16
+#undef V_MAX16
+#undef V_MULHI_U16
+#undef V_AND
+#undef V_OR
+#undef V_XOR
+#undef V_SRAI16
+#undef V_SRLI16
+#undef V_SRLI32
+#undef V_SLLI32
+#undef V_SRL16
+#undef V_SLL16
+#undef V_SLL32
+#endif /* AVX2_BLIT */
+
 static void Color16DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
                                     unsigned char *lum, unsigned char *cr,
                                     unsigned char *cb, unsigned char *out,
@@ -791,7 +956,7 @@ static void Color16DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
             row++;
 
         }
-        row += next_row;
+        row += next_row + mod/2;
     }
 }
 
@@ -847,7 +1012,7 @@ static void Color24DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
             row += 2*3;
 
         }
-        row += next_row;
+        row += next_row + mod*3;
     }
 }
 
@@ -863,7 +1028,6 @@ static void Color32DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
     int crb_g;
     int cb_b;
     int cols_2 = cols / 2;
-    mod+=mod;
     y = rows;
     while( y-- )
     {
@@ -895,7 +1059,7 @@ static void Color32DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
 
         }
 
-        row += next_row;
+        row += next_row + mod;
     }
 }
 
@@ -922,6 +1086,361 @@ static int free_bits_at_bottom( Uint32 a )
     return 1 + free_bits_at_bottom ( a >> 1);
 }
 
+/*
+ * Scaling and clipping are done while converting, sampling the YUV
+ * planes at the centre of each display pixel.  Chroma is always
+ * interpolated bilinearly, luma only with SDL_STRETCH_BILINEAR.  Each
+ * display row is sampled into rows of luma and chroma with a sample
+ * for every pixel, which are then converted straight to the display.
+ *
+ * For each display column, scale_cols has the offset of the first of
+ * the two luma samples around it within a source row, and the 8-bit
+ * weight of the second; then the same for chroma.
+ */
+#define SCALE_LOFF	0
+#define SCALE_LFRAC	1
+#define SCALE_COFF	2
+#define SCALE_CFRAC	3
+#define SCALE_NCOLS	4
+
+/* Find the sample before a 16.16 position and the next one's weight */
+static void ScaleSample( Sint32 pos, int len, int *first, int *frac )
+{
+    if ( pos < 0 ) {
+        pos = 0;
+    }
+    *first = (int)(pos >> 16);
+    *frac = (pos & 0xFFFF) >> 8;
+    if ( *first >= len - 1 ) {
+        *first = len - 1;
+        *frac = 0;
+    }
+}
+
+/* The same, but keeping both samples within the row */
+static void ScaleColumn( Sint32 pos, int len, int step, int *off, int *frac )
+{
+    int first;
+
+    ScaleSample(pos, len, &first, frac);
+    if ( first == len - 1 && first > 0 ) {
+        first = len - 2;
+        *frac = 256;
+    }
+    *off = first * step;
+}
+
+static int ScaleColumns( struct private_yuvhwdata *swdata, SDL_Overlay *overlay,
+                         SDL_Rect *src, SDL_Rect *dst )
+{
+    int packed = (overlay->planes == 1);
+    int lstep = packed ? 2 : 1;
+    int cstep = packed ? 4 : 1;
+    int cw = overlay->w / 2;
+    int w = dst->w;
+    int *cols;
+    Uint32 step;
+    Sint32 center;
+    int i, first, frac;
+
+    if ( swdata->scale_cols && swdata->scale_srcx == src->x &&
+         swdata->scale_srcw == src->w && swdata->scale_dstw == w ) {
+        return 0;
+    }
+    SDL_free(swdata->scale_cols);
+    swdata->scale_cols = (int *)SDL_malloc(w*SCALE_NCOLS*sizeof(int));
+    if ( ! swdata->scale_cols ) {
+        SDL_OutOfMemory();
+        return -1;
+    }
+    swdata->scale_srcx = src->x;
+    swdata->scale_srcw = src->w;
+    swdata->scale_dstw = w;
+
+    if ( cw < 1 ) {
+        cw = 1;
+    }
+    cols = swdata->scale_cols;
+    step = ((Uint32)src->w << 16) / w;
+    for ( i = 0; i < w; ++i ) {
+        center = ((Sint32)src->x << 16) + i * step + step / 2;
+        if ( swdata->filter == SDL_STRETCH_BILINEAR ) {
+            ScaleColumn(center - 0x8000, overlay->w, lstep,
+                        &cols[SCALE_LOFF*w+i], &cols[SCALE_LFRAC*w+i]);
+        } else {
+            ScaleSample(center, overlay->w, &first, &frac);
+            cols[SCALE_LOFF*w+i] = first * lstep;
+            cols[SCALE_LFRAC*w+i] = 0;
+        }
+        /* Chroma samples sit between the two luma samples they cover */
+        ScaleColumn(center / 2 - 0x8000, cw, cstep,
+                    &cols[SCALE_COFF*w+i], &cols[SCALE_CFRAC*w+i]);
+    }
+    return 0;
+}
+
+/* Resample a source row of luma or chroma to the display width */
+static void ScaleRow( const int *off, const int *frac, int next,
+                      const Uint8 *row, Uint8 *out, int width )
+{
+    int x;
+
+    if ( !next ) {
+        /* Nearest luma, or a single column of chroma */
+        for ( x = 0; x < width; ++x ) {
+            out[x] = row[off[x]];
+        }
+        return;
+    }
+    for ( x = 0; x < width; ++x ) {
+        const Uint8 *p = row + off[x];
+        out[x] = (Uint8)((p[0] * (256 - frac[x]) +
+                          p[next] * frac[x] + 128) >> 8);
+    }
+}
+
+/* Blend two resampled rows with an 8-bit weight for the second */
+static void BlendRows( const Uint8 *r0, const Uint8 *r1, int fy,
+                       Uint8 *out, int width )
+{
+    int x = 0;
+
+#if SSE2_BLIT
+    __m128i w0 = _mm_set1_epi16((short)(256 - fy));
+    __m128i w1 = _mm_set1_epi16((short)fy);
+    __m128i round = _mm_set1_epi16(128);
+    __m128i zero = _mm_setzero_si128();
+
+    for ( ; x + 16 <= width; x += 16 ) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(r0 + x));
+        __m128i b = _mm_loadu_si128((const __m128i *)(r1 + x));
+        __m128i lo = _mm_add_epi16(
+                _mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), w0),
+                _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), w1));
+        __m128i hi = _mm_add_epi16(
+                _mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), w0),
+                _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), w1));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+        _mm_storeu_si128((__m128i *)(out + x), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for ( ; x < width; ++x ) {
+        out[x] = (Uint8)((r0[x] * (256 - fy) + r1[x] * fy + 128) >> 8);
+    }
+}
+
+/*
+ * Sample a display row of luma or chroma between two source rows.
+ * The last two resampled source rows are kept, since neighbouring
+ * display rows usually need the same ones.
+ */
+static Uint8 *ScalePlane( const int *off, const int *frac, int next,
+                          const Uint8 *plane, int pitch,
+                          int y0, int y1, int fy,
+                          int tags[2], Uint8 *rows[2], Uint8 *out, int width )
+{
+    int slot;
+
+    if ( tags[0] == y0 ) {
+        slot = 0;
+    } else if ( tags[1] == y0 ) {
+        slot = 1;
+    } else {
+        slot = (tags[0] == y1) ? 1 : 0;
+        ScaleRow(off, frac, next, plane + y0 * pitch, rows[slot], width);
+        tags[slot] = y0;
+    }
+    if ( !fy ) {
+        return rows[slot];
+    }
+    if ( tags[!slot] != y1 ) {
+        ScaleRow(off, frac, next, plane + y1 * pitch, rows[!slot], width);
+        tags[!slot] = y1;
+    }
+    BlendRows(rows[slot], rows[!slot], fy, out, width);
+    return out;
+}
+
+/* Convert display rows [first, first+count) of a scaled overlay */
+static void ScaleYUV( struct private_yuvhwdata *swdata, SDL_Overlay *overlay,
+                      Uint8 *lum, Uint8 *cr, Uint8 *cb,
+                      SDL_Rect *src, SDL_Rect *dst, Uint8 *out, int pitch,
+                      int first, int count )
+{
+    int w = dst->w;
+    const int *loff = swdata->scale_cols + SCALE_LOFF*w;
+    const int *lfrac = swdata->scale_cols + SCALE_LFRAC*w;
+    const int *coff = swdata->scale_cols + SCALE_COFF*w;
+    const int *cfrac = swdata->scale_cols + SCALE_CFRAC*w;
+    int bpp = swdata->display->format->BytesPerPixel;
+    int packed = (overlay->planes == 1);
+    int lpitch = overlay->pitches[0];
+    int cpitch = packed ? overlay->pitches[0] : overlay->pitches[1];
+    int ch = packed ? overlay->h : overlay->h / 2;
+    int lnext = 0, cnext = 0;
+    Uint8 *scratch;
+    Uint8 *rows[3][2];
+    int tags[3][2];
+    Uint8 *yrow, *crrow, *cbrow;
+    Uint32 step;
+    Sint32 center;
+    int i, y;
+    int ly0, lfy, cy0, cfy;
+
+    /* The offset of the second sample, if there is one to blend */
+    if ( swdata->filter == SDL_STRETCH_BILINEAR && overlay->w > 1 ) {
+        lnext = packed ? 2 : 1;
+    }
+    if ( overlay->w / 2 > 1 ) {
+        cnext = packed ? 4 : 1;
+    }
+    /* Two resampled source rows and a display row for each of luma,
+       Cr and Cb, separate for each band of rows being converted */
+    scratch = SDL_stack_alloc(Uint8, w*9);
+    if ( ! scratch ) {
+        return;
+    }
+    for ( i = 0; i < 3; ++i ) {
+        rows[i][0] = scratch + (i*3+0) * w;
+        rows[i][1] = scratch + (i*3+1) * w;
+        tags[i][0] = tags[i][1] = -1;
+    }
+    if ( ch < 1 ) {
+        ch = 1;
+    }
+    step = ((Uint32)src->h << 16) / dst->h;
+    out += first * pitch;
+    for ( y = first; y < first + count; ++y ) {
+        center = ((Sint32)src->y << 16) + y * step + step / 2;
+        if ( swdata->filter == SDL_STRETCH_BILINEAR ) {
+            ScaleSample(center - 0x8000, overlay->h, &ly0, &lfy);
+        } else {
+            ScaleSample(center, overlay->h, &ly0, &lfy);
+            lfy = 0;
+        }
+        if ( packed ) {
+            ScaleSample(center - 0x8000, ch, &cy0, &cfy);
+        } else {
+            ScaleSample(center / 2 - 0x8000, ch, &cy0, &cfy);
+        }
+        yrow = ScalePlane(loff, lfrac, lnext, lum, lpitch,
+                          ly0, ly0 + 1, lfy,
+                          tags[0], rows[0], rows[0][1] + w, w);
+        crrow = ScalePlane(coff, cfrac, cnext, cr, cpitch,
+                           cy0, cy0 + 1, cfy,
+                           tags[1], rows[1], rows[1][1] + w, w);
+        cbrow = ScalePlane(coff, cfrac, cnext, cb, cpitch,
+                           cy0, cy0 + 1, cfy,
+                           tags[2], rows[2], rows[2][1] + w, w);
+        swdata->DisplayRow(swdata->colortab, swdata->rgb_2_pix,
+                           yrow, crrow, cbrow, out, w, bpp);
+        out += pitch;
+    }
+    SDL_stack_free(scratch);
+}
+
+/* The C version of the scaler's row converter */
+static void ColorFullRow( int *colortab, Uint32 *rgb_2_pix,
+                          Uint8 *lum, Uint8 *cr, Uint8 *cb, Uint8 *out,
+                          int cols, int bpp )
+{
+    Uint32 value;
+    int L;
+
+    while ( cols-- ) {
+        L = *lum++;
+        value = (rgb_2_pix[ 0*768+256 + L + colortab[ *cr + 0*256 ] ] |
+                 rgb_2_pix[ 1*768+256 + L + colortab[ *cr + 1*256 ]
+                                          + colortab[ *cb + 2*256 ] ] |
+                 rgb_2_pix[ 2*768+256 + L + colortab[ *cb + 3*256 ] ]);
+        ++cr; ++cb;
+        switch (bpp) {
+            case 2:
+                *(Uint16 *)out = (Uint16)value;
+                break;
+            case 3:
+                out[0] = (value      ) & 0xFF;
+                out[1] = (value >>  8) & 0xFF;
+                out[2] = (value >> 16) & 0xFF;
+                break;
+            default:
+                *(Uint32 *)out = value;
+                break;
+        }
+        out += bpp;
+    }
+}
+
+/*
+ * The chroma to RGB factors: Cr to red, Cr to green, Cb to green and
+ * Cb to blue.  The first set is what this code has always used.
+ */
+static const double yuv_matrices[][4] = {
+	{ 0.419/0.299, 0.299/0.419, 0.114/0.331, 0.587/0.331 },	/* BT.601 */
+	{ 1.5748, 0.4681, 0.1873, 1.8556 }			/* BT.709 */
+};
+
+#if SSE2_BLIT
+/*
+ * Find a 1.15 fixed point factor which gives exactly the entries of a
+ * chroma table, negated if the table is for green.
+ */
+static int FindChromaFactor( const int *tab, double coef, int negate )
+{
+    int k, i, c, m;
+
+    for ( k = (int)(coef * 32768.0) - 8; k <= (int)(coef * 32768.0) + 8; ++k ) {
+        if ( k <= 0 || k > 0xFFFF ) {
+            continue;
+        }
+        for ( i = 0; i < 256; ++i ) {
+            c = i - 128;
+            m = ((c < 0 ? -c : c) * k) >> 15;
+            if ( c < 0 ) m = -m;
+            if ( negate ) m = -m;
+            if ( m != tab[i] ) {
+                break;
+            }
+        }
+        if ( i == 256 ) {
+            return k;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Set up the parameters of the vector converters, returning 0 if they
+ * can't reproduce the C converters for this display format.
+ */
+static int SetupSIMD( int *colortab, const double *coefs, SDL_PixelFormat *format )
+{
+    int *params = colortab + YUV_SIMD_PARAMS;
+    Uint32 masks[3];
+    int i, bits;
+
+    params[0] = FindChromaFactor(&colortab[0*256], coefs[0], 0);
+    params[1] = FindChromaFactor(&colortab[1*256], coefs[1], 1);
+    params[2] = FindChromaFactor(&colortab[2*256], coefs[2], 1);
+    params[3] = FindChromaFactor(&colortab[3*256], coefs[3], 0);
+    if ( !params[0] || !params[1] || !params[2] || !params[3] ) {
+        return 0;
+    }
+    masks[0] = format->Rmask;
+    masks[1] = format->Gmask;
+    masks[2] = format->Bmask;
+    for ( i = 0; i < 3; ++i ) {
+        bits = number_of_bits_set(masks[i]);
+        if ( bits < 1 || bits > 8 ) {
+            return 0;
+        }
+        params[4+i*2] = 8 - bits;
+        params[5+i*2] = free_bits_at_bottom(masks[i]);
+    }
+    return 1;
+}
+#endif /* SSE2_BLIT */
 
 SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_Surface *display)
 {
@@ -937,6 +1456,10 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 	int i;
 	int CR, CB;
 	Uint32 Rmask, Gmask, Bmask;
+	const char *filter;
+	const char *matrix;
+	const double *coefs;
+	int simd;
 
 	/* Only RGB packed pixel conversion supported */
 	if ( (display->format->BytesPerPixel != 2) &&
@@ -984,9 +1507,19 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 		return(NULL);
 	}
 	swdata->stretch = NULL;
+	swdata->scale_cols = NULL;
 	swdata->display = display;
+	swdata->filter = SDL_STRETCH_NEAREST;
+	filter = SDL_getenv("SDL_VIDEO_YUV_FILTER");
+	if ( filter ) {
+		if ( SDL_strcasecmp(filter, "bilinear") == 0 ) {
+			swdata->filter = SDL_STRETCH_BILINEAR;
+		} else if ( SDL_strcasecmp(filter, "area") == 0 ) {
+			swdata->filter = SDL_STRETCH_AREA;
+		}
+	}
 	swdata->pixels = (Uint8 *) SDL_malloc(width*height*2);
-	swdata->colortab = (int *)SDL_malloc(4*256*sizeof(int));
+	swdata->colortab = (int *)SDL_malloc((4*256+YUV_SIMD_NPARAMS)*sizeof(int));
 	Cr_r_tab = &swdata->colortab[0*256];
 	Cr_g_tab = &swdata->colortab[1*256];
 	Cb_g_tab = &swdata->colortab[2*256];
@@ -1002,15 +1535,20 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 	}
 
 	/* Generate the tables for the display surface */
+	coefs = yuv_matrices[0];
+	matrix = SDL_getenv("SDL_VIDEO_YUV_MATRIX");
+	if ( matrix && SDL_strcasecmp(matrix, "bt709") == 0 ) {
+		coefs = yuv_matrices[1];
+	}
 	for (i=0; i<256; i++) {
 		/* Gamma correction (luminescence table) and chroma correction
 		   would be done here.  See the Berkeley mpeg_play sources.
 		*/
 		CB = CR = (i-128);
-		Cr_r_tab[i] = (int) ( (0.419/0.299) * CR);
-		Cr_g_tab[i] = (int) (-(0.299/0.419) * CR);
-		Cb_g_tab[i] = (int) (-(0.114/0.331) * CB); 
-		Cb_b_tab[i] = (int) ( (0.587/0.331) * CB);
+		Cr_r_tab[i] = (int) ( coefs[0] * CR);
+		Cr_g_tab[i] = (int) (-coefs[1] * CR);
+		Cb_g_tab[i] = (int) (-coefs[2] * CB); 
+		Cb_b_tab[i] = (int) ( coefs[3] * CB);
 	}
 
 	/* 
@@ -1056,6 +1594,20 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 		b_2_pix_alloc[i+512] = b_2_pix_alloc[511];
 	}
 
+	/* See if the vector converters can be used */
+	simd = 0;
+#if SSE2_BLIT
+	if ( SDL_HasSSE2() &&
+	     SetupSIMD(swdata->colortab, coefs, display->format) ) {
+		simd = 1;
+#if AVX2_BLIT
+		if ( SDL_HasAVX2() ) {
+			simd = 2;
+		}
+#endif
+	}
+#endif
+
 	/* You have chosen wisely... */
 	switch (format) {
 	    case SDL_YV12_OVERLAY:
@@ -1121,6 +1673,47 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 		/* We should never get here (caught above) */
 		break;
 	}
+	swdata->DisplayRow = ColorFullRow;
+#if AVX2_BLIT
+	if ( simd == 2 ) {
+		int packed = (format != SDL_YV12_OVERLAY &&
+		              format != SDL_IYUV_OVERLAY);
+
+		swdata->DisplayRow = ColorFullRowAVX2;
+		/* The frame converters work on whole pixel pairs */
+		switch ((width & 1) ? 0 : display->format->BytesPerPixel) {
+		    case 2:
+			swdata->Display1X = packed ? Color16YUY2AVX2 : Color16YV12AVX2;
+			break;
+		    case 3:
+			swdata->Display1X = packed ? Color24YUY2AVX2 : Color24YV12AVX2;
+			break;
+		    case 4:
+			swdata->Display1X = packed ? Color32YUY2AVX2 : Color32YV12AVX2;
+			break;
+		}
+	}
+#endif
+#if SSE2_BLIT
+	if ( simd == 1 ) {
+		int packed = (format != SDL_YV12_OVERLAY &&
+		              format != SDL_IYUV_OVERLAY);
+
+		swdata->DisplayRow = ColorFullRowSSE2;
+		/* The frame converters work on whole pixel pairs */
+		switch ((width & 1) ? 0 : display->format->BytesPerPixel) {
+		    case 2:
+			swdata->Display1X = packed ? Color16YUY2SSE2 : Color16YV12SSE2;
+			break;
+		    case 3:
+			swdata->Display1X = packed ? Color24YUY2SSE2 : Color24YV12SSE2;
+			break;
+		    case 4:
+			swdata->Display1X = packed ? Color32YUY2SSE2 : Color32YV12SSE2;
+			break;
+		}
+	}
+#endif
 
 	/* Find the pitch and offset values for the overlay */
 	overlay->pitches = swdata->pitches;
@@ -1164,10 +1757,71 @@ void SDL_UnlockYUV_SW(_THIS, SDL_Overlay *overlay)
 	return;
 }
 
+/* The rows of an overlay being displayed, see DisplayBand() */
+#define YUV_BAND_1X	0
+#define YUV_BAND_2X	1
+#define YUV_BAND_SCALE	2
+
+typedef struct {
+	struct private_yuvhwdata *swdata;
+	SDL_Overlay *overlay;
+	Uint8 *lum, *Cr, *Cb;
+	Uint8 *dstp;
+	int mod;	/* the display pitch in bytes when scaling */
+	SDL_Rect *src, *dst;
+	int mode;
+} YUV_Band;
+
+/*
+ * Convert overlay rows [first, first+count), or display rows when
+ * scaling.  Large overlays are split into bands which run in parallel.
+ */
+static void DisplayBand(void *data, int first, int count)
+{
+	YUV_Band *band = (YUV_Band *)data;
+	struct private_yuvhwdata *swdata = band->swdata;
+	SDL_Overlay *overlay = band->overlay;
+	int bpp = swdata->display->format->BytesPerPixel;
+	int cols = overlay->w;
+	int lum_offset, chroma_offset;
+	Uint8 *out;
+
+	if ( band->mode == YUV_BAND_SCALE ) {
+		ScaleYUV(swdata, overlay, band->lum, band->Cr, band->Cb,
+		         band->src, band->dst, band->dstp, band->mod,
+		         first, count);
+		return;
+	}
+	if ( overlay->planes == 1 ) {
+		lum_offset = chroma_offset = first * cols * 2;
+	} else {
+		lum_offset = first * cols;
+		chroma_offset = (first / 2) * (cols / 2);
+	}
+	if ( band->mode == YUV_BAND_2X ) {
+		out = band->dstp + 2 * first * (cols * 2 + band->mod) * bpp;
+		swdata->Display2X(swdata->colortab, swdata->rgb_2_pix,
+		                  band->lum + lum_offset,
+		                  band->Cr + chroma_offset,
+		                  band->Cb + chroma_offset,
+		                  out, count, cols, band->mod);
+	} else {
+		out = band->dstp + first * (cols + band->mod) * bpp;
+		swdata->Display1X(swdata->colortab, swdata->rgb_2_pix,
+		                  band->lum + lum_offset,
+		                  band->Cr + chroma_offset,
+		                  band->Cb + chroma_offset,
+		                  out, count, cols, band->mod);
+	}
+}
+
 int SDL_DisplayYUV_SW(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
 {
 	struct private_yuvhwdata *swdata;
+	YUV_Band band;
+	int rows, pixels;
 	int stretch;
+	int scale;
 	int scale_2x;
 	SDL_Surface *display;
 	Uint8 *lum, *Cr, *Cb;
@@ -1176,20 +1830,32 @@ int SDL_DisplayYUV_SW(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
 
 	swdata = overlay->hwdata;
 	stretch = 0;
+	scale = 0;
 	scale_2x = 0;
 	if ( src->x || src->y || src->w < overlay->w || src->h < overlay->h ) {
 		/* The source rectangle has been clipped.
-		   Using a scratch surface is easier than adding clipped
-		   source support to all the blitters, plus that would
-		   slow them down in the general unclipped case.
+		   The scaling converter samples any part of the overlay,
+		   so the whole frame converters needn't handle this and
+		   stay fast in the general unclipped case.
 		*/
-		stretch = 1;
+		scale = 1;
 	} else if ( (src->w != dst->w) || (src->h != dst->h) ) {
 		if ( (dst->w == 2*src->w) &&
-		     (dst->h == 2*src->h) ) {
+		     (dst->h == 2*src->h) &&
+		     (swdata->filter == SDL_STRETCH_NEAREST) ) {
 			scale_2x = 1;
 		} else {
-			stretch = 1;
+			scale = 1;
+		}
+	}
+	if ( scale && (swdata->filter == SDL_STRETCH_AREA) ) {
+		/* Averaging is done on RGB pixels from a scratch surface */
+		scale = 0;
+		stretch = 1;
+	}
+	if ( scale ) {
+		if ( ScaleColumns(swdata, overlay, src, dst) < 0 ) {
+			return(-1);
 		}
 	}
 	if ( stretch ) {
@@ -1254,21 +1920,40 @@ int SDL_DisplayYUV_SW(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
 	}
 	mod = (display->pitch / display->format->BytesPerPixel);
 
-	if ( scale_2x ) {
-		mod -= (overlay->w * 2);
-		swdata->Display2X(swdata->colortab, swdata->rgb_2_pix,
-		                  lum, Cr, Cb, dstp, overlay->h, overlay->w, mod);
+	band.swdata = swdata;
+	band.overlay = overlay;
+	band.lum = lum;
+	band.Cr = Cr;
+	band.Cb = Cb;
+	band.dstp = dstp;
+	band.src = src;
+	band.dst = dst;
+	if ( scale ) {
+		band.mode = YUV_BAND_SCALE;
+		band.mod = display->pitch;
+		rows = dst->h;
+		pixels = dst->w * dst->h;
 	} else {
-		mod -= overlay->w;
-		swdata->Display1X(swdata->colortab, swdata->rgb_2_pix,
-		                  lum, Cr, Cb, dstp, overlay->h, overlay->w, mod);
+		band.mode = scale_2x ? YUV_BAND_2X : YUV_BAND_1X;
+		band.mod = mod - (scale_2x ? overlay->w * 2 : overlay->w);
+		rows = overlay->h;
+		pixels = overlay->w * overlay->h;
+	}
+	/* Planar chroma covers pairs of rows, so bands start on even rows.
+	   The whole frame converters don't keep their place in odd width
+	   overlays from one row to the next, so those aren't split. */
+	if ( (!scale && (overlay->w & 1)) ||
+	     ! SDL_RunBands(DisplayBand, &band, rows,
+	                    (scale || overlay->planes == 1) ? 1 : 2, pixels) ) {
+		DisplayBand(&band, 0, rows);
 	}
 	if ( SDL_MUSTLOCK(display) ) {
 		SDL_UnlockSurface(display);
 	}
 	if ( stretch ) {
 		display = swdata->display;
-		SDL_SoftStretch(swdata->stretch, src, display, dst);
+		SDL_SoftStretchFiltered(swdata->stretch, src, display, dst,
+		                        swdata->filter);
 	}
 	SDL_UpdateRects(display, 1, dst);
 
@@ -1284,6 +1969,9 @@ void SDL_FreeYUV_SW(_THIS, SDL_Overlay *overlay)
 		if ( swdata->stretch ) {
 			SDL_FreeSurface(swdata->stretch);
 		}
+		if ( swdata->scale_cols ) {
+			SDL_free(swdata->scale_cols);
+		}
 		if ( swdata->pixels ) {
 			SDL_free(swdata->pixels);
 		}
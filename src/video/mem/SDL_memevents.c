@@ -21,8 +21,15 @@
 */
 #include "SDL_config.h"
 
-/* Being a null driver, there's no event stream. We just define stubs for
-   most of the API. */
+/* There's no window system to get events from, but another process can
+   inject them through a shared ring (see SDL_memvideo.h). */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 #include "SDL.h"
 #include "../../events/SDL_sysevents.h"
@@ -31,9 +38,106 @@
 #include "SDL_memvideo.h"
 #include "SDL_memevents_c.h"
 
+void Mem_OpenInput(_THIS)
+{
+	const char *filename;
+	struct stat st;
+	Mem_InputRing *ring;
+	int fd;
+
+	this->hidden->input = NULL;
+	filename = SDL_getenv("SDL_MEM_VID_INPUT");
+	if ( !filename ) {
+		return;
+	}
+
+	fd = open(filename, O_CREAT | O_RDWR, S_IRUSR|S_IWUSR);
+	if ( fd < 0 ) {
+		return;
+	}
+	if ( fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(*ring) ) {
+		ftruncate(fd, sizeof(*ring));
+	}
+	ring = (Mem_InputRing *)mmap(NULL, sizeof(*ring),
+			PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if ( ring == MAP_FAILED ) {
+		return;
+	}
+
+	if ( ring->magic != MEM_INPUT_MAGIC ) {
+		/* We got here first */
+		SDL_memset(ring, 0, sizeof(*ring));
+		ring->version = MEM_INPUT_VERSION;
+		ring->size = MEM_INPUT_SIZE;
+		__sync_synchronize();
+		ring->magic = MEM_INPUT_MAGIC;
+	}
+	this->hidden->input = ring;
+}
+
+void Mem_CloseInput(_THIS)
+{
+	if ( this->hidden->input ) {
+		munmap(this->hidden->input, sizeof(*this->hidden->input));
+		this->hidden->input = NULL;
+	}
+}
+
+static void Mem_DispatchInput(const Mem_InputEvent *ev)
+{
+	SDL_keysym keysym;
+
+	switch (ev->type) {
+	    case MEM_INPUT_KEY:
+		SDL_memset(&keysym, 0, sizeof(keysym));
+		keysym.sym = (SDLKey)ev->sym;
+		keysym.mod = (SDLMod)ev->mod;
+		keysym.unicode = (Uint16)ev->unicode;
+		SDL_PrivateKeyboard(ev->state ? SDL_PRESSED : SDL_RELEASED,
+		                    &keysym);
+		break;
+	    case MEM_INPUT_MOTION:
+		SDL_PrivateMouseMotion(0, 0, (Sint16)ev->x, (Sint16)ev->y);
+		break;
+	    case MEM_INPUT_BUTTON:
+		SDL_PrivateMouseButton(ev->state ? SDL_PRESSED : SDL_RELEASED,
+		                       (Uint8)ev->button, 0, 0);
+		break;
+	    case MEM_INPUT_QUIT:
+		SDL_PrivateQuit();
+		break;
+	    default:
+		break;
+	}
+}
+
 void Mem_PumpEvents(_THIS)
 {
-	/* do nothing. */
+	Mem_InputRing *ring = this->hidden->input;
+	Uint32 head, tail;
+
+	if ( !ring || ring->magic != MEM_INPUT_MAGIC ) {
+		return;
+	}
+
+	head = ring->head;
+	tail = ring->tail;
+	if ( tail - head > MEM_INPUT_SIZE ) {
+		/* The writer is confused; drop everything */
+		ring->head = tail;
+		return;
+	}
+	/* Read the events only after seeing the tail that covers them */
+	__sync_synchronize();
+	while ( head != tail ) {
+		Mem_InputEvent ev = ring->events[head % MEM_INPUT_SIZE];
+		++head;
+		Mem_DispatchInput(&ev);
+	}
+	/* Hand the slots back only after we've copied them */
+	__sync_synchronize();
+	ring->head = head;
 }
 
 void Mem_InitOSKeymap(_THIS)
@@ -27,6 +27,8 @@
    of the native video subsystem (SDL_sysvideo.c)
 */
 extern void Mem_InitOSKeymap(_THIS);
+extern void Mem_OpenInput(_THIS);
+extern void Mem_CloseInput(_THIS);
 extern void Mem_PumpEvents(_THIS);
 
 /* end of SDL_memevents_c.h ... */
@@ -36,6 +36,11 @@ static char rcsid =
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <fcntl.h>
+#include <errno.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
 
 
 #include "SDL.h"
@@ -48,6 +53,7 @@ static char rcsid =
 
 #include "SDL_memvideo.h"
 #include "SDL_memevents_c.h"
+#include "SDL_memyuv_c.h"
 
 
 /* Initialization/Query functions */
@@ -112,7 +118,7 @@ static SDL_VideoDevice *Mem_CreateDevice(int devindex)
   device->VideoInit = Mem_VideoInit;
   device->ListModes = Mem_ListModes;
   device->SetVideoMode = Mem_SetVideoMode;
-  device->CreateYUVOverlay = NULL;
+  device->CreateYUVOverlay = Mem_CreateYUVOverlay;
   device->SetColors = NULL;
   device->UpdateRects = NULL;
   device->VideoQuit = Mem_VideoQuit;
@@ -168,6 +174,8 @@ int Mem_VideoInit(_THIS, SDL_PixelFormat *vformat)
   Mem_buffer = NULL;
   Mem_buffer_size = 0;
 
+  Mem_OpenInput(this);
+
 //  local_this = this;
 
   /* Determine the screen depth (use default 16-bit depth) */
@@ -203,8 +211,10 @@ static void Mem_DirectUpdate(_THIS, int numrects, SDL_Rect *rects);
 SDL_Surface *Mem_SetVideoMode(_THIS, SDL_Surface *current,
         int width, int height, int bpp, Uint32 flags)
 {
-  if ( Mem_buffer ) {
-    munmap( Mem_buffer, Mem_buffer_size );
+  if ( this->hidden->map ) {
+    munmap( this->hidden->map, this->hidden->map_size );
+    this->hidden->map = NULL;
+    this->hidden->header = NULL;
     Mem_buffer = NULL;
     Mem_buffer_size = 0;
   }
@@ -240,23 +250,46 @@ SDL_Surface *Mem_SetVideoMode(_THIS, SDL_Surface *current,
   Mem_buffer_size = pitch * height;
   //printf("Video format - size:%ix%i bpp:%i realbpp:%i realwidth:%i pitch:%i\n", width, height, bpp, realbpp, realwidth, pitch);
 
+  // A ring of frames for SDL_Flip to rotate through?  This needs the header.
+  int num_frames = 1;
+  if ((flags & SDL_DOUBLEBUF) == SDL_DOUBLEBUF)
+  {
+    num_frames = getenvint("SDL_MEM_VID_FRAMES");
+    if (num_frames < 3) num_frames = 1;
+    if (num_frames > MEM_VID_MAXFRAMES) num_frames = MEM_VID_MAXFRAMES;
+  }
+  this->hidden->num_frames = num_frames;
+  this->hidden->back = 0;
+
+  // Put a frame synchronization header in front of the pixels?
+  int header_size = (getenvint("SDL_MEM_VID_HEADER") || num_frames > 1) ? MEM_VID_HEADER_SIZE : 0;
+  this->hidden->map_size = header_size + Mem_buffer_size * num_frames;
+
   char * filename = getenv("SDL_MEM_VID_FILE");
   if (!filename) filename = "sdl_vid_mem";
   int fd = open(filename, O_CREAT | O_RDWR, S_IRUSR|S_IWUSR);
-  if (!fd)
+  if (fd < 0)
   {
     SDL_SetError("Couldn't open file for memory mapped video");
     return NULL;
   }
-  ftruncate(fd, Mem_buffer_size);
-  Mem_buffer = mmap(NULL, Mem_buffer_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  if (ftruncate(fd, this->hidden->map_size) < 0)
+  {
+    close(fd);
+    SDL_SetError("Couldn't resize file for memory mapped video");
+    return NULL;
+  }
+  this->hidden->map = mmap(NULL, this->hidden->map_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
   close(fd);
-  if ( ! Mem_buffer ) {
+  if ( this->hidden->map == MAP_FAILED ) {
+    this->hidden->map = NULL;
     SDL_SetError("Couldn't allocate buffer for requested mode");
     return NULL;
   }
 
-  memset(Mem_buffer, 0, Mem_buffer_size);
+  memset(this->hidden->map, 0, this->hidden->map_size);
+  Mem_buffer = (Uint8 *)this->hidden->map + header_size;
+  this->hidden->header = header_size ? (Mem_FrameHeader *)this->hidden->map : NULL;
 
   static int mode8[] = {0, 0, 0};
   static int mode15[] = {0xfc00, 0x03e0, 0x001f};
@@ -285,11 +318,35 @@ SDL_Surface *Mem_SetVideoMode(_THIS, SDL_Surface *current,
 
   /* Set up the new mode framebuffer */
   current->flags = SDL_FULLSCREEN;
+  if (num_frames > 1) current->flags |= SDL_HWSURFACE | SDL_DOUBLEBUF;
   Mem_w = current->w = width;
   Mem_h = current->h = height;
   current->pitch = pitch;
   current->pixels = Mem_buffer;
 
+  /* Describe the frame for readers of the header */
+  if (this->hidden->header)
+  {
+    Mem_FrameHeader * h = this->hidden->header;
+    h->magic = MEM_VID_MAGIC;
+    h->version = MEM_VID_VERSION;
+    h->header_size = header_size;
+    h->width = width;
+    h->height = height;
+    h->pitch = pitch;
+    h->bpp = bpp;
+    h->bytes_per_pixel = realbpp / 8;
+    h->Rmask = current->format->Rmask;
+    h->Gmask = current->format->Gmask;
+    h->Bmask = current->format->Bmask;
+    h->Amask = current->format->Amask;
+    h->num_frames = num_frames;
+    h->frame_size = Mem_buffer_size;
+    h->latest = (num_frames > 1) ? 1 : 0;
+    h->reading = MEM_VID_NOSLOT;
+  }
+  this->hidden->eventfd = getenv("SDL_MEM_VID_EVENTFD") ? getenvint("SDL_MEM_VID_EVENTFD") : -1;
+
   /* Set the blit function */
   this->UpdateRects = Mem_DirectUpdate;
 
@@ -313,9 +370,100 @@ static int Mem_LockHWSurface(_THIS, SDL_Surface *surface)
   /* TODO ? */
   return 0;
 }
+void Mem_WakeReaders(_THIS, volatile Uint32 *sequence, volatile Uint32 *waiters)
+{
+#ifdef __linux__
+  if (sequence)
+  {
+    /* A reader adds itself to waiters before it checks the sequence, so
+       the new sequence must be visible before waiters is read, or the
+       reader can go to sleep on the old value and miss the wakeup */
+    __sync_synchronize();
+    if (*waiters)
+    {
+      syscall(SYS_futex, sequence, FUTEX_WAKE, 0x7fffffff, NULL, NULL, 0);
+    }
+  }
+#endif
+
+  if (this->hidden->eventfd >= 0)
+  {
+    Uint64 one = 1;
+    ssize_t n;
+
+    do {
+      n = write(this->hidden->eventfd, &one, sizeof(one));
+    } while (n < 0 && errno == EINTR);
+
+    /* EAGAIN means the counter is full, and readers will wake anyway;
+       anything else means the descriptor is no good */
+    if (n != sizeof(one) && !(n < 0 && errno == EAGAIN))
+    {
+      SDL_SetError("Couldn't signal SDL_MEM_VID_EVENTFD, no longer signalling it");
+      this->hidden->eventfd = -1;
+    }
+  }
+}
+
+/* Tell readers of the header that a frame is complete */
+static void Mem_PublishFrame(_THIS, int numrects, SDL_Rect *rects)
+{
+  Mem_FrameHeader * h = this->hidden->header;
+  if (h)
+  {
+    h->sequence++;
+    __sync_synchronize();
+
+    if (this->hidden->num_frames > 1)
+    {
+      h->slot_frame[this->hidden->back] = h->frame + 1;
+      h->latest = this->hidden->back;
+    }
+
+    if (numrects > MEM_VID_MAXRECTS) numrects = 0; // Whole screen
+    h->numrects = numrects;
+    for (int i = 0; i < numrects; i++)
+    {
+      h->rects[i].x = rects[i].x;
+      h->rects[i].y = rects[i].y;
+      h->rects[i].w = rects[i].w;
+      h->rects[i].h = rects[i].h;
+    }
+    h->frame++;
+
+    __sync_synchronize();
+    h->sequence++;
+
+    Mem_WakeReaders(this, &h->sequence, &h->waiters);
+  }
+  else
+  {
+    Mem_WakeReaders(this, NULL, NULL);
+  }
+}
+
 static int Mem_FlipHWSurface(_THIS, SDL_Surface *surface)
 {
-  return 0; // Lie
+  Mem_PublishFrame(this, 0, NULL);
+
+  if (this->hidden->num_frames > 1)
+  {
+    /* Move on to any slot that is neither the frame just published nor
+       the one being read.  Publishing happened before we look at the
+       reader (and the reader does the opposite), so one of us always
+       notices the other.
+     */
+    Mem_FrameHeader * h = this->hidden->header;
+    __sync_synchronize();
+    Uint32 reading = h->reading;
+    int next = this->hidden->back;
+    do {
+      next = (next + 1) % this->hidden->num_frames;
+    } while (next == (int)h->latest || (Uint32)next == reading);
+    this->hidden->back = next;
+    surface->pixels = Mem_buffer = (Uint8 *)this->hidden->map + h->header_size + next * h->frame_size;
+  }
+  return 0;
 }
 
 static void Mem_UnlockHWSurface(_THIS, SDL_Surface *surface)
@@ -325,7 +473,10 @@ static void Mem_UnlockHWSurface(_THIS, SDL_Surface *surface)
 
 static void Mem_DirectUpdate(_THIS, int numrects, SDL_Rect *rects)
 {
-  return;
+  // Double buffered frames are only published by SDL_Flip
+  if (this->hidden->num_frames > 1) return;
+
+  Mem_PublishFrame(this, numrects, rects);
 }
 
 /* Note:  If we are terminated, this could be called in the middle of
@@ -343,10 +494,18 @@ void Mem_VideoQuit(_THIS)
     }
   }
 
-  if ( Mem_buffer ) {
-    munmap( Mem_buffer, Mem_buffer_size );
+  if ( this->hidden->map ) {
+    munmap( this->hidden->map, this->hidden->map_size );
+    this->hidden->map = NULL;
+    this->hidden->header = NULL;
     Mem_buffer = NULL;
   }
+  /* The mapping isn't for SDL_FreeSurface() to free */
+  if ( this->screen ) {
+    this->screen->pixels = NULL;
+  }
+
+  Mem_CloseInput(this);
 
   SDL_DestroyMutex(Mem_mutex);
 }
@@ -41,6 +41,150 @@ static char rcsid =
 
 #define SDL_NUMMODES 6
 
+/* With SDL_MEM_VID_HEADER=1, the video file starts with this header and
+   the pixels follow at header_size.  Other processes can use it to find
+   out when a frame is complete:
+
+   The sequence counter works like a seqlock over the header fields.  It
+   is odd while the header is being updated and is incremented to the
+   next even number once a frame is complete.  A reader waits for an even
+   value, reads the header, and retries if the value has changed
+   meanwhile.  It does not protect the pixels: with a single buffer the
+   application may already be drawing the next frame while they are
+   read, so a reader can see parts of two frames.  Use the frame slots
+   below where that matters.  To sleep until the next frame, a reader
+   atomically increments waiters, FUTEX_WAITs on sequence (not
+   FUTEX_PRIVATE -- the mapping is shared), and decrements waiters
+   again.  If SDL_MEM_VID_EVENTFD names an inherited eventfd, it
+   is also signalled for every frame.
+
+   rects lists what changed in the last frame.  If numrects is zero, the
+   whole screen should be considered changed.
+
+   If the application sets an SDL_DOUBLEBUF mode and SDL_MEM_VID_FRAMES
+   is 3 or more, that many frame slots of frame_size bytes follow the
+   header.  The application draws into a slot of its own and SDL_Flip
+   publishes it as latest, so a reader always gets a whole frame and the
+   application never waits for the reader.  To read a frame:
+
+     do { slot = latest; reading = slot; full barrier; } while (latest != slot);
+     ...read slot (slot_frame[slot] is its frame number)...
+     reading = MEM_VID_NOSLOT;
+
+   Otherwise num_frames is 1 and the pixels are simply drawn in place,
+   where a reader may see them half drawn.
+*/
+#define MEM_VID_MAGIC     0x4d4c4453 /* "SDLM" */
+#define MEM_VID_VERSION   1
+#define MEM_VID_MAXRECTS  64
+#define MEM_VID_HEADER_SIZE 4096
+#define MEM_VID_MAXFRAMES 16
+#define MEM_VID_NOSLOT    0xffffffff
+
+typedef struct Mem_FrameRect {
+	Uint16 x, y, w, h;
+} Mem_FrameRect;
+
+typedef struct Mem_FrameHeader {
+	Uint32 magic;
+	Uint32 version;
+	Uint32 header_size;
+	Uint32 width, height, pitch;
+	Uint32 bpp, bytes_per_pixel;
+	Uint32 Rmask, Gmask, Bmask, Amask;
+
+	volatile Uint32 sequence;
+	volatile Uint32 waiters;
+	Uint32 frame;
+	Uint32 numrects;
+	Mem_FrameRect rects[MEM_VID_MAXRECTS];
+
+	Uint32 num_frames;
+	Uint32 frame_size;
+	volatile Uint32 latest;
+	volatile Uint32 reading;
+	Uint32 slot_frame[MEM_VID_MAXFRAMES];
+} Mem_FrameHeader;
+
+/* With SDL_MEM_VID_YUV_FILE=<file>, a YUV overlay isn't converted to RGB
+   but mapped from that file, so another process can take the frames as
+   they are.  The file starts with this header and the frame slots follow
+   at header_size, with the planes of each slot at offsets[] and pitches[]
+   as given (chroma planes of YV12 and IYUV are rounded up to whole
+   samples).  Only one overlay at a time can use the file; others are
+   converted in software as usual.
+
+   Each SDL_DisplayYUVOverlay publishes a frame with the same sequence,
+   waiters and eventfd signalling as the screen.  src is the part of the
+   overlay being shown and dst is where it goes on the screen, which is
+   not drawn to.  If SDL_MEM_VID_FRAMES is 3 or more the overlay has that
+   many slots, read the same way as the screen's; the overlay's pixels
+   then point to a new slot after each display, holding an old frame, so
+   the application must lock the overlay and draw the whole frame again.
+   With a single slot (num_frames is 1) the application draws the next
+   frame over the one being read, and the sequence counter only keeps
+   the header consistent, so a reader can see a torn frame.
+*/
+#define MEM_YUV_MAGIC     0x594c4453 /* "SDLY" */
+#define MEM_YUV_VERSION   1
+
+typedef struct Mem_YUVHeader {
+	Uint32 magic;
+	Uint32 version;
+	Uint32 header_size;
+	Uint32 format;		/* SDL_YV12_OVERLAY, SDL_YUY2_OVERLAY, ... */
+	Uint32 width, height;
+	Uint32 planes;
+	Uint32 pitches[3];
+	Uint32 offsets[3];
+
+	volatile Uint32 sequence;
+	volatile Uint32 waiters;
+	Uint32 frame;
+	Mem_FrameRect src, dst;
+
+	Uint32 num_frames;
+	Uint32 frame_size;
+	volatile Uint32 latest;
+	volatile Uint32 reading;
+	Uint32 slot_frame[MEM_VID_MAXFRAMES];
+} Mem_YUVHeader;
+
+/* With SDL_MEM_VID_INPUT=<file>, that file is mapped as a ring of input
+   events written by another process and read by SDL_PumpEvents.  There
+   must be a single writer.  It fills events[tail % size], then (after a
+   write barrier) increments tail; the application increments head as it
+   consumes them.  The ring is full when tail - head == size; whoever
+   creates the file first zeroes it and sets size and then magic.
+*/
+#define MEM_INPUT_MAGIC   0x4e494453 /* "SDIN" */
+#define MEM_INPUT_VERSION 1
+#define MEM_INPUT_SIZE    256
+
+enum {
+	MEM_INPUT_KEY = 1,	/* state, sym (SDLKey), mod (SDLMod), unicode */
+	MEM_INPUT_MOTION,	/* x, y in screen coordinates */
+	MEM_INPUT_BUTTON,	/* state, button (SDL_BUTTON_*) */
+	MEM_INPUT_QUIT
+};
+
+typedef struct Mem_InputEvent {
+	Uint32 type;
+	Uint32 state;	/* SDL_PRESSED or SDL_RELEASED */
+	Sint32 x, y;
+	Uint32 sym, mod, unicode;
+	Uint32 button;
+} Mem_InputEvent;
+
+typedef struct Mem_InputRing {
+	Uint32 magic;
+	Uint32 version;
+	Uint32 size;
+	volatile Uint32 head;
+	volatile Uint32 tail;
+	Mem_InputEvent events[MEM_INPUT_SIZE];
+} Mem_InputRing;
+
 /* Private display data */
 struct SDL_PrivateVideoData {
 	SDL_Rect *SDL_modelist[SDL_NUMMODES+1];
@@ -50,6 +194,22 @@ struct SDL_PrivateVideoData {
         int buffer_size;
 	int w, h;
 
+	/* The whole mapping, which may start with a Mem_FrameHeader */
+	void *map;
+	int map_size;
+	Mem_FrameHeader *header;
+	int eventfd;
+
+	/* Injected input, if any */
+	Mem_InputRing *input;
+
+	/* Frame slot the application is drawing into, when double buffered */
+	int num_frames;
+	int back;
+
+	/* An overlay is mapped from SDL_MEM_VID_YUV_FILE */
+	int yuv_mapped;
+
 //	int lastkey;
 //	struct timeval lasttime;
 };
@@ -68,5 +228,8 @@ struct SDL_PrivateVideoData {
 
 #define Mem_mutex		    (this->hidden->mutex)
 
+/* Wake up readers waiting on a frame sequence counter */
+extern void Mem_WakeReaders(_THIS, volatile Uint32 *sequence, volatile Uint32 *waiters);
+
 #endif /* _SDL_memvideo_h */
 
@@ -0,0 +1,256 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 2003  Sam Hocevar
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Hocevar
+    sam@zoy.org
+*/
+
+/* YUV overlays which are handed to another process untouched, rather
+   than converted to RGB on the screen (see Mem_YUVHeader).
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <fcntl.h>
+
+#include "SDL.h"
+#include "SDL_error.h"
+#include "SDL_video.h"
+
+#include "SDL_memvideo.h"
+#include "SDL_memyuv_c.h"
+#include "../SDL_yuvfuncs.h"
+
+/* The functions used to manipulate memory mapped overlays */
+static struct private_yuvhwfuncs mem_yuvfuncs = {
+  Mem_LockYUVOverlay,
+  Mem_UnlockYUVOverlay,
+  Mem_DisplayYUVOverlay,
+  Mem_FreeYUVOverlay
+};
+
+struct private_yuvhwdata {
+  void *map;
+  int map_size;
+  Mem_YUVHeader *header;
+  int back;
+
+  /* These are just so we don't have to allocate them separately */
+  Uint16 pitches[3];
+  Uint8 *planes[3];
+};
+
+/* Point the overlay at the planes of a frame slot */
+static void Mem_SetYUVSlot(SDL_Overlay *overlay, int slot)
+{
+  struct private_yuvhwdata *hwdata = overlay->hwdata;
+  Mem_YUVHeader *h = hwdata->header;
+  Uint8 *frame = (Uint8 *)hwdata->map + h->header_size + slot * h->frame_size;
+
+  hwdata->back = slot;
+  for (int i = 0; i < overlay->planes; i++)
+  {
+    hwdata->planes[i] = frame + h->offsets[i];
+  }
+}
+
+SDL_Overlay *Mem_CreateYUVOverlay(_THIS, int width, int height, Uint32 format, SDL_Surface *display)
+{
+  char *filename = getenv("SDL_MEM_VID_YUV_FILE");
+  if (!filename || this->hidden->yuv_mapped) return NULL;
+
+  /* Lay out the planes of a frame */
+  int planes;
+  Uint32 pitches[3], offsets[3], frame_size;
+  switch (format)
+  {
+    case SDL_YV12_OVERLAY:
+    case SDL_IYUV_OVERLAY:
+      planes = 3;
+      pitches[0] = width;
+      pitches[1] = pitches[2] = (width + 1) / 2;
+      offsets[0] = 0;
+      offsets[1] = offsets[0] + pitches[0] * height;
+      offsets[2] = offsets[1] + pitches[1] * ((height + 1) / 2);
+      frame_size = offsets[2] + pitches[2] * ((height + 1) / 2);
+      break;
+    case SDL_YUY2_OVERLAY:
+    case SDL_UYVY_OVERLAY:
+    case SDL_YVYU_OVERLAY:
+      planes = 1;
+      pitches[0] = (width + 1) / 2 * 4;
+      offsets[0] = 0;
+      frame_size = pitches[0] * height;
+      break;
+    default:
+      /* Let the software overlay report it */
+      return NULL;
+  }
+
+  char *frames = getenv("SDL_MEM_VID_FRAMES");
+  int num_frames = frames ? strtol(frames, NULL, 10) : 1;
+  if (num_frames < 3) num_frames = 1;
+  if (num_frames > MEM_VID_MAXFRAMES) num_frames = MEM_VID_MAXFRAMES;
+
+  SDL_Overlay *overlay = (SDL_Overlay *)malloc(sizeof *overlay);
+  struct private_yuvhwdata *hwdata = (struct private_yuvhwdata *)malloc(sizeof *hwdata);
+  if (!overlay || !hwdata)
+  {
+    free(overlay);
+    free(hwdata);
+    SDL_OutOfMemory();
+    return NULL;
+  }
+  memset(overlay, 0, sizeof *overlay);
+  memset(hwdata, 0, sizeof *hwdata);
+
+  overlay->format = format;
+  overlay->w = width;
+  overlay->h = height;
+  overlay->planes = planes;
+  overlay->hwfuncs = &mem_yuvfuncs;
+  overlay->hwdata = hwdata;
+  overlay->hw_overlay = 1;
+  overlay->pitches = hwdata->pitches;
+  overlay->pixels = hwdata->planes;
+
+  hwdata->map_size = MEM_VID_HEADER_SIZE + frame_size * num_frames;
+  int fd = open(filename, O_CREAT | O_RDWR, S_IRUSR|S_IWUSR);
+  if (fd < 0)
+  {
+    SDL_SetError("Couldn't open file for memory mapped overlay");
+    Mem_FreeYUVOverlay(this, overlay);
+    free(overlay);
+    return NULL;
+  }
+  if (ftruncate(fd, hwdata->map_size) < 0)
+  {
+    close(fd);
+    SDL_SetError("Couldn't resize file for memory mapped overlay");
+    Mem_FreeYUVOverlay(this, overlay);
+    free(overlay);
+    return NULL;
+  }
+  hwdata->map = mmap(NULL, hwdata->map_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (hwdata->map == MAP_FAILED)
+  {
+    hwdata->map = NULL;
+    SDL_SetError("Couldn't map memory for overlay");
+    Mem_FreeYUVOverlay(this, overlay);
+    free(overlay);
+    return NULL;
+  }
+  memset(hwdata->map, 0, hwdata->map_size);
+  this->hidden->yuv_mapped = 1;
+
+  /* Describe the frames for their reader */
+  Mem_YUVHeader *h = hwdata->header = (Mem_YUVHeader *)hwdata->map;
+  h->magic = MEM_YUV_MAGIC;
+  h->version = MEM_YUV_VERSION;
+  h->header_size = MEM_VID_HEADER_SIZE;
+  h->format = format;
+  h->width = width;
+  h->height = height;
+  h->planes = planes;
+  for (int i = 0; i < planes; i++)
+  {
+    h->pitches[i] = hwdata->pitches[i] = pitches[i];
+    h->offsets[i] = offsets[i];
+  }
+  h->num_frames = num_frames;
+  h->frame_size = frame_size;
+  h->latest = (num_frames > 1) ? 1 : 0;
+  h->reading = MEM_VID_NOSLOT;
+
+  Mem_SetYUVSlot(overlay, 0);
+  return overlay;
+}
+
+int Mem_LockYUVOverlay(_THIS, SDL_Overlay *overlay)
+{
+  return 0;
+}
+
+void Mem_UnlockYUVOverlay(_THIS, SDL_Overlay *overlay)
+{
+  return;
+}
+
+int Mem_DisplayYUVOverlay(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
+{
+  struct private_yuvhwdata *hwdata = overlay->hwdata;
+  Mem_YUVHeader *h = hwdata->header;
+
+  h->sequence++;
+  __sync_synchronize();
+
+  if (h->num_frames > 1)
+  {
+    h->slot_frame[hwdata->back] = h->frame + 1;
+    h->latest = hwdata->back;
+  }
+  h->src.x = src->x;
+  h->src.y = src->y;
+  h->src.w = src->w;
+  h->src.h = src->h;
+  h->dst.x = dst->x;
+  h->dst.y = dst->y;
+  h->dst.w = dst->w;
+  h->dst.h = dst->h;
+  h->frame++;
+
+  __sync_synchronize();
+  h->sequence++;
+
+  Mem_WakeReaders(this, &h->sequence, &h->waiters);
+
+  if (h->num_frames > 1)
+  {
+    /* Move on to a slot that is neither published nor being read,
+       as Mem_FlipHWSurface does for the screen */
+    __sync_synchronize();
+    Uint32 reading = h->reading;
+    int next = hwdata->back;
+    do {
+      next = (next + 1) % h->num_frames;
+    } while (next == (int)h->latest || (Uint32)next == reading);
+    Mem_SetYUVSlot(overlay, next);
+  }
+  return 0;
+}
+
+void Mem_FreeYUVOverlay(_THIS, SDL_Overlay *overlay)
+{
+  struct private_yuvhwdata *hwdata = overlay->hwdata;
+
+  if (hwdata)
+  {
+    if (hwdata->map)
+    {
+      munmap(hwdata->map, hwdata->map_size);
+      this->hidden->yuv_mapped = 0;
+    }
+    free(hwdata);
+  }
+  overlay->hwdata = NULL;
+}
@@ -39,9 +39,8 @@ static SDLKey MISC_keymap[256];
 static SDLKey VNC_TranslateKeycode(rfbKeySym kc);
 
 
-void VNC_on_key (rfbBool down, rfbKeySym key, rfbClientPtr cl)
+static void VNC_DispatchKey (int down, rfbKeySym key)
 {
-  struct SDL_PrivateVideoData * self = ((SDL_VideoDevice*)cl->screen->screenData)->hidden;
   SDL_keysym keysym = {0};
   keysym.scancode = key;
   keysym.sym = VNC_TranslateKeycode(key);
@@ -55,6 +54,80 @@ void VNC_on_key (rfbBool down, rfbKeySym key, rfbClientPtr cl)
 }
 
 
+void VNC_on_key (rfbBool down, rfbKeySym key, rfbClientPtr cl)
+{
+  struct SDL_PrivateVideoData * self = ((SDL_VideoDevice*)cl->screen->screenData)->hidden;
+  if (self->threaded)
+  {
+    VNC_Event ev = {0};
+    ev.type = VNC_EVENT_KEY;
+    ev.down = down;
+    ev.key = key;
+    VNC_QueueEvent(self, &ev);
+    return;
+  }
+  VNC_DispatchKey(down, key);
+}
+
+
+/* Called from the libvncserver threads in threaded mode.  Consecutive
+   pointer motion with the same buttons is collapsed into one event, and
+   if the application stops pumping events new input is dropped.
+*/
+void VNC_QueueEvent(struct SDL_PrivateVideoData *self, const VNC_Event *event)
+{
+  SDL_mutexP(self->mutex);
+  if (event->type == VNC_EVENT_POINTER && self->eventq_head != self->eventq_tail)
+  {
+    VNC_Event *last = &self->eventq[(self->eventq_tail + VNC_EVENTQ_SIZE - 1) % VNC_EVENTQ_SIZE];
+    if (last->type == VNC_EVENT_POINTER && last->buttonmask == event->buttonmask)
+    {
+      last->x = event->x;
+      last->y = event->y;
+      SDL_mutexV(self->mutex);
+      return;
+    }
+  }
+  int next = (self->eventq_tail + 1) % VNC_EVENTQ_SIZE;
+  if (next != self->eventq_head)
+  {
+    self->eventq[self->eventq_tail] = *event;
+    self->eventq_tail = next;
+  }
+  SDL_mutexV(self->mutex);
+}
+
+void VNC_DrainEvents(_THIS)
+{
+  for (;;)
+  {
+    VNC_Event ev;
+    SDL_mutexP(VNC_mutex);
+    if (this->hidden->eventq_head == this->hidden->eventq_tail)
+    {
+      SDL_mutexV(VNC_mutex);
+      break;
+    }
+    ev = this->hidden->eventq[this->hidden->eventq_head];
+    this->hidden->eventq_head = (this->hidden->eventq_head + 1) % VNC_EVENTQ_SIZE;
+    SDL_mutexV(VNC_mutex);
+
+    switch (ev.type)
+    {
+      case VNC_EVENT_KEY:
+        VNC_DispatchKey(ev.down, ev.key);
+        break;
+      case VNC_EVENT_POINTER:
+        VNC_DispatchPointer(this->hidden, ev.buttonmask, ev.x, ev.y);
+        break;
+      case VNC_EVENT_QUIT:
+        SDL_PrivateQuit();
+        break;
+    }
+  }
+}
+
+
 void VNC_InitOSKeymap(_THIS)
 {
   int i;
@@ -27,6 +27,10 @@
    of the native video subsystem (SDL_sysvideo.c)
 */
 extern void VNC_InitOSKeymap(_THIS);
+extern void VNC_on_key(rfbBool down, rfbKeySym key, rfbClientPtr cl);
+extern void VNC_QueueEvent(struct SDL_PrivateVideoData *self, const VNC_Event *event);
+extern void VNC_DrainEvents(_THIS);
+extern void VNC_DispatchPointer(struct SDL_PrivateVideoData *self, int buttonmask, int x, int y);
 //extern void VNC_PumpEvents(_THIS);
 
 /* end of SDL_vncevents_c.h ... */
@@ -0,0 +1,174 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 2003  Sam Hocevar
+    Copyright (C) 2019  Murphy McCauley
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Hocevar
+    sam@zoy.org
+*/
+#include "SDL_config.h"
+
+#include "SDL_mouse.h"
+#include "../../events/SDL_events_c.h"
+#include "../SDL_cursor_c.h"
+#include "SDL_vncvideo.h"
+#include "SDL_vncmouse_c.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/* The implementation dependent data for the window manager cursor.
+   We own all of the rfbCursor's memory (its cleanup flags are false), so
+   libvncserver never frees it behind SDL's back; the only exception is
+   the rich cursor libvncserver builds on demand for RichCursor clients.
+*/
+struct WMcursor {
+  rfbCursor cursor;
+};
+
+static void VNC_FreeRichSource(rfbCursor *c)
+{
+  if (c->cleanupRichSource)
+  {
+    if (c->richSource) free(c->richSource);
+    if (c->alphaSource) free(c->alphaSource);
+    c->cleanupRichSource = FALSE;
+  }
+  c->richSource = NULL;
+  c->alphaSource = NULL;
+}
+
+void VNC_FreeWMCursor(_THIS, WMcursor *cursor)
+{
+  rfbScreenInfoPtr sc = this->hidden->screen;
+  if (sc && sc->cursor == &cursor->cursor)
+  {
+    rfbSetCursor(sc, NULL);
+  }
+  VNC_FreeRichSource(&cursor->cursor);
+  free(cursor->cursor.source);
+  free(cursor->cursor.mask);
+  free(cursor);
+}
+
+WMcursor *VNC_CreateWMCursor(_THIS,
+    Uint8 *data, Uint8 *mask, int w, int h, int hot_x, int hot_y)
+{
+  WMcursor *cursor;
+  int clen, i;
+
+  cursor = (WMcursor *)malloc(sizeof(WMcursor));
+  if ( cursor == NULL ) {
+    SDL_OutOfMemory();
+    return(NULL);
+  }
+  memset(cursor, 0, sizeof(WMcursor));
+
+  /* Both SDL and VNC use MSB-first bitmaps padded to whole bytes */
+  clen = (w/8)*h;
+  cursor->cursor.source = (unsigned char *)malloc(clen);
+  cursor->cursor.mask = (unsigned char *)malloc(clen);
+  if ( !cursor->cursor.source || !cursor->cursor.mask ) {
+    free(cursor->cursor.source);
+    free(cursor->cursor.mask);
+    free(cursor);
+    SDL_OutOfMemory();
+    return(NULL);
+  }
+
+  /* SDL: data 1 is black, mask 1 without data is white, and data 1 without
+     mask would be inverted, which VNC can't do, so it is drawn black.
+     VNC: mask selects visible pixels, source picks fore over back color.
+   */
+  for ( i=0; i<clen; ++i ) {
+    cursor->cursor.source[i] = data[i];
+    cursor->cursor.mask[i] = data[i] | mask[i];
+  }
+  cursor->cursor.width = w;
+  cursor->cursor.height = h;
+  cursor->cursor.xhot = hot_x;
+  cursor->cursor.yhot = hot_y;
+  cursor->cursor.foreRed = cursor->cursor.foreGreen = cursor->cursor.foreBlue = 0;
+  cursor->cursor.backRed = cursor->cursor.backGreen = cursor->cursor.backBlue = 0xffff;
+
+  return(cursor);
+}
+
+int VNC_ShowWMCursor(_THIS, WMcursor *cursor)
+{
+  rfbScreenInfoPtr sc = this->hidden->screen;
+  if (!sc)
+  {
+    return(cursor == NULL);
+  }
+
+  if (cursor)
+  {
+    /* Any rich cursor was built for the screen format of an earlier mode */
+    if (sc->cursor != &cursor->cursor)
+    {
+      VNC_FreeRichSource(&cursor->cursor);
+    }
+    rfbSetCursor(sc, &cursor->cursor);
+  }
+  else
+  {
+    rfbSetCursor(sc, NULL);
+  }
+  return(1);
+}
+
+/* Moving the cursor ourselves only costs a CursorPos update */
+void VNC_WarpWMCursor(_THIS, Uint16 x, Uint16 y)
+{
+  rfbScreenInfoPtr sc = this->hidden->screen;
+  if (sc)
+  {
+    rfbClientIteratorPtr it;
+    rfbClientPtr cl;
+
+#ifdef LIBVNCSERVER_HAVE_LIBPTHREAD
+    LOCK(sc->cursorMutex);
+#endif
+    sc->cursorX = x;
+    sc->cursorY = y;
+#ifdef LIBVNCSERVER_HAVE_LIBPTHREAD
+    UNLOCK(sc->cursorMutex);
+#endif
+
+    /* Client output threads check cursorWasMoved under updateMutex */
+    it = rfbGetClientIterator(sc);
+    while ((cl = rfbClientIteratorNext(it)) != NULL)
+    {
+      if (!cl->enableCursorPosUpdates) continue;
+#ifdef LIBVNCSERVER_HAVE_LIBPTHREAD
+      LOCK(cl->updateMutex);
+      cl->cursorWasMoved = TRUE;
+      TSIGNAL(cl->updateCond);
+      UNLOCK(cl->updateMutex);
+#else
+      cl->cursorWasMoved = TRUE;
+#endif
+    }
+    rfbReleaseClientIterator(it);
+  }
+
+  this->hidden->last_curx = x;
+  this->hidden->last_cury = y;
+  SDL_PrivateMouseMotion(0, 0, x, y);
+}
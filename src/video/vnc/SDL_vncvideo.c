@@ -26,15 +26,6 @@ static char rcsid =
  "";
 #endif
 
-/*
-
-TODO
-====
-* Framerate throttle?
-* Cursor stuff?
-
-*/
-
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -54,6 +45,7 @@ TODO
 
 #include "SDL_vncvideo.h"
 #include "SDL_vncevents_c.h"
+#include "SDL_vncmouse_c.h"
 
 
 /* Initialization/Query functions */
@@ -125,19 +117,176 @@ static int ParseCommandLine(char *cmdline, char **argv)
 }
 
 
+/* Mark the parts of a region where cur differs from prev as modified.
+   The region is checked in tiles which are one cache line wide, and
+   horizontal runs of changed tiles are marked as a single rectangle.
+   If copy is set, changed tiles are also copied from cur into prev.
+*/
+static void VNC_MarkChangedTiles(_THIS, const Uint8 *cur, Uint8 *prev, int copy,
+                                 int x1, int y1, int x2, int y2)
+{
+  if (x1 < 0) x1 = 0;
+  if (y1 < 0) y1 = 0;
+  if (x2 > SELF->w) x2 = SELF->w;
+  if (y2 > SELF->h) y2 = SELF->h;
+  if (x1 >= x2 || y1 >= y2) return;
+
+  int bpp = SELF->bytes_per_pixel;
+  int tile_w = VNC_TILE_BYTES / bpp;
+  if (tile_w < 1) tile_w = 1;
+
+  x1 = x1 / tile_w * tile_w;
+  y1 = y1 / VNC_TILE_ROWS * VNC_TILE_ROWS;
+
+  for (int ty = y1; ty < y2; ty += VNC_TILE_ROWS)
+  {
+    int ty2 = ty + VNC_TILE_ROWS;
+    if (ty2 > y2) ty2 = y2;
+    int run = -1;
+    for (int tx = x1; tx < x2; tx += tile_w)
+    {
+      int tx2 = tx + tile_w;
+      if (tx2 > x2) tx2 = x2;
+      int len = (tx2 - tx) * bpp;
+      int dirty = 0;
+      for (int y = ty; y < ty2; y++)
+      {
+        int off = y * SELF->pitch + tx * bpp;
+        if (memcmp(cur + off, prev + off, len) != 0)
+        {
+          dirty = 1;
+          if (!copy) break;
+          memcpy(prev + off, cur + off, len);
+        }
+      }
+      if (dirty)
+      {
+        if (run < 0) run = tx;
+      }
+      else if (run >= 0)
+      {
+        rfbMarkRectAsModified(SELF->screen, run, ty, tx, ty2);
+        run = -1;
+      }
+    }
+    if (run >= 0) rfbMarkRectAsModified(SELF->screen, run, ty, x2, ty2);
+  }
+}
+
+/* In threaded mode each client's output thread reads the framebuffer while
+   holding its sendMutex, so hold all of them while the framebuffer changes.
+   The clients are referenced so none can go away before being unlocked.
+*/
+static void VNC_LockSenders(_THIS)
+{
+  SELF->num_senders = 0;
+#ifdef LIBVNCSERVER_HAVE_LIBPTHREAD
+  if (!SELF->threaded) return;
+
+  rfbClientIteratorPtr it = rfbGetClientIterator(SELF->screen);
+  rfbClientPtr cl;
+  while ((cl = rfbClientIteratorNext(it)))
+  {
+    if (SELF->num_senders == SELF->max_senders)
+    {
+      int max = SELF->max_senders ? SELF->max_senders * 2 : 8;
+      rfbClientPtr * senders = realloc(SELF->senders, max * sizeof(*senders));
+      if (!senders) break;
+      SELF->senders = senders;
+      SELF->max_senders = max;
+    }
+    rfbIncrClientRef(cl);
+    LOCK(cl->sendMutex);
+    SELF->senders[SELF->num_senders++] = cl;
+  }
+  rfbReleaseClientIterator(it);
+#endif
+}
+
+static void VNC_UnlockSenders(_THIS)
+{
+#ifdef LIBVNCSERVER_HAVE_LIBPTHREAD
+  for (int i = 0; i < SELF->num_senders; i++)
+  {
+    rfbClientPtr cl = SELF->senders[i];
+    UNLOCK(cl->sendMutex);
+    rfbDecrClientRef(cl);
+  }
+#endif
+  SELF->num_senders = 0;
+}
+
+/* Copy a region into the shadow buffer and mark all of it as modified */
+static void VNC_CopyToShadow(_THIS, int x1, int y1, int x2, int y2)
+{
+  if (x1 < 0) x1 = 0;
+  if (y1 < 0) y1 = 0;
+  if (x2 > SELF->w) x2 = SELF->w;
+  if (y2 > SELF->h) y2 = SELF->h;
+  if (x1 >= x2 || y1 >= y2) return;
+
+  int bpp = SELF->bytes_per_pixel;
+  for (int y = y1; y < y2; y++)
+  {
+    int off = y * SELF->pitch + x1 * bpp;
+    memcpy((Uint8 *)VNC_shadow + off, (Uint8 *)VNC_buffer + off, (x2 - x1) * bpp);
+  }
+  rfbMarkRectAsModified(SELF->screen, x1, y1, x2, y2);
+}
+
+/* Mark a region as modified, but only the parts of it that actually differ
+   from what we last sent (as recorded in the shadow buffer).  In threaded
+   mode the shadow buffer is what the server sends, so with diffing
+   disabled the whole region is still copied into it.
+*/
+static void VNC_MarkModified(_THIS, int x1, int y1, int x2, int y2)
+{
+  if (!VNC_shadow)
+  {
+    rfbMarkRectAsModified(SELF->screen, x1, y1, x2, y2);
+    return;
+  }
+  VNC_LockSenders(this);
+  if (SELF->diff)
+    VNC_MarkChangedTiles(this, VNC_buffer, VNC_shadow, 1, x1, y1, x2, y2);
+  else
+    VNC_CopyToShadow(this, x1, y1, x2, y2);
+  VNC_UnlockSenders(this);
+}
+
+
 static void on_client_leave (rfbClientPtr cl)
 {
   SDL_VideoDevice * dev = ((SDL_VideoDevice*)cl->screen->screenData);
-  dev->hidden->client_count--;
-  if (dev->hidden->client_count <= 0)
+  struct SDL_PrivateVideoData * self = dev->hidden;
+  int gone;
+
+  if (cl->clientData)
+  {
+    free(cl->clientData);
+    cl->clientData = NULL;
+  }
+
+  SDL_mutexP(self->mutex);
+  self->client_count--;
+  gone = (self->client_count <= 0) && !self->quitting;
+  SDL_mutexV(self->mutex);
+  if (!gone) return;
+
+  if (self->threaded)
+  {
+    VNC_Event ev = {0};
+    ev.type = VNC_EVENT_QUIT;
+    VNC_QueueEvent(self, &ev);
+  }
+  else
   {
     SDL_PrivateQuit();
   }
 }
 
-static void on_ptr (int buttonmask, int x, int y, rfbClientPtr cl)
+void VNC_DispatchPointer (struct SDL_PrivateVideoData * self, int buttonmask, int x, int y)
 {
-  struct SDL_PrivateVideoData * self = ((SDL_VideoDevice*)cl->screen->screenData)->hidden;
   if (buttonmask != self->last_buttonmask)
   {
     int cur = buttonmask, prev = self->last_buttonmask;
@@ -157,37 +306,190 @@ static void on_ptr (int buttonmask, int x, int y, rfbClientPtr cl)
     self->last_cury = y;
     SDL_PrivateMouseMotion(0, 0, x, y);
   }
+}
+
+static void on_ptr (int buttonmask, int x, int y, rfbClientPtr cl)
+{
+  struct SDL_PrivateVideoData * self = ((SDL_VideoDevice*)cl->screen->screenData)->hidden;
+  if (self->threaded)
+  {
+    VNC_Event ev = {0};
+    ev.type = VNC_EVENT_POINTER;
+    ev.buttonmask = buttonmask;
+    ev.x = x;
+    ev.y = y;
+    VNC_QueueEvent(self, &ev);
+  }
+  else
+  {
+    VNC_DispatchPointer(self, buttonmask, x, y);
+  }
   rfbDefaultPtrAddEvent(buttonmask,x,y,cl);
 }
 
-extern void VNC_on_key (rfbBool down, rfbKeySym key, rfbClientPtr cl);
 
+/* Choose encoding settings for a client from its measured throughput */
+static void VNC_AdaptClient (rfbClientPtr cl, VNC_ClientData * cd)
+{
+  if (cl->preferredEncoding != cd->set_encoding)
+  {
+    /* First look at this client, or it has sent new SetEncodings */
+    cd->client_encoding = cl->preferredEncoding;
+#ifdef LIBVNCSERVER_HAVE_LIBJPEG
+    cd->client_quality = cl->tightQualityLevel;
+#endif
+#ifdef LIBVNCSERVER_HAVE_LIBZ
+    cd->client_tight_compress = cl->tightCompressLevel;
+    cd->client_zlib_compress = cl->zlibCompressLevel;
+#endif
+  }
+
+  int encoding = cd->client_encoding;
+  int quality = cd->client_quality;
+  int wan = (cd->throughput > 0 && cd->throughput < VNC_WAN_THROUGHPUT) ||
+            cd->latency > VNC_WAN_LATENCY;
+
+  if (cd->throughput >= VNC_LAN_THROUGHPUT && cd->latency < VNC_LAN_LATENCY)
+  {
+    /* Every client supports raw, and it costs nothing to encode */
+    encoding = rfbEncodingRaw;
+  }
+  else if (wan)
+  {
+    /* Only lower JPEG quality; a client that didn't ask for JPEG (-1)
+       may not be able to decode it */
+    if (quality > VNC_WAN_QUALITY) quality = VNC_WAN_QUALITY;
+  }
+
+  cl->preferredEncoding = cd->set_encoding = encoding;
+#ifdef LIBVNCSERVER_HAVE_LIBJPEG
+  cl->tightQualityLevel = quality;
+#endif
+#ifdef LIBVNCSERVER_HAVE_LIBZ
+  /* Slow links are worth the most compression */
+  cl->tightCompressLevel = wan ? 9 : cd->client_tight_compress;
+  cl->zlibCompressLevel = wan ? 9 : cd->client_zlib_compress;
+#endif
+}
+
+/* Called around each update sent to a client */
+static void on_display (rfbClientPtr cl)
+{
+  VNC_ClientData * cd = (VNC_ClientData *)cl->clientData;
+  if (!cd) return;
+
+  cd->send_start = SDL_GetTicks();
+  cd->start_bytes = rfbStatGetSentBytes(cl);
+}
+
+static void on_display_finished (rfbClientPtr cl, int result)
+{
+  VNC_ClientData * cd = (VNC_ClientData *)cl->clientData;
+  if (!cd) return;
+
+  cd->send_end = SDL_GetTicks();
+  cd->update_bytes = rfbStatGetSentBytes(cl) - cd->start_bytes;
+  cd->awaiting_request = 1;
+}
+
+/* Smooth a new measurement into a running one */
+static int VNC_Smooth (int old, int sample)
+{
+  return old ? (old * 3 + sample) / 4 : sample;
+}
+
+/* A client asks for the next update once it has the last one, so the
+   time from sending an update to the request is the time the update
+   took to arrive plus the round trip.  Time when nothing was sent
+   doesn't count.  Small updates measure the round trip, and large ones
+   the throughput once the round trip is taken off.
+*/
+static void on_update_request (rfbClientPtr cl, rfbFramebufferUpdateRequestMsg * msg)
+{
+  VNC_ClientData * cd = (VNC_ClientData *)cl->clientData;
+  if (!cd) return;
+
+  if (cd->awaiting_request)
+  {
+    Uint32 now = SDL_GetTicks();
+    cd->awaiting_request = 0;
+
+    if (cd->update_bytes < 16384)
+    {
+      cd->latency = VNC_Smooth(cd->latency, (int)(now - cd->send_end));
+    }
+    else
+    {
+      int elapsed = (int)(now - cd->send_start) - cd->latency;
+      if (elapsed < 1) elapsed = 1;
+      cd->throughput = VNC_Smooth(cd->throughput, cd->update_bytes / elapsed);
+    }
+  }
+
+  VNC_AdaptClient(cl, cd);
+}
 
 static enum rfbNewClientAction on_client_join (rfbClientPtr cl)
 {
   SDL_VideoDevice * dev = ((SDL_VideoDevice*)cl->screen->screenData);
 
+  SDL_mutexP(dev->hidden->mutex);
   dev->hidden->client_count++;
+  SDL_mutexV(dev->hidden->mutex);
   cl->clientGoneHook = on_client_leave;
 
+  if (dev->hidden->adaptive)
+  {
+    VNC_ClientData * cd = (VNC_ClientData *)malloc(sizeof(VNC_ClientData));
+    if (cd)
+    {
+      memset(cd, 0, sizeof(VNC_ClientData));
+      cd->set_encoding = -1;
+      cl->clientData = cd;
+      cl->clientFramebufferUpdateRequestHook = on_update_request;
+    }
+  }
+
   return RFB_CLIENT_ACCEPT;
 }
 
+/* Disconnect everyone and stop the server (and its threads, if any) */
+static void VNC_CloseScreen(_THIS)
+{
+  if (!SELF->screen) return;
+
+  SELF->quitting = 1;
+  rfbShutdownServer(SELF->screen, TRUE);
+  SELF->screen->cursor = NULL; // Owned by SDL_cursor.c
+  rfbScreenCleanup(SELF->screen);
+  SELF->screen = NULL;
+  SELF->quitting = 0;
+
+  SELF->client_count = 0;
+  SELF->eventq_head = SELF->eventq_tail = 0;
+}
+
 static void VNC_PumpEvents(_THIS)
 {
   if (!SELF->screen) return;
   if (!rfbIsActive(SELF->screen)) return;
 
-  if (SELF->keyframe_delay >= 0)
+  if (SELF->keyframe_delay >= 0 && !SELF->front)
   {
     unsigned now = SDL_GetTicks();
     if ((now - SELF->keyframe_prev) > (unsigned)SELF->keyframe_delay)
     {
       SELF->keyframe_prev = now;
-      rfbMarkRectAsModified(SELF->screen, 0,0, SELF->w, SELF->h);
+      VNC_MarkModified(this, 0,0, SELF->w, SELF->h);
     }
   }
 
+  if (SELF->threaded)
+  {
+    VNC_DrainEvents(this);
+    return;
+  }
+
   while (rfbProcessEvents(SELF->screen, 0));
 }
 
@@ -257,6 +559,10 @@ static SDL_VideoDevice *VNC_CreateDevice(int devindex)
   device->IconifyWindow = NULL;
   device->GrabInput = NULL;
   device->GetWMInfo = NULL;
+  device->FreeWMCursor = VNC_FreeWMCursor;
+  device->CreateWMCursor = VNC_CreateWMCursor;
+  device->ShowWMCursor = VNC_ShowWMCursor;
+  device->WarpWMCursor = VNC_WarpWMCursor;
   device->InitOSKeymap = VNC_InitOSKeymap;
   device->PumpEvents = VNC_PumpEvents;
 
@@ -288,7 +594,7 @@ int VNC_VideoInit(_THIS, SDL_PixelFormat *vformat)
   SDL_modelist[5]->w = 320; SDL_modelist[5]->h = 200;
   SDL_modelist[6] = NULL;
 
-  //VNC_mutex = SDL_CreateMutex();
+  VNC_mutex = SDL_CreateMutex();
 
   /* Initialize private variables */
   //XXX VNC_lastkey = 0;
@@ -329,11 +635,19 @@ static void VNC_DirectUpdate(_THIS, int numrects, SDL_Rect *rects);
 SDL_Surface *VNC_SetVideoMode(_THIS, SDL_Surface *current,
         int width, int height, int bpp, Uint32 flags)
 {
-  if ( VNC_buffer ) {
-    free( VNC_buffer );
+  VNC_CloseScreen(this);
+
+  if ( SELF->frames ) {
+    free( SELF->frames );
+    SELF->frames = NULL;
     VNC_buffer = NULL;
+    SELF->front = NULL;
     VNC_buffer_size = 0;
   }
+  if ( VNC_shadow ) {
+    free( VNC_shadow );
+    VNC_shadow = NULL;
+  }
 
   int realbpp = bpp;
   // realbpp determines number of bytes in memory
@@ -367,9 +681,46 @@ SDL_Surface *VNC_SetVideoMode(_THIS, SDL_Surface *current,
 
   VNC_buffer_size = pitch * height;
 
-  VNC_buffer = malloc(pitch * height);
+  // With SDL_DOUBLEBUF the app draws into VNC_buffer while the server
+  // sends from SELF->front, and the two are swapped by SDL_Flip
+  int doublebuf = (flags & SDL_DOUBLEBUF) == SDL_DOUBLEBUF;
+  SELF->frames = malloc(VNC_buffer_size * (doublebuf ? 2 : 1));
+  if ( ! SELF->frames ) {
+    SDL_OutOfMemory();
+    return NULL;
+  }
+  memset(SELF->frames, 0, VNC_buffer_size * (doublebuf ? 2 : 1));
+  VNC_buffer = SELF->frames;
+  if (doublebuf) SELF->front = (Uint8 *)SELF->frames + VNC_buffer_size;
+
+  // Run the server on its own threads, sending from the shadow buffer
+  SELF->threaded = getenvintz("SDL_VID_VNC_THREADED");
+#ifndef LIBVNCSERVER_HAVE_LIBPTHREAD
+  SELF->threaded = 0;
+#endif
 
-  memset(VNC_buffer, 0, VNC_buffer_size);
+  // Flip pacing: maximum frame rate (0 for none), and how long a flip
+  // may wait for the slowest client to catch up.  By default a flip
+  // never waits, so a slow client can't stall the application; set a
+  // timeout in ms to hold frames back until every client has them.
+  int fps = getenvintz("SDL_VID_VNC_FPS");
+  SELF->frame_ms = (fps > 0) ? 1000 / fps : 0;
+  SELF->flip_timeout = getenvintz("SDL_VID_VNC_FLIP_TIMEOUT");
+  SELF->last_flip = SDL_GetTicks();
+
+  // Only send tiles which really changed (set to 0 to disable).  When
+  // double buffered, the two buffers are compared instead.
+  SELF->diff = getenvint("SDL_VID_VNC_DIFF", 1);
+  if (!doublebuf && (SELF->threaded || SELF->diff))
+  {
+    VNC_shadow = malloc(VNC_buffer_size);
+    if (VNC_shadow) memset(VNC_shadow, 0, VNC_buffer_size);
+  }
+  if (SELF->threaded && !doublebuf && !VNC_shadow)
+  {
+    SDL_OutOfMemory();
+    return NULL;
+  }
 
   static int mode8[] = {0, 0, 0};
   static int mode15[] = {0x7c00, 0x03e0, 0x001f};
@@ -398,16 +749,22 @@ SDL_Surface *VNC_SetVideoMode(_THIS, SDL_Surface *current,
 
   /* Set up the new mode framebuffer */
   current->flags = SDL_FULLSCREEN;
+  if (doublebuf) current->flags |= SDL_HWSURFACE | SDL_DOUBLEBUF;
   VNC_w = current->w = width;
   VNC_h = current->h = height;
   current->pitch = pitch;
   current->pixels = VNC_buffer;
+  SELF->pitch = pitch;
+  SELF->bytes_per_pixel = realbpp / 8;
 
   /* Set the blit function */
   this->UpdateRects = VNC_DirectUpdate;
 
   this->hidden->keyframe_delay = getenvint("SDL_VID_VNC_FRAMEDELAY", -1);
 
+  // Override each client's encoding choice based on its throughput
+  this->hidden->adaptive = getenvintz("SDL_VID_VNC_ADAPTIVE");
+
 
   char * cmdline = SDL_getenv("SDL_VID_VNC_CMDLINE");
   if (!cmdline) cmdline = "";
@@ -425,16 +782,28 @@ SDL_Surface *VNC_SetVideoMode(_THIS, SDL_Surface *current,
     return NULL;
   }
 
-  sc->frameBuffer = VNC_buffer;
+  // In threaded mode the server must only see complete updates, so it
+  // reads the shadow buffer, which VNC_MarkModified fills in
+  if (doublebuf)
+    sc->frameBuffer = SELF->front;
+  else
+    sc->frameBuffer = SELF->threaded ? VNC_shadow : VNC_buffer;
   sc->desktopName = "SDL App";
   //sc->alwaysShared = TRUE;
   sc->ptrAddEvent = on_ptr;
   sc->kbdAddEvent = VNC_on_key;
   sc->newClientHook = on_client_join;
+  if (SELF->adaptive)
+  {
+    sc->displayHook = on_display;
+    sc->displayFinishedHook = on_display_finished;
+  }
   sc->screenData = (void*)this;
 
   rfbInitServer(sc);
 
+  if (SELF->threaded) rfbRunEventLoop(sc, -1, TRUE);
+
   printf("VNC Video format - size:%ix%i bpp:%i realbpp:%i realwidth:%i pitch:%i\n", width, height, bpp, realbpp, realwidth, pitch);
 
   /* We're done */
@@ -457,11 +826,87 @@ static int VNC_LockHWSurface(_THIS, SDL_Surface *surface)
   /* TODO ? */
   return 0;
 }
+
+/* Handle VNC I/O for up to ms milliseconds */
+static void VNC_Service(_THIS, int ms)
+{
+  if (SELF->threaded)
+  {
+    SDL_Delay(ms);
+    return;
+  }
+  Uint32 end = SDL_GetTicks() + ms;
+  do
+  {
+    rfbProcessEvents(SELF->screen, ms * 1000);
+    ms = (int)(end - SDL_GetTicks());
+  } while (ms > 0);
+}
+
+/* Is any client still waiting to be sent (or being sent) the last frame? */
+static int VNC_ClientsPending(_THIS)
+{
+  int pending = 0;
+  rfbClientIteratorPtr it = rfbGetClientIterator(SELF->screen);
+  rfbClientPtr cl;
+  while (!pending && (cl = rfbClientIteratorNext(it)))
+  {
+#ifdef LIBVNCSERVER_HAVE_LIBPTHREAD
+    if (SELF->threaded)
+    {
+      // Holding sendMutex means no update is being encoded right now
+      LOCK(cl->sendMutex);
+      LOCK(cl->updateMutex);
+      pending = !sraRgnEmpty(cl->modifiedRegion);
+      UNLOCK(cl->updateMutex);
+      UNLOCK(cl->sendMutex);
+      continue;
+    }
+#endif
+    pending = !sraRgnEmpty(cl->modifiedRegion);
+  }
+  rfbReleaseClientIterator(it);
+  return pending;
+}
+
 static int VNC_FlipHWSurface(_THIS, SDL_Surface *surface)
 {
-  rfbMarkRectAsModified(this->hidden->screen, 0,0, SELF->w, SELF->h);
-  //TODO: Should we claim SDL_DOUBLEBUF and throttle the frame rate here
-  //      by processing VNC events for as long as the "rest of the frame"?
+  if (!SELF->front)
+  {
+    VNC_MarkModified(this, 0,0, SELF->w, SELF->h);
+    return 0;
+  }
+
+  /* Keep to the frame rate cap, servicing clients in the meantime */
+  if (SELF->frame_ms > 0)
+  {
+    int left = (int)(SELF->last_flip + SELF->frame_ms - SDL_GetTicks());
+    if (left > 0) VNC_Service(this, left);
+  }
+
+  /* Don't replace a frame that some client hasn't received yet */
+  Uint32 start = SDL_GetTicks();
+  while (SELF->flip_timeout > 0 && VNC_ClientsPending(this))
+  {
+    if ((int)(SDL_GetTicks() - start) >= SELF->flip_timeout) break;
+    VNC_Service(this, 1);
+  }
+  SELF->last_flip = SDL_GetTicks();
+
+  /* Swap, then mark whatever differs from the frame the clients have */
+  VNC_LockSenders(this);
+  Uint8 * prev = SELF->front;
+  SELF->front = VNC_buffer;
+  SELF->screen->frameBuffer = SELF->front;
+  VNC_buffer = prev;
+  surface->pixels = prev;
+
+  if (SELF->diff)
+    VNC_MarkChangedTiles(this, SELF->front, prev, 0, 0,0, SELF->w, SELF->h);
+  else
+    rfbMarkRectAsModified(SELF->screen, 0,0, SELF->w, SELF->h);
+  VNC_UnlockSenders(this);
+
   return 0;
 }
 
@@ -472,10 +917,13 @@ static void VNC_UnlockHWSurface(_THIS, SDL_Surface *surface)
 
 static void VNC_DirectUpdate(_THIS, int numrects, SDL_Rect *rects)
 {
+  // Double buffered frames are only shown by SDL_Flip
+  if (SELF->front) return;
+
   for ( int i = 0; i < numrects; i++ )
   {
     SDL_Rect * r = rects+i;
-    rfbMarkRectAsModified(this->hidden->screen, r->x, r->y, r->x+r->w,r->y+r->h);
+    VNC_MarkModified(this, r->x, r->y, r->x+r->w,r->y+r->h);
   }
 
   return;
@@ -488,6 +936,8 @@ void VNC_VideoQuit(_THIS)
 {
   int i;
 
+  VNC_CloseScreen(this);
+
   /* Free video mode lists */
   for ( i=0; i<SDL_NUMMODES; ++i ) {
     if ( SDL_modelist[i] != NULL ) {
@@ -496,10 +946,25 @@ void VNC_VideoQuit(_THIS)
     }
   }
 
-  if ( VNC_buffer ) {
-    free( VNC_buffer );
+  /* The frames aren't for SDL_FreeSurface() to free */
+  if ( this->screen ) {
+    this->screen->pixels = NULL;
+  }
+  if ( SELF->frames ) {
+    free( SELF->frames );
+    SELF->frames = NULL;
     VNC_buffer = NULL;
+    SELF->front = NULL;
+  }
+  if ( VNC_shadow ) {
+    free( VNC_shadow );
+    VNC_shadow = NULL;
+  }
+  if ( SELF->senders ) {
+    free( SELF->senders );
+    SELF->senders = NULL;
+    SELF->max_senders = 0;
   }
 
-  //SDL_DestroyMutex(VNC_mutex);
+  SDL_DestroyMutex(VNC_mutex);
 }
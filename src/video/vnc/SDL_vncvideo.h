@@ -42,21 +42,98 @@ static char rcsid =
 
 #define SDL_NUMMODES 6
 
+/* Framebuffer diffing works on tiles one cache line wide */
+#define VNC_TILE_BYTES 64
+#define VNC_TILE_ROWS 16
+
+/* Adaptive encoding: clients faster than this (bytes per ms) and closer
+   than this round trip (ms) get raw updates, which are cheapest to
+   produce; clients slower or further away than the WAN thresholds get
+   maximum compression and reduced JPEG quality. */
+#define VNC_LAN_THROUGHPUT 10000
+#define VNC_LAN_LATENCY 10
+#define VNC_WAN_THROUGHPUT 500
+#define VNC_WAN_LATENCY 100
+#define VNC_WAN_QUALITY 4
+
+/* Per-client bookkeeping, hung off rfbClientRec's clientData */
+typedef struct VNC_ClientData {
+  /* The last update sent: when it started and ended, and its size */
+  Uint32 send_start;
+  Uint32 send_end;
+  int start_bytes;
+  int update_bytes;
+  int awaiting_request;
+
+  /* Smoothed measurements, 0 until there is one */
+  int throughput;  /* bytes per ms */
+  int latency;     /* round trip, ms */
+
+  /* What the client itself asked for, and what we last set */
+  int client_encoding;
+  int client_quality;
+  int client_tight_compress;
+  int client_zlib_compress;
+  int set_encoding;
+} VNC_ClientData;
+
+/* Input received on the server thread, waiting for VNC_PumpEvents */
+#define VNC_EVENTQ_SIZE 256
+
+enum {
+  VNC_EVENT_KEY,
+  VNC_EVENT_POINTER,
+  VNC_EVENT_QUIT
+};
+
+typedef struct VNC_Event {
+  int type;
+  int down;
+  Uint32 key;
+  int buttonmask;
+  int x, y;
+} VNC_Event;
+
 /* Private display data */
 struct SDL_PrivateVideoData {
   SDL_Rect *SDL_modelist[SDL_NUMMODES+1];
+  SDL_mutex *mutex;
 
+  void *frames;
   void *buffer;
   int buffer_size;
   int w, h;
+  int pitch;
+  int bytes_per_pixel;
+
+  /* Copy of what was last marked as modified, for diffing */
+  void *shadow;
+  int diff;
+
+  /* SDL_DOUBLEBUF: the frame the server is sending from */
+  void *front;
+  int frame_ms;
+  int flip_timeout;
+  Uint32 last_flip;
 
   int client_count;
   rfbScreenInfoPtr screen;
+  int quitting;
+
+  /* Threaded mode: libvncserver runs on its own threads and input is
+     queued here until the application pumps events */
+  int threaded;
+  rfbClientPtr *senders;
+  int num_senders, max_senders;
+  VNC_Event eventq[VNC_EVENTQ_SIZE];
+  int eventq_head, eventq_tail;
 
   int last_curx;
   int last_cury;
   int last_buttonmask;
 
+  int adaptive;
+
   unsigned keyframe_prev;
   int keyframe_delay;
 };
@@ -66,9 +143,12 @@ struct SDL_PrivateVideoData {
 #define VNC_palette		    (this->hidden->palette)
 #define VNC_buffer		    (this->hidden->buffer)
 #define VNC_buffer_size	    (this->hidden->buffer_size)
+#define VNC_shadow		    (this->hidden->shadow)
 
 #define VNC_w		    (this->hidden->w)
 #define VNC_h		    (this->hidden->h)
 
+#define VNC_mutex		    (this->hidden->mutex)
+
 #endif /* _SDL_vncvideo_h */
 
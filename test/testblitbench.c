@@ -0,0 +1,434 @@
+/*
+ * Headless benchmark of the software blitters.
+ *
+ * Runs every combination of source format, destination format and blit
+ *  mode (copy, colorkey, per-surface alpha, per-pixel alpha, RLE) that
+ *  SDL_CalculateBlit() can pick a different blitter for, and reports the
+ *  throughput of each in megapixels per second.  No video mode is set, so
+ *  this runs anywhere, and --csv output can be diffed between builds.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+typedef struct
+{
+    const char *name;
+    int bpp;
+    Uint32 rmask;
+    Uint32 gmask;
+    Uint32 bmask;
+    Uint32 amask;
+} BenchFormat;
+
+static const BenchFormat formats[] =
+{
+    { "INDEX8",    8, 0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { "RGB555",   15, 0x00007C00, 0x000003E0, 0x0000001F, 0x00000000 },
+    { "RGB565",   16, 0x0000F800, 0x000007E0, 0x0000001F, 0x00000000 },
+    { "BGR565",   16, 0x0000001F, 0x000007E0, 0x0000F800, 0x00000000 },
+    { "ARGB4444", 16, 0x00000F00, 0x000000F0, 0x0000000F, 0x0000F000 },
+    { "RGB888",   24, 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 },
+    { "BGR888",   24, 0x000000FF, 0x0000FF00, 0x00FF0000, 0x00000000 },
+    { "XRGB8888", 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 },
+    { "XBGR8888", 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0x00000000 },
+    { "ARGB8888", 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 },
+    { "ABGR8888", 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000 },
+    { "RGBA8888", 32, 0xFF000000, 0x00FF0000, 0x0000FF00, 0x000000FF },
+};
+
+/* Source surface setup for each mode; see setup_mode(). */
+typedef enum
+{
+    MODE_COPY,
+    MODE_COLORKEY,
+    MODE_COLORKEY_RLE,
+    MODE_ALPHA,
+    MODE_ALPHA_128,
+    MODE_ALPHA_COLORKEY,
+    MODE_ALPHA_RLE,
+    MODE_PIXELALPHA,
+    MODE_PIXELALPHA_RLE,
+    MODE_MAX
+} BenchMode;
+
+static const char *modenames[MODE_MAX] =
+{
+    "copy",
+    "colorkey",
+    "colorkey-rle",
+    "alpha",
+    "alpha128",
+    "alpha-colorkey",
+    "alpha-rle",
+    "pixelalpha",
+    "pixelalpha-rle",
+};
+
+static int benchWidth = 256;
+static int benchHeight = 256;
+static int benchMilliseconds = 100;
+static int csvOutput = 0;
+
+
+static void putpixel(SDL_Surface *surface, int x, int y, Uint32 pixel)
+{
+    Uint8 *p = (Uint8 *) surface->pixels + y * surface->pitch +
+               x * surface->format->BytesPerPixel;
+
+    switch (surface->format->BytesPerPixel)
+    {
+        case 1:
+            *p = (Uint8) pixel;
+            break;
+        case 2:
+            *(Uint16 *) p = (Uint16) pixel;
+            break;
+        case 3:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+            p[0] = (Uint8) (pixel >> 16);
+            p[1] = (Uint8) (pixel >> 8);
+            p[2] = (Uint8) pixel;
+#else
+            p[0] = (Uint8) pixel;
+            p[1] = (Uint8) (pixel >> 8);
+            p[2] = (Uint8) (pixel >> 16);
+#endif
+            break;
+        case 4:
+            *(Uint32 *) p = pixel;
+            break;
+    }
+}
+
+/*
+ * Fill a surface with 16x16 blocks that are, in turn, colorkeyed/fully
+ *  transparent, opaque, and two kinds of translucent gradient.  That gives
+ *  the RLE encoder and the alpha blitters' 0/255 shortcuts realistic runs.
+ */
+static void fill_pattern(SDL_Surface *surface)
+{
+    Uint32 key = SDL_MapRGB(surface->format, 255, 0, 255);
+    int x, y;
+
+    SDL_LockSurface(surface);
+    for (y = 0; y < surface->h; y++)
+    {
+        for (x = 0; x < surface->w; x++)
+        {
+            Uint8 r = (Uint8) (x * 255 / surface->w);
+            Uint8 g = (Uint8) (y * 255 / surface->h);
+            Uint8 b = (Uint8) (x ^ y);
+            Uint32 pixel;
+
+            switch (((x / 16) + (y / 16)) % 4)
+            {
+                case 0:
+                    pixel = key & ~surface->format->Amask;
+                    break;
+                case 1:
+                    pixel = SDL_MapRGBA(surface->format, r, g, b, 255);
+                    break;
+                case 2:
+                    pixel = SDL_MapRGBA(surface->format, r, g, b,
+                                        (Uint8) (x * 7 + y * 3));
+                    break;
+                default:
+                    pixel = SDL_MapRGBA(surface->format, r, g, b, 128);
+                    break;
+            }
+            putpixel(surface, x, y, pixel);
+        }
+    }
+    SDL_UnlockSurface(surface);
+}
+
+static SDL_Surface *create_surface(const BenchFormat *fmt)
+{
+    SDL_Surface *surface;
+
+    surface = SDL_CreateRGBSurface(SDL_SWSURFACE, benchWidth, benchHeight,
+                                   fmt->bpp, fmt->rmask, fmt->gmask,
+                                   fmt->bmask, fmt->amask);
+    if (surface == NULL)
+        return(NULL);
+
+    if (surface->format->palette)
+    {
+        SDL_Color colors[256];
+        int i;
+
+        /* 3-3-2 palette, so 8-bit colors come out roughly right. */
+        for (i = 0; i < 256; i++)
+        {
+            colors[i].r = (Uint8) ((i & 0xE0) | ((i & 0xE0) >> 3) | ((i & 0xC0) >> 6));
+            colors[i].g = (Uint8) (((i & 0x1C) << 3) | (i & 0x1C) | ((i & 0x18) >> 3));
+            colors[i].b = (Uint8) (((i & 0x03) << 6) | ((i & 0x03) << 4) | ((i & 0x03) << 2) | (i & 0x03));
+        }
+        SDL_SetColors(surface, colors, 0, 256);
+    }
+
+    return(surface);
+}
+
+/* Returns non-zero if this mode makes sense for the source format. */
+static int mode_applies(BenchMode mode, const BenchFormat *fmt)
+{
+    switch (mode)
+    {
+        case MODE_COPY:
+            return(1);
+        case MODE_PIXELALPHA:
+        case MODE_PIXELALPHA_RLE:
+            return(fmt->amask != 0);
+        case MODE_ALPHA:
+        case MODE_ALPHA_128:
+        case MODE_ALPHA_COLORKEY:
+        case MODE_ALPHA_RLE:
+            /* SDL ignores per-surface alpha on palettized sources. */
+            return((fmt->amask == 0) && (fmt->bpp > 8));
+        default:
+            return(fmt->amask == 0);
+    }
+}
+
+static void setup_mode(SDL_Surface *src, BenchMode mode)
+{
+    Uint32 key = SDL_MapRGB(src->format, 255, 0, 255);
+
+    SDL_SetColorKey(src, 0, 0);
+    SDL_SetAlpha(src, 0, SDL_ALPHA_OPAQUE);
+
+    switch (mode)
+    {
+        case MODE_COPY:
+            break;
+        case MODE_COLORKEY:
+            SDL_SetColorKey(src, SDL_SRCCOLORKEY, key);
+            break;
+        case MODE_COLORKEY_RLE:
+            SDL_SetColorKey(src, SDL_SRCCOLORKEY | SDL_RLEACCEL, key);
+            break;
+        case MODE_ALPHA:
+            SDL_SetAlpha(src, SDL_SRCALPHA, 200);
+            break;
+        case MODE_ALPHA_128:
+            SDL_SetAlpha(src, SDL_SRCALPHA, 128);
+            break;
+        case MODE_ALPHA_COLORKEY:
+            SDL_SetColorKey(src, SDL_SRCCOLORKEY, key);
+            SDL_SetAlpha(src, SDL_SRCALPHA, 200);
+            break;
+        case MODE_ALPHA_RLE:
+            SDL_SetColorKey(src, SDL_SRCCOLORKEY | SDL_RLEACCEL, key);
+            SDL_SetAlpha(src, SDL_SRCALPHA | SDL_RLEACCEL, 200);
+            break;
+        case MODE_PIXELALPHA:
+            SDL_SetAlpha(src, SDL_SRCALPHA, SDL_ALPHA_OPAQUE);
+            break;
+        case MODE_PIXELALPHA_RLE:
+            SDL_SetAlpha(src, SDL_SRCALPHA | SDL_RLEACCEL, SDL_ALPHA_OPAQUE);
+            break;
+        default:
+            break;
+    }
+}
+
+static int run_case(const BenchFormat *srcfmt, const BenchFormat *dstfmt,
+                    BenchMode mode)
+{
+    SDL_Surface *src = create_surface(srcfmt);
+    SDL_Surface *dst = create_surface(dstfmt);
+    Uint32 iterations = 0;
+    Uint32 start, now;
+    double mpixels;
+
+    if ((src == NULL) || (dst == NULL))
+    {
+        fprintf(stderr, "surface creation failed: %s\n", SDL_GetError());
+        SDL_FreeSurface(src);
+        SDL_FreeSurface(dst);
+        return(0);
+    }
+
+    fill_pattern(src);
+    fill_pattern(dst);
+    setup_mode(src, mode);
+
+    /* The first blit builds the blit map and any RLE encoding; keep it
+       out of the measurement. */
+    if (SDL_BlitSurface(src, NULL, dst, NULL) < 0)
+    {
+        fprintf(stderr, "%s -> %s (%s) failed: %s\n", srcfmt->name,
+                dstfmt->name, modenames[mode], SDL_GetError());
+        SDL_FreeSurface(src);
+        SDL_FreeSurface(dst);
+        return(0);
+    }
+
+    start = SDL_GetTicks();
+    do
+    {
+        SDL_BlitSurface(src, NULL, dst, NULL);
+        iterations++;
+        now = SDL_GetTicks();
+    } while ((now - start) < (Uint32) benchMilliseconds);
+
+    mpixels = ((double) iterations * benchWidth * benchHeight) /
+              ((double) (now - start) * 1000.0);
+
+    if (csvOutput)
+    {
+        printf("%s,%s,%s,%d,%d,%u,%u,%.2f\n", srcfmt->name, dstfmt->name,
+               modenames[mode], benchWidth, benchHeight,
+               (unsigned int) iterations, (unsigned int) (now - start),
+               mpixels);
+    }
+    else
+    {
+        printf("%-9s -> %-9s %-15s %10.2f Mpixels/s\n", srcfmt->name,
+               dstfmt->name, modenames[mode], mpixels);
+    }
+    fflush(stdout);
+
+    SDL_FreeSurface(src);
+    SDL_FreeSurface(dst);
+    return(1);
+}
+
+static void output_cpu_features(void)
+{
+    const char *disabled = getenv("SDL_CPU_DISABLE");
+
+    printf("%sCPU features:%s%s%s%s%s%s%s%s%s%s\n", csvOutput ? "# " : "",
+           SDL_HasMMX() ? " MMX" : "",
+           SDL_HasMMXExt() ? " MMXExt" : "",
+           SDL_Has3DNow() ? " 3DNow" : "",
+           SDL_Has3DNowExt() ? " 3DNowExt" : "",
+           SDL_HasSSE() ? " SSE" : "",
+           SDL_HasSSE2() ? " SSE2" : "",
+           SDL_HasSSSE3() ? " SSSE3" : "",
+           SDL_HasAltiVec() ? " AltiVec" : "",
+           SDL_HasAVX2() ? " AVX2" : "",
+           (disabled && *disabled) ? " (some disabled by SDL_CPU_DISABLE)" : "");
+}
+
+static int match(const char *filter, const char *name)
+{
+    return((filter == NULL) || (strcmp(filter, name) == 0));
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [--csv] [--ms N] [--width N] [--height N]\n"
+        "       [--src FORMAT] [--dst FORMAT] [--mode MODE] [--disable CPUFEATURES]\n"
+        "       [--threads N]\n"
+        "\n"
+        "--disable takes a comma separated list such as \"sse2,mmx\" or \"all\",\n"
+        "and is the same as setting SDL_CPU_DISABLE in the environment.\n"
+        "--threads is the same as setting SDL_VIDEO_BLIT_THREADS.\n",
+        argv0);
+}
+
+int main(int argc, char **argv)
+{
+    static char disableenv[256];
+    static char threadsenv[64];
+    const char *srcfilter = NULL;
+    const char *dstfilter = NULL;
+    const char *modefilter = NULL;
+    int failures = 0;
+    int cases = 0;
+    int s, d, m;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+
+        if (strcmp(arg, "--csv") == 0)
+            csvOutput = 1;
+        else if ((strcmp(arg, "--ms") == 0) && (i + 1 < argc))
+            benchMilliseconds = atoi(argv[++i]);
+        else if ((strcmp(arg, "--width") == 0) && (i + 1 < argc))
+            benchWidth = atoi(argv[++i]);
+        else if ((strcmp(arg, "--height") == 0) && (i + 1 < argc))
+            benchHeight = atoi(argv[++i]);
+        else if ((strcmp(arg, "--src") == 0) && (i + 1 < argc))
+            srcfilter = argv[++i];
+        else if ((strcmp(arg, "--dst") == 0) && (i + 1 < argc))
+            dstfilter = argv[++i];
+        else if ((strcmp(arg, "--mode") == 0) && (i + 1 < argc))
+            modefilter = argv[++i];
+        else if ((strcmp(arg, "--disable") == 0) && (i + 1 < argc))
+        {
+            /* Must be in place before SDL first looks at the CPU. */
+            SDL_snprintf(disableenv, sizeof (disableenv),
+                         "SDL_CPU_DISABLE=%s", argv[++i]);
+            SDL_putenv(disableenv);
+        }
+        else if ((strcmp(arg, "--threads") == 0) && (i + 1 < argc))
+        {
+            SDL_snprintf(threadsenv, sizeof (threadsenv),
+                         "SDL_VIDEO_BLIT_THREADS=%s", argv[++i]);
+            SDL_putenv(threadsenv);
+        }
+        else
+        {
+            usage(argv[0]);
+            return(1);
+        }
+    }
+
+    if ((benchWidth <= 0) || (benchHeight <= 0) || (benchMilliseconds <= 0))
+    {
+        usage(argv[0]);
+        return(1);
+    }
+
+    if (SDL_Init(SDL_INIT_NOPARACHUTE) == -1)
+    {
+        fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+        return(1);
+    }
+
+    output_cpu_features();
+    if (csvOutput)
+        printf("src,dst,mode,width,height,blits,ms,mpixels_per_sec\n");
+
+    for (s = 0; s < (int) SDL_arraysize(formats); s++)
+    {
+        if (!match(srcfilter, formats[s].name))
+            continue;
+        for (d = 0; d < (int) SDL_arraysize(formats); d++)
+        {
+            if (!match(dstfilter, formats[d].name))
+                continue;
+            for (m = 0; m < MODE_MAX; m++)
+            {
+                if (!match(modefilter, modenames[m]))
+                    continue;
+                if (!mode_applies((BenchMode) m, &formats[s]))
+                    continue;
+                cases++;
+                if (!run_case(&formats[s], &formats[d], (BenchMode) m))
+                    failures++;
+            }
+        }
+    }
+
+    SDL_Quit();
+
+    if (cases == 0)
+    {
+        fprintf(stderr, "No format/mode combination matched.\n");
+        return(1);
+    }
+    return(failures ? 1 : 0);
+}
+
+/* end of testblitbench.c ... */
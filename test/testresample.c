@@ -0,0 +1,253 @@
+/*
+ * Checks that audio resampled by the audio thread, a buffer at a time,
+ *  comes out the same as resampling all of it at once.
+ *
+ * The "disk" audio driver is made to write at another rate than the
+ *  callback gives, so the audio thread resamples each buffer.  It keeps
+ *  the end of each buffer and the position in it for the next, so apart
+ *  from the frames still in the filter when the audio is closed, the
+ *  file has to match SDL_ConvertAudio() run over all the callback gave.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+#define OUTFILE     "testresample.raw"
+
+/* Run each stream until the callback has given this many frames */
+#define FRAMES      20000
+
+typedef struct
+{
+    int src_rate;
+    int dst_rate;
+    Uint16 format;
+    Uint8 channels;
+} TestCase;
+
+static const TestCase cases[] =
+{
+    { 44100, 48000, AUDIO_S16SYS, 2 },
+    { 48000, 44100, AUDIO_S16SYS, 1 },
+    { 22050, 32000, AUDIO_U8, 2 },
+    { 32000, 11025, AUDIO_S16SYS, 2 },
+};
+
+static const char *qualities[] =
+{
+    "low",
+    "medium",
+    "high",
+};
+
+static const TestCase *current;
+static volatile int frames_given;
+
+
+/* Sawtooths of a different period in each channel with some noise, and
+ *  well clear of silence so the start of the stream can be found */
+static int signal_sample(int n, int c)
+{
+    Uint32 noise = (Uint32) n * 1103515245u + 12345u;
+
+    return(6000 + ((n * (7 + 4 * c)) % 400) * 50 -
+           (int) ((noise >> 16) % 1000));
+}
+
+static void put_signal(Uint8 *buf, int first, int frames)
+{
+    int i, c;
+
+    for (i = 0; i < frames; i++)
+    {
+        for (c = 0; c < current->channels; c++)
+        {
+            int sample = signal_sample(first + i, c);
+
+            if (current->format == AUDIO_U8)
+            {
+                *buf++ = (Uint8) ((sample >> 8) + 128);
+            }
+            else
+            {
+                *(Sint16 *) buf = (Sint16) sample;
+                buf += 2;
+            }
+        }
+    }
+}
+
+static void SDLCALL fill_audio(void *udata, Uint8 *stream, int len)
+{
+    int frame = (current->format & 0xFF) / 8 * current->channels;
+
+    put_signal(stream, frames_given, len / frame);
+    frames_given += len / frame;
+}
+
+static Uint8 *read_file(const char *file, int *len)
+{
+    FILE *fp = fopen(file, "rb");
+    Uint8 *buf = NULL;
+    long size;
+
+    if (fp == NULL)
+        return(NULL);
+    if ((fseek(fp, 0, SEEK_END) == 0) && ((size = ftell(fp)) > 0) &&
+        (fseek(fp, 0, SEEK_SET) == 0))
+    {
+        buf = (Uint8 *) malloc(size);
+        if (buf && (fread(buf, 1, size, fp) != (size_t) size))
+        {
+            free(buf);
+            buf = NULL;
+        }
+        *len = (int) size;
+    }
+    fclose(fp);
+    return(buf);
+}
+
+static int test_stream(const TestCase *tc, const char *quality)
+{
+    static char freq_env[64];
+    static char quality_env[64];
+    SDL_AudioSpec spec;
+    SDL_AudioCVT cvt;
+    Uint8 silence = (tc->format == AUDIO_U8) ? 0x80 : 0x00;
+    int frame = (tc->format & 0xFF) / 8 * tc->channels;
+    Uint8 *streamed;
+    int len = 0;
+    int start, streamed_frames, whole_frames;
+    int i, bad;
+
+    printf("%d -> %d Hz, %s, %d channels, %s quality: ", tc->src_rate,
+           tc->dst_rate, (tc->format == AUDIO_U8) ? "U8" : "S16",
+           tc->channels, quality);
+
+    sprintf(freq_env, "SDL_DISKAUDIOFREQ=%d", tc->dst_rate);
+    SDL_putenv(freq_env);
+    sprintf(quality_env, "SDL_AUDIO_RESAMPLER=%s", quality);
+    SDL_putenv(quality_env);
+
+    /* Resample in buffers of 512 frames */
+    current = tc;
+    frames_given = 0;
+    memset(&spec, 0, sizeof(spec));
+    spec.freq = tc->src_rate;
+    spec.format = tc->format;
+    spec.channels = tc->channels;
+    spec.samples = 512;
+    spec.callback = fill_audio;
+    if (SDL_OpenAudio(&spec, NULL) < 0)
+    {
+        printf("%s\n", SDL_GetError());
+        return(0);
+    }
+    SDL_PauseAudio(0);
+    while (frames_given < FRAMES)
+        SDL_Delay(10);
+    SDL_CloseAudio();
+
+    streamed = read_file(OUTFILE, &len);
+    if (streamed == NULL)
+    {
+        printf("couldn't read %s\n", OUTFILE);
+        return(0);
+    }
+
+    /* Resample all of it at once */
+    if (SDL_BuildAudioCVT(&cvt, tc->format, tc->channels, tc->src_rate,
+                          tc->format, tc->channels, tc->dst_rate) < 0)
+    {
+        printf("%s\n", SDL_GetError());
+        free(streamed);
+        return(0);
+    }
+    cvt.len = frames_given * frame;
+    cvt.buf = (Uint8 *) malloc(cvt.len * cvt.len_mult);
+    if (cvt.buf == NULL)
+    {
+        printf("out of memory\n");
+        free(streamed);
+        return(0);
+    }
+    put_signal(cvt.buf, 0, frames_given);
+    SDL_ConvertAudio(&cvt);
+
+    /* The device plays silence until it's unpaused */
+    for (start = 0; start + frame <= len; start += frame)
+    {
+        for (i = 0; i < frame; i++)
+        {
+            if (streamed[start + i] != silence)
+                break;
+        }
+        if (i < frame)
+            break;
+    }
+    streamed_frames = (len - start) / frame;
+    whole_frames = cvt.len_cvt / frame;
+
+    bad = 0;
+    if ((streamed_frames < whole_frames / 2) ||
+        (streamed_frames > whole_frames))
+    {
+        printf("%d frames streamed for %d resampled at once\n",
+               streamed_frames, whole_frames);
+        bad = 1;
+    }
+    else
+    {
+        for (i = 0; i < streamed_frames; i++)
+        {
+            if (memcmp(streamed + start + i * frame, cvt.buf + i * frame,
+                       frame) != 0)
+            {
+                printf("frame %d of %d differs\n", i, streamed_frames);
+                bad = 1;
+                break;
+            }
+        }
+    }
+    if (!bad)
+        printf("%d frames match\n", streamed_frames);
+
+    free(cvt.buf);
+    free(streamed);
+    return(!bad);
+}
+
+int main(int argc, char **argv)
+{
+    int count = 0, failures = 0;
+    int t, q;
+
+    SDL_putenv("SDL_AUDIODRIVER=disk");
+    SDL_putenv("SDL_DISKAUDIOFILE=" OUTFILE);
+    SDL_putenv("SDL_DISKAUDIODELAY=0");
+
+    if (SDL_Init(SDL_INIT_NOPARACHUTE) == -1)
+    {
+        fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+        return(1);
+    }
+
+    for (t = 0; t < (int) SDL_arraysize(cases); t++)
+    {
+        for (q = 0; q < (int) SDL_arraysize(qualities); q++)
+        {
+            count++;
+            if (!test_stream(&cases[t], qualities[q]))
+                failures++;
+        }
+    }
+    printf("%d of %d streams match\n", count - failures, count);
+    remove(OUTFILE);
+
+    SDL_Quit();
+    return(failures ? 1 : 0);
+}
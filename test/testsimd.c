@@ -0,0 +1,728 @@
+/*
+ * Checks that the SIMD code paths draw the same pixels as the generic code.
+ *
+ * Every blit that testblitbench runs, SDL_FillRect() and SDL_FillRects(),
+ *  the filtered SDL_SoftStretch() and the software YUV overlays are drawn
+ *  once with SDL_CPU_DISABLE=all and again with each set of SIMD
+ *  extensions enabled, and a checksum of every result is compared.  SDL
+ *  only looks at the CPU once per process, so each set runs in a child
+ *  process: "testsimd --dump FILE" writes the checksums for the current
+ *  environment to FILE.  The generic code is also run split across blit
+ *  threads, which has to draw the same as running it on one thread.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+typedef struct
+{
+    const char *name;
+    int bpp;
+    Uint32 rmask;
+    Uint32 gmask;
+    Uint32 bmask;
+    Uint32 amask;
+} TestFormat;
+
+static const TestFormat formats[] =
+{
+    { "INDEX8",    8, 0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { "RGB555",   15, 0x00007C00, 0x000003E0, 0x0000001F, 0x00000000 },
+    { "RGB565",   16, 0x0000F800, 0x000007E0, 0x0000001F, 0x00000000 },
+    { "BGR565",   16, 0x0000001F, 0x000007E0, 0x0000F800, 0x00000000 },
+    { "ARGB4444", 16, 0x00000F00, 0x000000F0, 0x0000000F, 0x0000F000 },
+    { "RGB888",   24, 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 },
+    { "BGR888",   24, 0x000000FF, 0x0000FF00, 0x00FF0000, 0x00000000 },
+    { "XRGB8888", 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 },
+    { "XBGR8888", 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0x00000000 },
+    { "ARGB8888", 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 },
+    { "ABGR8888", 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000 },
+    { "RGBA8888", 32, 0xFF000000, 0x00FF0000, 0x0000FF00, 0x000000FF },
+    { "RGBX8888", 32, 0xFF000000, 0x00FF0000, 0x0000FF00, 0x00000000 },
+    { "BGRX8888", 32, 0x0000FF00, 0x00FF0000, 0xFF000000, 0x00000000 },
+};
+
+/* Source surface setup for each blit mode; see setup_mode(). */
+typedef enum
+{
+    MODE_COPY,
+    MODE_COLORKEY,
+    MODE_COLORKEY_RLE,
+    MODE_ALPHA,
+    MODE_ALPHA_128,
+    MODE_ALPHA_COLORKEY,
+    MODE_ALPHA_RLE,
+    MODE_PIXELALPHA,
+    MODE_PIXELALPHA_RLE,
+    MODE_MAX
+} BlitMode;
+
+static const char *modenames[MODE_MAX] =
+{
+    "copy",
+    "colorkey",
+    "colorkey-rle",
+    "alpha",
+    "alpha128",
+    "alpha-colorkey",
+    "alpha-rle",
+    "pixelalpha",
+    "pixelalpha-rle",
+};
+
+/*
+ * The CPU extensions compared against the generic code, each run adding
+ *  one more.  The older MMX, 3DNow! and AltiVec blitters round
+ *  differently from the C code, so they stay disabled throughout.
+ */
+#define LEGACY_DISABLE "mmx,mmxext,3dnow,3dnowext,sse,altivec"
+
+typedef struct
+{
+    const char *name;
+    const char *disable;
+    SDL_bool (SDLCALL *supported)(void);
+} TestRun;
+
+static const TestRun runs[] =
+{
+    { "SSE2",  LEGACY_DISABLE ",ssse3,avx2", SDL_HasSSE2 },
+    { "SSSE3", LEGACY_DISABLE ",avx2",       SDL_HasSSSE3 },
+    { "AVX2",  LEGACY_DISABLE,               SDL_HasAVX2 },
+};
+
+/* Odd sizes and offsets, so the SIMD loops have head and tail pixels */
+#define SRC_W   67
+#define SRC_H   37
+#define DST_W   83
+#define DST_H   45
+
+static FILE *dumpfile;
+
+
+static void putpixel(SDL_Surface *surface, int x, int y, Uint32 pixel)
+{
+    Uint8 *p = (Uint8 *) surface->pixels + y * surface->pitch +
+               x * surface->format->BytesPerPixel;
+
+    switch (surface->format->BytesPerPixel)
+    {
+        case 1:
+            *p = (Uint8) pixel;
+            break;
+        case 2:
+            *(Uint16 *) p = (Uint16) pixel;
+            break;
+        case 3:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+            p[0] = (Uint8) (pixel >> 16);
+            p[1] = (Uint8) (pixel >> 8);
+            p[2] = (Uint8) pixel;
+#else
+            p[0] = (Uint8) pixel;
+            p[1] = (Uint8) (pixel >> 8);
+            p[2] = (Uint8) (pixel >> 16);
+#endif
+            break;
+        case 4:
+            *(Uint32 *) p = pixel;
+            break;
+    }
+}
+
+/*
+ * Fill a surface with 8x8 blocks that are, in turn, colorkeyed/fully
+ *  transparent, opaque, and two kinds of translucent gradient.  'seed'
+ *  makes source and destination patterns differ.  The last kind also
+ *  sets any bits the format leaves unused, as other code may leave them.
+ */
+static void fill_pattern(SDL_Surface *surface, int seed)
+{
+    SDL_PixelFormat *fmt = surface->format;
+    Uint32 key = SDL_MapRGB(fmt, 255, 0, 255);
+    Uint32 unused = 0;
+    int x, y;
+
+    if (fmt->BitsPerPixel > 8)
+    {
+        unused = ~(fmt->Rmask | fmt->Gmask | fmt->Bmask | fmt->Amask);
+        if (fmt->BytesPerPixel < 4)
+            unused &= (1u << (fmt->BytesPerPixel * 8)) - 1;
+    }
+
+    SDL_LockSurface(surface);
+    for (y = 0; y < surface->h; y++)
+    {
+        for (x = 0; x < surface->w; x++)
+        {
+            Uint8 r = (Uint8) (x * 255 / surface->w + seed);
+            Uint8 g = (Uint8) (y * 255 / surface->h);
+            Uint8 b = (Uint8) ((x ^ y) * 5 + seed * 3);
+            Uint32 pixel;
+
+            switch (((x / 8) + (y / 8) + seed) % 4)
+            {
+                case 0:
+                    pixel = key & ~surface->format->Amask;
+                    break;
+                case 1:
+                    pixel = SDL_MapRGBA(surface->format, r, g, b, 255);
+                    break;
+                case 2:
+                    pixel = SDL_MapRGBA(surface->format, r, g, b,
+                                        (Uint8) (x * 7 + y * 3));
+                    break;
+                default:
+                    pixel = SDL_MapRGBA(surface->format, r, g, b, 128) |
+                            unused;
+                    break;
+            }
+            putpixel(surface, x, y, pixel);
+        }
+    }
+    SDL_UnlockSurface(surface);
+}
+
+static SDL_Surface *create_surface(const TestFormat *fmt, int w, int h)
+{
+    SDL_Surface *surface;
+
+    surface = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, fmt->bpp,
+                                   fmt->rmask, fmt->gmask, fmt->bmask,
+                                   fmt->amask);
+    if (surface == NULL)
+        return(NULL);
+
+    if (surface->format->palette)
+    {
+        SDL_Color colors[256];
+        int i;
+
+        /* 3-3-2 palette, so 8-bit colors come out roughly right. */
+        for (i = 0; i < 256; i++)
+        {
+            colors[i].r = (Uint8) ((i & 0xE0) | ((i & 0xE0) >> 3) | ((i & 0xC0) >> 6));
+            colors[i].g = (Uint8) (((i & 0x1C) << 3) | (i & 0x1C) | ((i & 0x18) >> 3));
+            colors[i].b = (Uint8) (((i & 0x03) << 6) | ((i & 0x03) << 4) | ((i & 0x03) << 2) | (i & 0x03));
+        }
+        SDL_SetColors(surface, colors, 0, 256);
+    }
+
+    return(surface);
+}
+
+/* FNV-1a over the visible pixels, skipping any padding at the row ends */
+static Uint32 checksum(SDL_Surface *surface)
+{
+    Uint32 hash = 2166136261u;
+    int len = surface->w * surface->format->BytesPerPixel;
+    int x, y;
+
+    SDL_LockSurface(surface);
+    for (y = 0; y < surface->h; y++)
+    {
+        const Uint8 *p = (const Uint8 *) surface->pixels + y * surface->pitch;
+        for (x = 0; x < len; x++)
+        {
+            hash ^= p[x];
+            hash *= 16777619u;
+        }
+    }
+    SDL_UnlockSurface(surface);
+    return(hash);
+}
+
+static void dump(const char *name, SDL_Surface *surface)
+{
+    fprintf(dumpfile, "%s %08x\n", name, (unsigned int) checksum(surface));
+}
+
+/* Returns non-zero if this mode makes sense for the source format. */
+static int mode_applies(BlitMode mode, const TestFormat *fmt)
+{
+    switch (mode)
+    {
+        case MODE_COPY:
+            return(1);
+        case MODE_PIXELALPHA:
+        case MODE_PIXELALPHA_RLE:
+            return(fmt->amask != 0);
+        case MODE_ALPHA:
+        case MODE_ALPHA_128:
+        case MODE_ALPHA_COLORKEY:
+        case MODE_ALPHA_RLE:
+            /* SDL ignores per-surface alpha on palettized sources. */
+            return((fmt->amask == 0) && (fmt->bpp > 8));
+        default:
+            return(fmt->amask == 0);
+    }
+}
+
+static void setup_mode(SDL_Surface *src, BlitMode mode)
+{
+    Uint32 key = SDL_MapRGB(src->format, 255, 0, 255);
+
+    switch (mode)
+    {
+        case MODE_COPY:
+            break;
+        case MODE_COLORKEY:
+            SDL_SetColorKey(src, SDL_SRCCOLORKEY, key);
+            break;
+        case MODE_COLORKEY_RLE:
+            SDL_SetColorKey(src, SDL_SRCCOLORKEY | SDL_RLEACCEL, key);
+            break;
+        case MODE_ALPHA:
+            SDL_SetAlpha(src, SDL_SRCALPHA, 200);
+            break;
+        case MODE_ALPHA_128:
+            SDL_SetAlpha(src, SDL_SRCALPHA, 128);
+            break;
+        case MODE_ALPHA_COLORKEY:
+            SDL_SetColorKey(src, SDL_SRCCOLORKEY, key);
+            SDL_SetAlpha(src, SDL_SRCALPHA, 200);
+            break;
+        case MODE_ALPHA_RLE:
+            SDL_SetColorKey(src, SDL_SRCCOLORKEY | SDL_RLEACCEL, key);
+            SDL_SetAlpha(src, SDL_SRCALPHA | SDL_RLEACCEL, 200);
+            break;
+        case MODE_PIXELALPHA:
+            SDL_SetAlpha(src, SDL_SRCALPHA, SDL_ALPHA_OPAQUE);
+            break;
+        case MODE_PIXELALPHA_RLE:
+            SDL_SetAlpha(src, SDL_SRCALPHA | SDL_RLEACCEL, SDL_ALPHA_OPAQUE);
+            break;
+        default:
+            break;
+    }
+}
+
+/* Whole and clipped blits, at offsets that misalign source and target */
+static int test_blit(const TestFormat *srcfmt, const TestFormat *dstfmt,
+                     BlitMode mode)
+{
+    SDL_Surface *src = create_surface(srcfmt, SRC_W, SRC_H);
+    SDL_Surface *dst = create_surface(dstfmt, DST_W, DST_H);
+    SDL_Rect srcrect, dstrect;
+    char name[128];
+    int ok = 0;
+
+    if ((src != NULL) && (dst != NULL))
+    {
+        fill_pattern(src, 0);
+        fill_pattern(dst, 1);
+        setup_mode(src, mode);
+
+        dstrect.x = 3;
+        dstrect.y = 2;
+        ok = (SDL_BlitSurface(src, NULL, dst, &dstrect) == 0);
+
+        srcrect.x = 5;
+        srcrect.y = 3;
+        srcrect.w = 41;
+        srcrect.h = 29;
+        dstrect.x = DST_W - 30;
+        dstrect.y = DST_H - 20;
+        ok = ok && (SDL_BlitSurface(src, &srcrect, dst, &dstrect) == 0);
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "%s -> %s (%s) failed: %s\n", srcfmt->name,
+                dstfmt->name, modenames[mode], SDL_GetError());
+    }
+    else
+    {
+        SDL_snprintf(name, sizeof (name), "blit-%s-%s-%s", srcfmt->name,
+                     dstfmt->name, modenames[mode]);
+        dump(name, dst);
+    }
+
+    SDL_FreeSurface(src);
+    SDL_FreeSurface(dst);
+    return(ok);
+}
+
+static int test_fill(const TestFormat *fmt)
+{
+    static SDL_Rect rects[] =
+    {
+        { 0, 0, DST_W, DST_H },
+        { 1, 1, 1, 1 },
+        { 3, 2, 17, 5 },
+        { 7, 9, 64, 11 },
+        { 2, 30, 79, 3 },
+        { 40, 1, 5, 40 },
+    };
+    SDL_Surface *dst = create_surface(fmt, DST_W, DST_H);
+    SDL_Rect batch[SDL_arraysize(rects)];
+    char name[128];
+    int i, ok = 0;
+
+    if (dst != NULL)
+    {
+        ok = 1;
+        for (i = 0; i < (int) SDL_arraysize(rects); i++)
+        {
+            SDL_Rect r = rects[i];
+            Uint32 color = SDL_MapRGBA(dst->format, (Uint8) (i * 40),
+                                       (Uint8) (255 - i * 30),
+                                       (Uint8) (i * 77), (Uint8) (i * 50));
+            ok = ok && (SDL_FillRect(dst, &r, color) == 0);
+        }
+
+        /* The same rectangles moved along, filled in one batch */
+        for (i = 0; i < (int) SDL_arraysize(rects); i++)
+        {
+            batch[i] = rects[i];
+            batch[i].x += 1;
+            batch[i].y += 1;
+        }
+        ok = ok && (SDL_FillRects(dst, SDL_arraysize(batch) - 1, batch + 1,
+                                  SDL_MapRGB(dst->format, 10, 200, 90)) == 0);
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "fill %s failed: %s\n", fmt->name, SDL_GetError());
+    }
+    else
+    {
+        SDL_snprintf(name, sizeof (name), "fill-%s", fmt->name);
+        dump(name, dst);
+    }
+
+    SDL_FreeSurface(dst);
+    return(ok);
+}
+
+static int test_stretch(const TestFormat *srcfmt, const TestFormat *dstfmt,
+                        SDL_StretchFilter filter)
+{
+    static const char *filternames[] = { "nearest", "bilinear", "area" };
+    /* Up, down, and one way in each direction */
+    static SDL_Rect sizes[] =
+    {
+        { 1, 2, 81, 43 },
+        { 2, 1, 29, 17 },
+        { 0, 0, 23, 44 },
+        { 5, 3, 78, 9 },
+    };
+    SDL_Surface *src = create_surface(srcfmt, SRC_W, SRC_H);
+    SDL_Surface *dst = create_surface(dstfmt, DST_W, DST_H);
+    SDL_Rect srcrect, dstrect;
+    char name[128];
+    int i, ok = 1;
+
+    if ((src == NULL) || (dst == NULL))
+        ok = 0;
+
+    for (i = 0; ok && (i < (int) SDL_arraysize(sizes)); i++)
+    {
+        fill_pattern(src, i);
+        fill_pattern(dst, 1);
+        srcrect.x = 1;
+        srcrect.y = 2;
+        srcrect.w = SRC_W - 3;
+        srcrect.h = SRC_H - 2;
+        dstrect = sizes[i];
+        if (SDL_SoftStretchFiltered(src, &srcrect, dst, &dstrect, filter) < 0)
+        {
+            ok = 0;
+            break;
+        }
+        SDL_snprintf(name, sizeof (name), "stretch-%s-%s-%s-%dx%d",
+                     srcfmt->name, dstfmt->name, filternames[filter],
+                     dstrect.w, dstrect.h);
+        dump(name, dst);
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "stretch %s -> %s (%s) failed: %s\n", srcfmt->name,
+                dstfmt->name, filternames[filter], SDL_GetError());
+    }
+
+    SDL_FreeSurface(src);
+    SDL_FreeSurface(dst);
+    return(ok);
+}
+
+/*
+ * Display overlays of each format on a screen of each depth: unscaled,
+ *  doubled (the converters' own 2x paths) and scaled by odd amounts.
+ */
+static int test_yuv(void)
+{
+    static const struct
+    {
+        const char *name;
+        Uint32 format;
+    } yuvformats[] =
+    {
+        { "YV12", SDL_YV12_OVERLAY },
+        { "IYUV", SDL_IYUV_OVERLAY },
+        { "YUY2", SDL_YUY2_OVERLAY },
+        { "UYVY", SDL_UYVY_OVERLAY },
+        { "YVYU", SDL_YVYU_OVERLAY },
+    };
+    static const int depths[] = { 16, 24, 32 };
+    static const int widths[] = { 66, 70 };
+    static SDL_Rect places[] =
+    {
+        { 3, 2, 0, 0 },     /* unscaled */
+        { 5, 1, 0, 0 },     /* doubled */
+        { 0, 4, 101, 57 },
+        { 7, 3, 47, 25 },
+    };
+    SDL_Surface *screen;
+    SDL_Overlay *overlay;
+    char name[128];
+    int f, d, w, p, x, y, i;
+    int failures = 0;
+
+    for (d = 0; d < (int) SDL_arraysize(depths); d++)
+    {
+        screen = SDL_SetVideoMode(320, 240, depths[d], SDL_SWSURFACE);
+        if (screen == NULL)
+        {
+            fprintf(stderr, "Couldn't set %d bpp video mode: %s\n",
+                    depths[d], SDL_GetError());
+            failures++;
+            continue;
+        }
+        for (f = 0; f < (int) SDL_arraysize(yuvformats); f++)
+        {
+            for (w = 0; w < (int) SDL_arraysize(widths); w++)
+            {
+                int ow = widths[w], oh = 38;
+
+                overlay = SDL_CreateYUVOverlay(ow, oh, yuvformats[f].format,
+                                               screen);
+                if (overlay == NULL)
+                {
+                    fprintf(stderr, "Couldn't create %s overlay: %s\n",
+                            yuvformats[f].name, SDL_GetError());
+                    failures++;
+                    continue;
+                }
+
+                SDL_LockYUVOverlay(overlay);
+                for (i = 0; i < overlay->planes; i++)
+                {
+                    int rows = (i == 0) ? oh : (oh + 1) / 2;
+                    for (y = 0; y < rows; y++)
+                    {
+                        Uint8 *row = overlay->pixels[i] + y * overlay->pitches[i];
+                        for (x = 0; x < overlay->pitches[i]; x++)
+                            row[x] = (Uint8) (x * 3 + y * 7 + i * 50 + (x ^ y));
+                    }
+                }
+                SDL_UnlockYUVOverlay(overlay);
+
+                for (p = 0; p < (int) SDL_arraysize(places); p++)
+                {
+                    SDL_Rect r = places[p];
+                    if (r.w == 0)
+                    {
+                        r.w = (Uint16) (p ? ow * 2 : ow);
+                        r.h = (Uint16) (p ? oh * 2 : oh);
+                    }
+                    SDL_FillRect(screen, NULL, 0);
+                    SDL_DisplayYUVOverlay(overlay, &r);
+                    SDL_snprintf(name, sizeof (name), "yuv-%s-%dx%d-%dbpp-%dx%d",
+                                 yuvformats[f].name, ow, oh, depths[d],
+                                 r.w, r.h);
+                    dump(name, screen);
+                }
+                SDL_FreeYUVOverlay(overlay);
+            }
+        }
+    }
+    return(failures == 0);
+}
+
+/* Run every test case, writing the checksums to 'file' */
+static int dump_all(const char *file)
+{
+    int failures = 0;
+    int s, d, m, f;
+
+    dumpfile = fopen(file, "w");
+    if (dumpfile == NULL)
+    {
+        fprintf(stderr, "Couldn't open %s\n", file);
+        return(1);
+    }
+
+    for (s = 0; s < (int) SDL_arraysize(formats); s++)
+    {
+        for (d = 0; d < (int) SDL_arraysize(formats); d++)
+        {
+            for (m = 0; m < MODE_MAX; m++)
+            {
+                if (!mode_applies((BlitMode) m, &formats[s]))
+                    continue;
+                if (!test_blit(&formats[s], &formats[d], (BlitMode) m))
+                    failures++;
+            }
+        }
+    }
+
+    for (s = 0; s < (int) SDL_arraysize(formats); s++)
+    {
+        if (!test_fill(&formats[s]))
+            failures++;
+    }
+
+    for (s = 0; s < (int) SDL_arraysize(formats); s++)
+    {
+        for (d = 0; d < (int) SDL_arraysize(formats); d++)
+        {
+            /* 8 bpp only stretches to the same palette */
+            if (((formats[s].bpp == 8) || (formats[d].bpp == 8)) && (s != d))
+                continue;
+            for (f = SDL_STRETCH_NEAREST; f <= SDL_STRETCH_AREA; f++)
+            {
+                if (!test_stretch(&formats[s], &formats[d],
+                                  (SDL_StretchFilter) f))
+                    failures++;
+            }
+        }
+    }
+
+    if (!test_yuv())
+        failures++;
+
+    fclose(dumpfile);
+    return(failures ? 1 : 0);
+}
+
+/* Run this program on the side with SDL_CPU_DISABLE set to 'disable' */
+static int run_child(const char *argv0, const char *disable, int threads,
+                     const char *file)
+{
+    static char disableenv[256];
+    static char threadsenv[64];
+    char command[1024];
+
+    SDL_snprintf(disableenv, sizeof (disableenv), "SDL_CPU_DISABLE=%s",
+                 disable);
+    SDL_putenv(disableenv);
+    SDL_snprintf(threadsenv, sizeof (threadsenv), "SDL_VIDEO_BLIT_THREADS=%d",
+                 threads);
+    SDL_putenv(threadsenv);
+    SDL_snprintf(command, sizeof (command), "\"%s\" --dump %s", argv0, file);
+    if (system(command) != 0)
+    {
+        fprintf(stderr, "%s failed\n", command);
+        return(0);
+    }
+    return(1);
+}
+
+/* Compare two dumps, reporting each case that differs */
+static int compare_dumps(const char *reffile, const char *file,
+                         const char *runname)
+{
+    FILE *ref = fopen(reffile, "r");
+    FILE *cmp = fopen(file, "r");
+    char refline[256], line[256];
+    int cases = 0, failures = 0;
+
+    if ((ref == NULL) || (cmp == NULL))
+    {
+        fprintf(stderr, "Couldn't read the results\n");
+        if (ref)
+            fclose(ref);
+        if (cmp)
+            fclose(cmp);
+        return(1);
+    }
+
+    while (fgets(refline, sizeof (refline), ref))
+    {
+        cases++;
+        if (!fgets(line, sizeof (line), cmp))
+        {
+            fprintf(stderr, "%s: results end early\n", runname);
+            failures++;
+            break;
+        }
+        if (strcmp(refline, line) != 0)
+        {
+            *strchr(refline, ' ') = '\0';
+            printf("%s: %s differs from the C code\n", runname, refline);
+            failures++;
+        }
+    }
+    fclose(ref);
+    fclose(cmp);
+
+    printf("%s: %d of %d cases match\n", runname, cases - failures, cases);
+    return(failures);
+}
+
+int main(int argc, char **argv)
+{
+    static const char *reffile = "testsimd-c.txt";
+    static const char *runfile = "testsimd-simd.txt";
+    int supported[SDL_arraysize(runs)];
+    int failures = 0;
+    int i;
+
+    /* Nothing is shown, so don't need a real display */
+    if (getenv("SDL_VIDEODRIVER") == NULL)
+        SDL_putenv("SDL_VIDEODRIVER=dummy");
+
+    if ((argc == 3) && (strcmp(argv[1], "--dump") == 0))
+    {
+        if (SDL_Init(SDL_INIT_VIDEO) == -1)
+        {
+            fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+            return(1);
+        }
+        failures = dump_all(argv[2]);
+        SDL_Quit();
+        return(failures);
+    }
+    if (argc != 1)
+    {
+        fprintf(stderr, "Usage: %s [--dump FILE]\n", argv[0]);
+        return(1);
+    }
+
+    /* Find out what this CPU has, before SDL_CPU_DISABLE is set */
+    for (i = 0; i < (int) SDL_arraysize(runs); i++)
+        supported[i] = runs[i].supported();
+
+    if (!run_child(argv[0], "all", 1, reffile))
+        return(1);
+
+    /* Split even the smallest cases when threaded, so that every
+       converter is run in bands */
+    SDL_putenv("SDL_VIDEO_BLIT_THREAD_PIXELS=1");
+    if (!run_child(argv[0], "all", 4, runfile))
+        failures++;
+    else
+        failures += compare_dumps(reffile, runfile, "Threads");
+
+    for (i = 0; i < (int) SDL_arraysize(runs); i++)
+    {
+        if (!supported[i])
+        {
+            printf("%s: not supported by this CPU\n", runs[i].name);
+            continue;
+        }
+        if (!run_child(argv[0], runs[i].disable, 1, runfile))
+            failures++;
+        else
+            failures += compare_dumps(reffile, runfile, runs[i].name);
+    }
+
+    remove(reffile);
+    remove(runfile);
+    return(failures ? 1 : 0);
+}
+
+/* end of testsimd.c ... */
@@ -0,0 +1,305 @@
+/*
+ * Checks the format converting path of the filtered SDL_SoftStretch().
+ *
+ * A stretch between two different formats expands each source pixel to
+ *  8-bit channels, filters those and packs the result into the
+ *  destination format.  So it has to come out the same as expanding the
+ *  source to ARGB8888 here, stretching that, and packing every pixel with
+ *  SDL_MapRGBA().  Same format stretches of 32-bit surfaces whose channels
+ *  aren't whole bytes take the converting path too, and are checked the
+ *  same way.  Last, an RLE accelerated source has to still be encoded
+ *  after it's stretched.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SDL.h"
+
+typedef struct
+{
+    const char *name;
+    int bpp;
+    Uint32 rmask;
+    Uint32 gmask;
+    Uint32 bmask;
+    Uint32 amask;
+} TestFormat;
+
+static const TestFormat formats[] =
+{
+    { "RGB555",      15, 0x00007C00, 0x000003E0, 0x0000001F, 0x00000000 },
+    { "RGB565",      16, 0x0000F800, 0x000007E0, 0x0000001F, 0x00000000 },
+    { "ARGB4444",    16, 0x00000F00, 0x000000F0, 0x0000000F, 0x0000F000 },
+    { "RGB888",      24, 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 },
+    { "BGR888",      24, 0x000000FF, 0x0000FF00, 0x00FF0000, 0x00000000 },
+    { "XRGB8888",    32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 },
+    { "ARGB8888",    32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 },
+    { "ABGR8888",    32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000 },
+    { "RGBA8888",    32, 0xFF000000, 0x00FF0000, 0x0000FF00, 0x000000FF },
+#define FIRST_PACKED32  9
+    /* 32-bit pixels that can't be filtered byte by byte */
+    { "RGB565in32",  32, 0x0000F800, 0x000007E0, 0x0000001F, 0x00000000 },
+    { "ARGB4444in32", 32, 0x00000F00, 0x000000F0, 0x0000000F, 0x0000F000 },
+};
+
+static const TestFormat argb8888 =
+    { "ARGB8888",    32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 };
+
+static const char *filternames[] =
+{
+    "nearest",
+    "bilinear",
+    "area",
+};
+
+#define SRC_W   37
+#define SRC_H   29
+
+/* Destination sizes: the same, bigger, smaller, and mixed */
+static const int sizes[][2] =
+{
+    { SRC_W, SRC_H },
+    { 83, 61 },
+    { 19, 13 },
+    { 50, 17 },
+};
+
+
+static Uint32 getpixel(SDL_Surface *surface, int x, int y)
+{
+    Uint8 *p = (Uint8 *) surface->pixels + y * surface->pitch +
+               x * surface->format->BytesPerPixel;
+
+    switch (surface->format->BytesPerPixel)
+    {
+        case 2:
+            return(*(Uint16 *) p);
+        case 3:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+            return((p[0] << 16) | (p[1] << 8) | p[2]);
+#else
+            return(p[0] | (p[1] << 8) | (p[2] << 16));
+#endif
+        case 4:
+            return(*(Uint32 *) p);
+    }
+    return(0);
+}
+
+static void putpixel(SDL_Surface *surface, int x, int y, Uint32 pixel)
+{
+    Uint8 *p = (Uint8 *) surface->pixels + y * surface->pitch +
+               x * surface->format->BytesPerPixel;
+
+    switch (surface->format->BytesPerPixel)
+    {
+        case 2:
+            *(Uint16 *) p = (Uint16) pixel;
+            break;
+        case 3:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+            p[0] = (Uint8) (pixel >> 16);
+            p[1] = (Uint8) (pixel >> 8);
+            p[2] = (Uint8) pixel;
+#else
+            p[0] = (Uint8) pixel;
+            p[1] = (Uint8) (pixel >> 8);
+            p[2] = (Uint8) (pixel >> 16);
+#endif
+            break;
+        case 4:
+            *(Uint32 *) p = pixel;
+            break;
+    }
+}
+
+static SDL_Surface *create_surface(const TestFormat *fmt, int w, int h)
+{
+    return(SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, fmt->bpp,
+                                fmt->rmask, fmt->gmask, fmt->bmask,
+                                fmt->amask));
+}
+
+/* Gradients with some noise, and alpha that varies too */
+static void fill_pattern(SDL_Surface *surface)
+{
+    int x, y;
+
+    for (y = 0; y < surface->h; y++)
+    {
+        for (x = 0; x < surface->w; x++)
+        {
+            Uint8 r = (Uint8) (x * 255 / surface->w);
+            Uint8 g = (Uint8) (y * 255 / surface->h);
+            Uint8 b = (Uint8) ((x * 31) ^ (y * 17));
+            Uint8 a = (Uint8) (x * 7 + y * 3);
+
+            putpixel(surface, x, y, SDL_MapRGBA(surface->format, r, g, b, a));
+        }
+    }
+}
+
+/*
+ * Expand a surface to ARGB8888 the way the stretch does: channels are
+ *  shifted up to 8 bits and a missing alpha channel is opaque.
+ */
+static SDL_Surface *expand_surface(SDL_Surface *src)
+{
+    SDL_PixelFormat *fmt = src->format;
+    SDL_Surface *dst = create_surface(&argb8888, src->w, src->h);
+    int x, y;
+
+    if (dst == NULL)
+        return(NULL);
+
+    for (y = 0; y < src->h; y++)
+    {
+        for (x = 0; x < src->w; x++)
+        {
+            Uint32 pixel = getpixel(src, x, y);
+            Uint32 r = ((pixel & fmt->Rmask) >> fmt->Rshift) << fmt->Rloss;
+            Uint32 g = ((pixel & fmt->Gmask) >> fmt->Gshift) << fmt->Gloss;
+            Uint32 b = ((pixel & fmt->Bmask) >> fmt->Bshift) << fmt->Bloss;
+            Uint32 a = fmt->Amask ?
+                       ((pixel & fmt->Amask) >> fmt->Ashift) << fmt->Aloss :
+                       0xFF;
+
+            putpixel(dst, x, y, (a << 24) | (r << 16) | (g << 8) | b);
+        }
+    }
+    return(dst);
+}
+
+static int test_stretch(const TestFormat *sfmt, const TestFormat *dfmt,
+                        SDL_StretchFilter filter, int dst_w, int dst_h)
+{
+    SDL_Surface *src = create_surface(sfmt, SRC_W, SRC_H);
+    SDL_Surface *dst = create_surface(dfmt, dst_w, dst_h);
+    SDL_Surface *wide = NULL;
+    SDL_Surface *ref = NULL;
+    int bad = 0;
+    int x, y;
+
+    if ((src == NULL) || (dst == NULL))
+        goto failed;
+    fill_pattern(src);
+
+    wide = expand_surface(src);
+    ref = create_surface(&argb8888, dst_w, dst_h);
+    if ((wide == NULL) || (ref == NULL))
+        goto failed;
+    if ((SDL_SoftStretchFiltered(src, NULL, dst, NULL, filter) < 0) ||
+        (SDL_SoftStretchFiltered(wide, NULL, ref, NULL, filter) < 0))
+        goto failed;
+
+    for (y = 0; y < dst_h; y++)
+    {
+        for (x = 0; x < dst_w; x++)
+        {
+            Uint32 pixel = getpixel(ref, x, y);
+            Uint32 expected = SDL_MapRGBA(dst->format,
+                                          (Uint8) (pixel >> 16),
+                                          (Uint8) (pixel >> 8),
+                                          (Uint8) pixel,
+                                          (Uint8) (pixel >> 24));
+
+            if (getpixel(dst, x, y) != expected)
+            {
+                if (!bad)
+                    printf("%s -> %s %s %dx%d: pixel %d,%d is 0x%08X,"
+                           " expected 0x%08X\n", sfmt->name, dfmt->name,
+                           filternames[filter], dst_w, dst_h, x, y,
+                           getpixel(dst, x, y), expected);
+                bad++;
+            }
+        }
+    }
+
+    SDL_FreeSurface(ref);
+    SDL_FreeSurface(wide);
+    SDL_FreeSurface(dst);
+    SDL_FreeSurface(src);
+    return(bad == 0);
+
+failed:
+    printf("%s -> %s %s %dx%d: %s\n", sfmt->name, dfmt->name,
+           filternames[filter], dst_w, dst_h, SDL_GetError());
+    SDL_FreeSurface(ref);
+    SDL_FreeSurface(wide);
+    SDL_FreeSurface(dst);
+    SDL_FreeSurface(src);
+    return(0);
+}
+
+/* Stretching an RLE accelerated source only reads it, so it stays encoded */
+static int test_rle_source(void)
+{
+    SDL_Surface *src = create_surface(&argb8888, SRC_W, SRC_H);
+    SDL_Surface *dst = create_surface(&argb8888, SRC_W * 2, SRC_H * 2);
+    int ok = 0;
+
+    if ((src == NULL) || (dst == NULL))
+        goto failed;
+    fill_pattern(src);
+    SDL_SetAlpha(src, SDL_SRCALPHA | SDL_RLEACCEL, SDL_ALPHA_OPAQUE);
+
+    if ((SDL_PrepareRLE(src, dst) < 0) ||
+        (SDL_SoftStretchFiltered(src, NULL, dst, NULL,
+                                 SDL_STRETCH_BILINEAR) < 0))
+        goto failed;
+    ok = (src->flags & SDL_RLEACCEL) != 0;
+    if (!ok)
+        printf("RLE source: not encoded after the stretch\n");
+
+    SDL_FreeSurface(dst);
+    SDL_FreeSurface(src);
+    return(ok);
+
+failed:
+    printf("RLE source: %s\n", SDL_GetError());
+    SDL_FreeSurface(dst);
+    SDL_FreeSurface(src);
+    return(0);
+}
+
+int main(int argc, char **argv)
+{
+    int cases = 0, failures = 0;
+    int s, d, f, i;
+
+    if (SDL_Init(SDL_INIT_NOPARACHUTE) == -1)
+    {
+        fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+        return(1);
+    }
+
+    for (s = 0; s < (int) SDL_arraysize(formats); s++)
+    {
+        for (d = 0; d < (int) SDL_arraysize(formats); d++)
+        {
+            /* Same format stretches of whole bytes aren't converted */
+            if ((s == d) && (s < FIRST_PACKED32))
+                continue;
+
+            for (f = SDL_STRETCH_NEAREST; f <= SDL_STRETCH_AREA; f++)
+            {
+                for (i = 0; i < (int) SDL_arraysize(sizes); i++)
+                {
+                    cases++;
+                    if (!test_stretch(&formats[s], &formats[d],
+                                      (SDL_StretchFilter) f,
+                                      sizes[i][0], sizes[i][1]))
+                        failures++;
+                }
+            }
+        }
+    }
+    cases++;
+    if (!test_rle_source())
+        failures++;
+    printf("%d of %d stretches match\n", cases - failures, cases);
+
+    SDL_Quit();
+    return(failures ? 1 : 0);
+}